@@ -0,0 +1,92 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Startup of the bare-metal build (CONFIG_USE_BARE_METAL) which runs the
+ * sketch without the Arduino core. Build and flash with avr-gcc, e.g.:
+ *
+ *   avr-g++ -mmcu=atmega32u4 -DF_CPU=16000000UL -Os -std=gnu++11 \
+ *     -fno-exceptions -fno-threadsafe-statics -ffunction-sections -fdata-sections \
+ *     -Wl,--gc-sections -x c++ rcmixarduino.ino -x none *.cpp -o rcmixarduino.elf
+ *   avr-objcopy -O ihex -R .eeprom rcmixarduino.elf rcmixarduino.hex
+ *   avrdude -p atmega32u4 -c avr109 -P /dev/ttyACM0 -U flash:w:rcmixarduino.hex
+ *
+ * Without the core the USB port is not enumerated, press the reset button
+ * to enter the bootloader for flashing.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "config.h"
+
+#ifdef CONFIG_USE_BARE_METAL
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+void setup();
+void loop();
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+int main()
+{
+  cli();
+
+  /* The bootloader leaves the USB controller and Timer 0 running - stop
+   * them so that no interrupts other than our own are enabled
+   */
+
+  UDIEN = 0;
+  UDCON = (1 << DETACH);
+  USBCON = (1 << FRZCLK);
+  PLLCSR = 0;
+
+  TIMSK0 = 0;
+  TCCR0B = 0;
+
+  /* The modules expect the interrupts to be enabled when setup() is
+   * called, as init() of the Arduino core does
+   */
+
+  sei();
+
+  setup();
+
+  for (;;)
+  {
+    loop();
+  }
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "boot.h"
+
+#include <avr/io.h>
+
+#include <util/atomic.h>
+
+#ifdef CONFIG_USE_FAST_BOOT
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+static uint8_t const TIMERSTEP_DURATION_US = 4;
+
+/* Overflows of timer 3 (262 ms each) after which the time in us does not
+ * fit into 32 bit anymore (about 71 min), later times are saturated
+ */
+
+static uint16_t const MAX_TIMER_OVERFLOWS = 0xFFFFFFFFUL / (0x10000UL * TIMERSTEP_DURATION_US);
+
+/************************************************************************/
+/* PRIVATE DATA                                                         */
+/************************************************************************/
+
+static volatile uint16_t BootTimerOverflows         = 0;
+static volatile uint32_t BootTimeToFirstPulseUs     = 0;
+static volatile uint32_t BootTimeToMixingUs         = 0;
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+/**
+ * \brief returns the time since the start of timer 3 in us (0xFFFFFFFF after
+ * about 71 min), has to be called with interrupts disabled
+ */
+uint32_t getBootTimeUs()
+{
+  uint16_t timer = TCNT3;
+  uint16_t overflows = BootTimerOverflows;
+
+  /* An overflow which has not been handled yet (we are within an isr or
+   * interrupts are disabled) has to be accounted for
+   */
+
+  if (TIFR3 & (1 << TOV3))
+  {
+    timer = TCNT3;
+    overflows++;
+  }
+
+  if (overflows > MAX_TIMER_OVERFLOWS)
+  {
+    return 0xFFFFFFFF;
+  }
+
+  return (((uint32_t) (overflows) << 16) | timer) * TIMERSTEP_DURATION_US;
+}
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+/**
+ * \brief called from the timer 3 overflow isr
+ */
+void Boot::onTimerOverflow()
+{
+  if (BootTimerOverflows <= MAX_TIMER_OVERFLOWS)
+  {
+    BootTimerOverflows++;
+  }
+}
+
+/**
+ * \brief called from the output isr at the start of an output frame, the first
+ * frame with at least one pulse is recorded
+ */
+void Boot::markFirstPulse()
+{
+  if (BootTimeToFirstPulseUs == 0)
+  {
+    BootTimeToFirstPulseUs = getBootTimeUs();
+  }
+}
+
+/**
+ * \brief called from the main loop after the mixing function has been executed,
+ * the first call is recorded
+ */
+void Boot::markMixing()
+{
+  if (BootTimeToMixingUs != 0)
+  {
+    return;
+  }
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    BootTimeToMixingUs = getBootTimeUs();
+  }
+}
+
+/**
+ * \brief returns the time until the first output pulse in us, 0 if no pulse has been output yet
+ */
+uint32_t Boot::getTimeToFirstPulseUs()
+{
+  uint32_t time_us;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    time_us = BootTimeToFirstPulseUs;
+  }
+
+  return time_us;
+}
+
+/**
+ * \brief returns the time until the first mixing pass in us, 0 if the mixer has not been active yet
+ */
+uint32_t Boot::getTimeToMixingUs()
+{
+  return BootTimeToMixingUs;
+}
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BOOT_H_
+#define BOOT_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+#ifdef CONFIG_USE_FAST_BOOT
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+/* Measures the boot milestones in us since RcIn::begin (= start of Timer 3,
+ * the first statement of setup). Timer 3 overflows are counted by the
+ * RcIn overflow isr, the measurement covers about 4.7 hours.
+ */
+
+class Boot
+{
+
+public:
+
+  /**
+   * \brief called from the timer 3 overflow isr
+   */
+  static void onTimerOverflow();
+
+  /**
+   * \brief called from the output isr at the start of an output frame, the first
+   * frame with at least one pulse is recorded
+   */
+  static void markFirstPulse();
+
+  /**
+   * \brief called from the main loop after the mixing function has been executed,
+   * the first call is recorded
+   */
+  static void markMixing();
+
+  /**
+   * \brief returns the time until the first output pulse in us, 0 if no pulse has been output yet
+   */
+  static uint32_t getTimeToFirstPulseUs();
+
+  /**
+   * \brief returns the time until the first mixing pass in us, 0 if the mixer has not been active yet
+   */
+  static uint32_t getTimeToMixingUs();
+
+private:
+
+  /**
+   * \brief no public constructing
+   */
+  Boot() { }
+};
+
+#endif
+
+#endif /* BOOT_H_ */
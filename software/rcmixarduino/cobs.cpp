@@ -0,0 +1,102 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "cobs.h"
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+/**
+ * \brief encode payload into frame including the 0x00 delimiter, frame has to hold
+ * payload_size + 2 bytes. Returns the size of the frame.
+ */
+uint8_t Cobs::encode(uint8_t const * payload, uint8_t const payload_size, uint8_t * frame)
+{
+  uint8_t code_index = 0;
+  uint8_t code = 1;
+  uint8_t size = 1;
+
+  for (uint8_t i = 0; i < payload_size; i++)
+  {
+    if (payload[i] == 0)
+    {
+      frame[code_index] = code;
+      code_index = size++;
+      code = 1;
+    }
+    else
+    {
+      frame[size++] = payload[i];
+      code++;
+    }
+  }
+
+  frame[code_index] = code;
+  frame[size++] = 0;
+
+  return size;
+}
+
+/**
+ * \brief decode a frame (without the 0x00 delimiter) into payload, payload has to hold
+ * frame_size bytes. Returns the size of the payload or 0 if the frame is invalid.
+ */
+uint8_t Cobs::decode(uint8_t const * frame, uint8_t const frame_size, uint8_t * payload)
+{
+  uint8_t size = 0;
+  uint8_t i = 0;
+
+  while (i < frame_size)
+  {
+    uint8_t const code = frame[i++];
+
+    if (code == 0 || (uint16_t) (i) + code - 1 > frame_size)
+    {
+      return 0;
+    }
+
+    for (uint8_t j = 1; j < code; j++)
+    {
+      if (frame[i] == 0)
+      {
+        return 0;
+      }
+      payload[size++] = frame[i++];
+    }
+
+    /* Every block but the last one is followed by a zero */
+
+    if (code < 0xFF && i < frame_size)
+    {
+      payload[size++] = 0;
+    }
+  }
+
+  return size;
+}
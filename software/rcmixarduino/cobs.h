@@ -0,0 +1,68 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef COBS_H_
+#define COBS_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+/* Consistent overhead byte stuffing - a frame never contains 0x00 except
+ * for the delimiter at its end. Used for all binary messages on the USB
+ * CDC port (telemetry, commands). Payloads are limited to 254 bytes.
+ */
+
+class Cobs
+{
+
+public:
+
+  /**
+   * \brief encode payload into frame including the 0x00 delimiter, frame has to hold
+   * payload_size + 2 bytes. Returns the size of the frame.
+   */
+  static uint8_t encode(uint8_t const * payload, uint8_t const payload_size, uint8_t * frame);
+
+  /**
+   * \brief decode a frame (without the 0x00 delimiter) into payload, payload has to hold
+   * frame_size bytes. Returns the size of the payload or 0 if the frame is invalid.
+   */
+  static uint8_t decode(uint8_t const * frame, uint8_t const frame_size, uint8_t * payload);
+
+private:
+
+  /**
+   * \brief no public constructing
+   */
+  Cobs() { }
+};
+
+#endif /* COBS_H_ */
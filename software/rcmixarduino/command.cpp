@@ -0,0 +1,760 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "command.h"
+
+#ifdef CONFIG_USE_COMMAND
+
+#include <Arduino.h>
+
+#include "cobs.h"
+
+#if defined(CONFIG_USE_PARAM)
+#include "param.h"
+#endif
+
+#if defined(CONFIG_USE_HOST_CONTROL)
+#include "hostlink.h"
+#endif
+
+#if defined(CONFIG_USE_FAST_BOOT)
+#include "boot.h"
+#endif
+
+#if defined(CONFIG_USE_LATENCY_INSTRUMENTATION)
+#include "latency.h"
+#endif
+
+#if defined(CONFIG_USE_WATCHDOG)
+#include "watchdog.h"
+#endif
+
+#if defined(CONFIG_USE_EVENT_LOG)
+#include "eventlog.h"
+#endif
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+#include "rcin.h"
+#endif
+
+#if defined(CONFIG_USE_CONTROL_BYTECODE)
+#include "control_bytecode.h"
+#endif
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+static uint8_t const MAX_REQUEST_FRAME_SIZE = 64;
+
+/* type + command + status + data + checksum */
+
+static uint8_t const MAX_RESPONSE_DATA_SIZE    = 32;
+static uint8_t const RESPONSE_HEADER_SIZE      = 3;
+static uint8_t const MAX_RESPONSE_PAYLOAD_SIZE = RESPONSE_HEADER_SIZE + MAX_RESPONSE_DATA_SIZE + 1;
+
+/* Code bytes per BYTECODE_WRITE request (command + offset + code + checksum
+ * plus the COBS overhead fit into MAX_REQUEST_FRAME_SIZE)
+ */
+
+static uint8_t const MAX_BYTECODE_CHUNK_SIZE = 32;
+
+/************************************************************************/
+/* PRIVATE DATA                                                         */
+/************************************************************************/
+
+static uint8_t CommandRequestFrame[MAX_REQUEST_FRAME_SIZE];
+static uint8_t CommandRequestFrameSize   = 0;
+static bool    CommandRequestIsOverflown = false;
+
+static uint8_t CommandResponseFrame[MAX_RESPONSE_PAYLOAD_SIZE + 2];
+static uint8_t CommandResponseFrameSize  = 0;
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+/**
+ * \brief read a 16 bit value in little endian byte order
+ */
+uint16_t getCommandWord(uint8_t const * ptr)
+{
+  return ptr[0] | ((uint16_t) (ptr[1]) << 8);
+}
+
+/**
+ * \brief append a 16 bit value in little endian byte order
+ */
+uint8_t * putCommandWord(uint8_t * ptr, uint16_t const value)
+{
+  *ptr++ = (uint8_t) (value);
+  *ptr++ = (uint8_t) (value >> 8);
+  return ptr;
+}
+
+/**
+ * \brief append a 32 bit value in little endian byte order
+ */
+uint8_t * putCommandLong(uint8_t * ptr, uint32_t const value)
+{
+  ptr = putCommandWord(ptr, (uint16_t) (value));
+  ptr = putCommandWord(ptr, (uint16_t) (value >> 16));
+  return ptr;
+}
+
+#if defined(CONFIG_USE_PARAM)
+
+/**
+ * \brief returns false for a parameter which has no effect in this configuration
+ * (see applyParameters in rcmixarduino.ino)
+ */
+#if defined(CONFIG_USE_CURVE)
+bool isCommandParamUsed(E_PARAM_SELECT const)
+{
+  return true;
+}
+#else
+bool isCommandParamUsed(E_PARAM_SELECT const sel)
+{
+  /* Without curves the mixers use their own deadzone and stick center */
+
+  if (sel == PARAM_DEADZONE_US)
+  {
+    return false;
+  }
+#if !defined(CONFIG_USE_JOYSTICK)
+  if (sel == PARAM_CENTER_US)
+  {
+    return false;
+  }
+#endif
+
+  return true;
+}
+#endif
+
+E_COMMAND_STATUS executeParamInfo(uint8_t const *, uint8_t const args_size, uint8_t * data, uint8_t & data_size)
+{
+  if (args_size != 0)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  data[0] = PARAM_STORE_LAYOUT_VERSION;
+  data[1] = NUM_PARAMS;
+  data[2] = Param::isSaving() ? 1 : 0;
+  data_size = 3;
+
+  return COMMAND_OK;
+}
+
+E_COMMAND_STATUS executeParamGet(uint8_t const * args, uint8_t const args_size, uint8_t * data, uint8_t & data_size)
+{
+  T_PARAM_INFO info;
+
+  if (args_size != 1)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+  if (!Param::getInfo(args[0], &info))
+  {
+    return COMMAND_ERROR_ID;
+  }
+
+  uint8_t * ptr = data;
+  *ptr++ = args[0];
+  ptr = putCommandWord(ptr, Param::getPending((E_PARAM_SELECT) (args[0])));
+  ptr = putCommandWord(ptr, info.min_value);
+  ptr = putCommandWord(ptr, info.max_value);
+  ptr = putCommandWord(ptr, info.default_value);
+  data_size = ptr - data;
+
+  return COMMAND_OK;
+}
+
+E_COMMAND_STATUS executeParamSet(uint8_t const * args, uint8_t const args_size, uint8_t * data, uint8_t & data_size)
+{
+  if (args_size != 3)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+  if (args[0] >= NUM_PARAMS || !isCommandParamUsed((E_PARAM_SELECT) (args[0])))
+  {
+    return COMMAND_ERROR_ID;
+  }
+
+  E_PARAM_SELECT const sel = (E_PARAM_SELECT) (args[0]);
+
+  if (!Param::set(sel, getCommandWord(args + 1)))
+  {
+    return COMMAND_ERROR_RANGE;
+  }
+
+  uint8_t * ptr = data;
+  *ptr++ = sel;
+  ptr = putCommandWord(ptr, Param::getPending(sel));
+  data_size = ptr - data;
+
+  return COMMAND_OK;
+}
+
+E_COMMAND_STATUS executeParamSave(uint8_t const *, uint8_t const args_size, uint8_t *, uint8_t &)
+{
+  if (args_size != 0)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  return Param::save() ? COMMAND_OK : COMMAND_ERROR_BUSY;
+}
+
+E_COMMAND_STATUS executeParamDefaults(uint8_t const *, uint8_t const args_size, uint8_t *, uint8_t &)
+{
+  if (args_size != 0)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  Param::restoreDefaults();
+
+  return COMMAND_OK;
+}
+
+#endif
+
+#if defined(CONFIG_USE_HOST_CONTROL)
+
+E_COMMAND_STATUS executeHostSet(uint8_t const command, uint8_t const * args, uint8_t const args_size,
+    uint8_t * data, uint8_t & data_size)
+{
+  uint8_t const num_channels = (command == COMMAND_HOST_INPUTS) ? 4 : 6;
+  uint16_t pulse_duration_us[6];
+
+  if (args_size != 2 + num_channels * 2)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  for (uint8_t i = 0; i < num_channels; i++)
+  {
+    pulse_duration_us[i] = getCommandWord(args + 2 + i * 2);
+  }
+
+  bool const is_valid = (command == COMMAND_HOST_INPUTS) ? HostLink::setInputs(args[1], pulse_duration_us) :
+      HostLink::setOutputs(args[1], pulse_duration_us);
+
+  if (!is_valid)
+  {
+    return COMMAND_ERROR_RANGE;
+  }
+
+  data[0] = args[0];
+  data[1] = HostLink::update();
+  data_size = 2;
+
+  return COMMAND_OK;
+}
+
+E_COMMAND_STATUS executeHostRelease(uint8_t const * args, uint8_t const args_size, uint8_t * data, uint8_t & data_size)
+{
+  if (args_size != 1)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  HostLink::release();
+
+  data[0] = args[0];
+  data[1] = HostLink::update();
+  data_size = 2;
+
+  return COMMAND_OK;
+}
+
+#endif
+
+#if defined(CONFIG_USE_FAST_BOOT)
+
+E_COMMAND_STATUS executeBootInfo(uint8_t const *, uint8_t const args_size, uint8_t * data, uint8_t & data_size)
+{
+  if (args_size != 0)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  uint8_t * ptr = data;
+  ptr = putCommandLong(ptr, Boot::getTimeToFirstPulseUs());
+  ptr = putCommandLong(ptr, Boot::getTimeToMixingUs());
+  data_size = ptr - data;
+
+  return COMMAND_OK;
+}
+
+#endif
+
+#if defined(CONFIG_USE_LATENCY_INSTRUMENTATION)
+
+E_COMMAND_STATUS executeLatencyGet(uint8_t const * args, uint8_t const args_size, uint8_t * data, uint8_t & data_size)
+{
+  T_LATENCY_STATS stats = { 0, 0, 0, 0, 0 };
+
+  if (args_size != 1)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+  if (args[0] > LATENCY_IN_TO_OUT6)
+  {
+    return COMMAND_ERROR_ID;
+  }
+
+  Latency::getStats((E_LATENCY_PATH) (args[0]), &stats);
+
+  uint8_t * ptr = data;
+  *ptr++ = args[0];
+  ptr = putCommandWord(ptr, stats.num_samples);
+  ptr = putCommandWord(ptr, stats.min_us);
+  ptr = putCommandWord(ptr, stats.avg_us);
+  ptr = putCommandWord(ptr, stats.max_us);
+  ptr = putCommandWord(ptr, stats.p99_us);
+  data_size = ptr - data;
+
+  return COMMAND_OK;
+}
+
+E_COMMAND_STATUS executeLatencyIsr(uint8_t const *, uint8_t const args_size, uint8_t * data, uint8_t & data_size)
+{
+  T_LATENCY_ISR_STATS stats = { 0, 0, 0, 0 };
+
+  if (args_size != 0)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  Latency::getIsrStats(&stats);
+
+  uint8_t * ptr = data;
+  ptr = putCommandWord(ptr, stats.num_samples);
+  ptr = putCommandWord(ptr, stats.min_ns);
+  ptr = putCommandWord(ptr, stats.avg_ns);
+  ptr = putCommandWord(ptr, stats.max_ns);
+  data_size = ptr - data;
+
+  return COMMAND_OK;
+}
+
+E_COMMAND_STATUS executeLatencyReset(uint8_t const *, uint8_t const args_size, uint8_t *, uint8_t &)
+{
+  if (args_size != 0)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  Latency::reset();
+
+  return COMMAND_OK;
+}
+
+#endif
+
+#if defined(CONFIG_USE_WATCHDOG)
+
+E_COMMAND_STATUS executeResetInfo(uint8_t const *, uint8_t const args_size, uint8_t * data, uint8_t & data_size)
+{
+  T_WATCHDOG_RESET_INFO info;
+
+  if (args_size != 0)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  Watchdog::getResetInfo(&info);
+
+  uint8_t * ptr = data;
+  *ptr++ = info.cause;
+  *ptr++ = info.was_mixing ? 1 : 0;
+  for (uint8_t i = 0; i < NUM_RESET_CAUSES; i++)
+  {
+    ptr = putCommandWord(ptr, info.count[i]);
+  }
+  data_size = ptr - data;
+
+  return COMMAND_OK;
+}
+
+#endif
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+
+E_COMMAND_STATUS executeDiversityInfo(uint8_t const *, uint8_t const args_size, uint8_t * data, uint8_t & data_size)
+{
+  T_RC_IN_DIVERSITY_INFO info;
+
+  if (args_size != 0)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  RcIn::getDiversityInfo(&info);
+
+  uint8_t * ptr = data;
+  *ptr++ = info.selected;
+  for (uint8_t source = RC_IN_SOURCE_A; source <= RC_IN_SOURCE_B; source++)
+  {
+    *ptr++ = info.is_good[source] ? 1 : 0;
+    *ptr++ = info.quality[source];
+  }
+  ptr = putCommandWord(ptr, info.num_switches);
+  data_size = ptr - data;
+
+  return COMMAND_OK;
+}
+
+#endif
+
+#if defined(CONFIG_USE_EVENT_LOG)
+
+E_COMMAND_STATUS executeEventLogRead(uint8_t const * args, uint8_t const args_size, uint8_t * data, uint8_t & data_size)
+{
+  T_EVENT_LOG_ENTRY entry;
+
+  if (args_size != 1)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  uint8_t const num_entries = EventLog::getNumEntries();
+
+  uint8_t * ptr = data;
+  *ptr++ = num_entries;
+
+  /* An empty log is not an error, the host learns the number of entries */
+
+  if (num_entries == 0 && args[0] == 0)
+  {
+    data_size = ptr - data;
+    return COMMAND_OK;
+  }
+
+  if (args[0] >= num_entries)
+  {
+    return COMMAND_ERROR_RANGE;
+  }
+
+  if (!EventLog::getEntry(args[0], &entry))
+  {
+    return COMMAND_ERROR_BUSY;
+  }
+
+  *ptr++ = entry.type;
+  *ptr++ = entry.channel;
+  *ptr++ = entry.value;
+  ptr = putCommandLong(ptr, entry.time_ms);
+  data_size = ptr - data;
+
+  return COMMAND_OK;
+}
+
+#endif
+
+#if defined(CONFIG_USE_CONTROL_BYTECODE)
+
+E_COMMAND_STATUS executeBytecodeWrite(uint8_t const * args, uint8_t const args_size, uint8_t *, uint8_t &)
+{
+  if (args_size < 2 || args_size > 1 + MAX_BYTECODE_CHUNK_SIZE)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  if (ControlBytecode::isStoring())
+  {
+    return COMMAND_ERROR_BUSY;
+  }
+
+  if (!ControlBytecode::write(args[0], args + 1, args_size - 1))
+  {
+    return COMMAND_ERROR_RANGE;
+  }
+
+  return COMMAND_OK;
+}
+
+E_COMMAND_STATUS executeBytecodeStore(uint8_t const * args, uint8_t const args_size, uint8_t * data, uint8_t & data_size)
+{
+  T_BYTECODE_INFO info = { 0, 0, 0 };
+
+  if (args_size != 1)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  if (ControlBytecode::isStoring())
+  {
+    return COMMAND_ERROR_BUSY;
+  }
+
+  if (args[0] > BYTECODE_MAX_PROGRAM_SIZE)
+  {
+    return COMMAND_ERROR_RANGE;
+  }
+
+  /* A program which fails the verification is no error of the request,
+   * the host learns the reason from the result
+   */
+
+  E_BYTECODE_RESULT const result = ControlBytecode::store(args[0], &info);
+
+  uint8_t * ptr = data;
+  *ptr++ = result;
+  *ptr++ = info.in_mask;
+  *ptr++ = info.out_mask;
+  ptr = putCommandWord(ptr, info.worst_case_cycles);
+  data_size = ptr - data;
+
+  return COMMAND_OK;
+}
+
+E_COMMAND_STATUS executeBytecodeInfo(uint8_t const *, uint8_t const args_size, uint8_t * data, uint8_t & data_size)
+{
+  if (args_size != 0)
+  {
+    return COMMAND_ERROR_LENGTH;
+  }
+
+  T_BYTECODE_INFO const info = ControlBytecode::getInfo();
+
+  uint8_t * ptr = data;
+  *ptr++ = ControlBytecode::isLoaded() ? 1 : 0;
+  *ptr++ = info.in_mask;
+  *ptr++ = info.out_mask;
+  ptr = putCommandWord(ptr, info.worst_case_cycles);
+  *ptr++ = ControlBytecode::isStoring() ? 1 : 0;
+  data_size = ptr - data;
+
+  return COMMAND_OK;
+}
+
+#endif
+
+/**
+ * \brief execute a request (command + arguments) and build the data of the response
+ */
+E_COMMAND_STATUS executeCommand(uint8_t const command, uint8_t const * args, uint8_t const args_size,
+    uint8_t * data, uint8_t & data_size)
+{
+  switch (command)
+  {
+#if defined(CONFIG_USE_PARAM)
+  case COMMAND_PARAM_INFO:     return executeParamInfo(args, args_size, data, data_size);
+  case COMMAND_PARAM_GET:      return executeParamGet(args, args_size, data, data_size);
+  case COMMAND_PARAM_SET:      return executeParamSet(args, args_size, data, data_size);
+  case COMMAND_PARAM_SAVE:     return executeParamSave(args, args_size, data, data_size);
+  case COMMAND_PARAM_DEFAULTS: return executeParamDefaults(args, args_size, data, data_size);
+#endif
+#if defined(CONFIG_USE_HOST_CONTROL)
+  case COMMAND_HOST_INPUTS:    return executeHostSet(command, args, args_size, data, data_size);
+  case COMMAND_HOST_OUTPUTS:   return executeHostSet(command, args, args_size, data, data_size);
+  case COMMAND_HOST_RELEASE:   return executeHostRelease(args, args_size, data, data_size);
+#endif
+#if defined(CONFIG_USE_FAST_BOOT)
+  case COMMAND_BOOT_INFO:      return executeBootInfo(args, args_size, data, data_size);
+#endif
+#if defined(CONFIG_USE_LATENCY_INSTRUMENTATION)
+  case COMMAND_LATENCY_GET:    return executeLatencyGet(args, args_size, data, data_size);
+  case COMMAND_LATENCY_ISR:    return executeLatencyIsr(args, args_size, data, data_size);
+  case COMMAND_LATENCY_RESET:  return executeLatencyReset(args, args_size, data, data_size);
+#endif
+#if defined(CONFIG_USE_WATCHDOG)
+  case COMMAND_RESET_INFO:     return executeResetInfo(args, args_size, data, data_size);
+#endif
+#if defined(CONFIG_USE_EVENT_LOG)
+  case COMMAND_EVENT_LOG_READ: return executeEventLogRead(args, args_size, data, data_size);
+#endif
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+  case COMMAND_DIVERSITY_INFO: return executeDiversityInfo(args, args_size, data, data_size);
+#endif
+#if defined(CONFIG_USE_CONTROL_BYTECODE)
+  case COMMAND_BYTECODE_WRITE: return executeBytecodeWrite(args, args_size, data, data_size);
+  case COMMAND_BYTECODE_STORE: return executeBytecodeStore(args, args_size, data, data_size);
+  case COMMAND_BYTECODE_INFO:  return executeBytecodeInfo(args, args_size, data, data_size);
+#endif
+  default:                     return COMMAND_ERROR_UNKNOWN;
+  }
+}
+
+/**
+ * \brief decode and execute the received request frame and encode its response
+ * into CommandResponseFrame
+ */
+void handleCommandRequest()
+{
+  uint8_t request[MAX_REQUEST_FRAME_SIZE];
+  uint8_t response[MAX_RESPONSE_PAYLOAD_SIZE];
+
+  uint8_t const request_size = Cobs::decode(CommandRequestFrame, CommandRequestFrameSize, request);
+
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < request_size; i++)
+  {
+    sum += request[i];
+  }
+
+  uint8_t data_size = 0;
+  E_COMMAND_STATUS status = COMMAND_ERROR_FRAME;
+
+  /* At least command and checksum */
+
+  if (request_size >= 2 && sum == 0)
+  {
+    status = executeCommand(request[0], request + 1, request_size - 2, response + RESPONSE_HEADER_SIZE, data_size);
+  }
+
+  if (status != COMMAND_OK)
+  {
+    data_size = 0;
+  }
+
+  response[0] = COMMAND_RESPONSE_TYPE;
+  response[1] = (request_size > 0) ? request[0] : 0;
+  response[2] = status;
+
+  uint8_t const payload_size = RESPONSE_HEADER_SIZE + data_size;
+
+  sum = 0;
+  for (uint8_t i = 0; i < payload_size; i++)
+  {
+    sum += response[i];
+  }
+  response[payload_size] = (uint8_t) (-sum);
+
+  CommandResponseFrameSize = Cobs::encode(response, payload_size + 1, CommandResponseFrame);
+}
+
+/**
+ * \brief send the pending response if it fits into the USB buffer, returns true if
+ * no response is pending anymore
+ */
+bool sendCommandResponse()
+{
+  if (CommandResponseFrameSize == 0)
+  {
+    return true;
+  }
+
+  if (Serial.availableForWrite() < CommandResponseFrameSize)
+  {
+    return false;
+  }
+
+  Serial.write(CommandResponseFrame, CommandResponseFrameSize);
+  CommandResponseFrameSize = 0;
+
+  return true;
+}
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+/**
+ * \brief initialize the Command module (USB CDC)
+ */
+void Command::begin()
+{
+  /* The baud rate has no meaning for USB CDC */
+  Serial.begin(115200);
+}
+
+/**
+ * \brief receive and execute requests and send their responses as far as the USB
+ * buffers allow, never waits - has to be called periodically from a low priority task
+ */
+void Command::process()
+{
+  /* Responses are discarded while no terminal is connected, Serial.write
+   * would block until a timeout otherwise
+   */
+
+  if (!Serial.dtr())
+  {
+    CommandResponseFrameSize = 0;
+    return;
+  }
+
+  /* A new request is only read after the response of the last one
+   * has been sent
+   */
+
+  if (!sendCommandResponse())
+  {
+    return;
+  }
+
+  while (Serial.available() > 0)
+  {
+    uint8_t const c = (uint8_t) (Serial.read());
+
+    if (c != 0)
+    {
+      if (CommandRequestFrameSize < MAX_REQUEST_FRAME_SIZE)
+      {
+        CommandRequestFrame[CommandRequestFrameSize++] = c;
+      }
+      else
+      {
+        CommandRequestIsOverflown = true;
+      }
+      continue;
+    }
+
+    /* Frame delimiter - a too long request is answered with a frame error */
+
+    bool const is_request_complete = (CommandRequestFrameSize > 0);
+
+    if (is_request_complete)
+    {
+      if (CommandRequestIsOverflown)
+      {
+        CommandRequestFrameSize = 0;
+      }
+
+      handleCommandRequest();
+    }
+
+    CommandRequestFrameSize = 0;
+    CommandRequestIsOverflown = false;
+
+    /* Continue with the next request only if the response has been sent */
+
+    if (is_request_complete && !sendCommandResponse())
+    {
+      return;
+    }
+  }
+}
+
+#endif
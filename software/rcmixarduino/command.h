@@ -0,0 +1,172 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef COMMAND_H_
+#define COMMAND_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+#ifdef CONFIG_USE_COMMAND
+
+/************************************************************************/
+/* PUBLIC TYPES                                                         */
+/************************************************************************/
+
+/* Requests and responses are sent as COBS encoded frames terminated by
+ * 0x00 on the USB CDC port (shared with the telemetry), all values are
+ * little endian:
+ *
+ *   request  [command] [arguments ...] [checksum]
+ *   response [type 0x02] [command] [status] [data ...] [checksum]
+ *
+ *   checksum chosen so that the sum of all bytes of the message is 0
+ *
+ * Commands (arguments -> response data):
+ *
+ *   PARAM_INFO     -                 -> [layout version] [number of parameters] [is saving]
+ *   PARAM_GET      [id]              -> [id] [value:2] [min:2] [max:2] [default:2]
+ *   PARAM_SET      [id] [value:2]    -> [id] [value:2]
+ *   PARAM_SAVE     -                 -> -
+ *   PARAM_DEFAULTS -                 -> -
+ *   HOST_INPUTS    [seq] [mask] [IN1..IN4 us:2 each]   -> [seq] [link state]
+ *   HOST_OUTPUTS   [seq] [mask] [OUT1..OUT6 us:2 each] -> [seq] [link state]
+ *   HOST_RELEASE   [seq]             -> [seq] [link state]
+ *   BOOT_INFO      -                 -> [time to first pulse us:4] [time to mixing us:4]
+ *   LATENCY_GET    [path]            -> [path] [samples:2] [min us:2] [avg us:2] [max us:2] [p99 us:2]
+ *   LATENCY_ISR    -                 -> [samples:2] [min ns:2] [avg ns:2] [max ns:2]
+ *   LATENCY_RESET  -                 -> -
+ *   RESET_INFO     -                 -> [last cause] [was mixing] [count per cause:2 each]
+ *   EVENT_LOG_READ [index]           -> [number of entries] [type] [channel] [value] [time ms:4]
+ *   DIVERSITY_INFO -                 -> [selected] [good A] [quality A] [good B] [quality B] [switches:2]
+ *   BYTECODE_WRITE [offset] [code ...] -> -
+ *   BYTECODE_STORE [size]            -> [result] [in mask] [out mask] [cycles:2]
+ *   BYTECODE_INFO  -                 -> [is loaded] [in mask] [out mask] [cycles:2] [is storing]
+ *
+ * PARAM_GET returns the value including changes which are not active
+ * yet, PARAM_SET is activated at the next output frame and PARAM_SAVE
+ * writes all parameters to the EEPROM in the background. PARAM_SET fails
+ * with ID for a parameter without effect in this configuration (deadzone
+ * and center without CONFIG_USE_CURVE).
+ *
+ * HOST_INPUTS and HOST_OUTPUTS hand the control to the host (see
+ * hostlink.h), mask selects the channels which are set. They have to be
+ * repeated within the link timeout. seq is returned unchanged so that the
+ * host can measure the round trip time.
+ *
+ * BOOT_INFO returns the boot times measured since the start of setup
+ * (see boot.h), 0 if the milestone has not been reached yet. The
+ * LATENCY commands read the statistics of latency.h, all values are 0
+ * if no samples have been recorded. RESET_INFO returns the cause of the
+ * last reset and the reset counters of watchdog.h. EVENT_LOG_READ returns
+ * an entry of the event log (see eventlog.h, index 0 = oldest), only the
+ * number of entries if the log is empty and index is 0. It fails with
+ * BUSY while the EEPROM is written. DIVERSITY_INFO returns the state of
+ * the two receivers (see RcIn::getDiversityInfo).
+ *
+ * BYTECODE_WRITE copies up to 32 bytes of a mixing program to the upload
+ * buffer (see control_bytecode.h). BYTECODE_STORE verifies the program
+ * and writes it to the EEPROM in the background, result is the
+ * E_BYTECODE_RESULT of the verification - nothing is written unless it
+ * is 0. Both fail with BUSY while the last program is written. The new
+ * program is loaded at the next reset, BYTECODE_INFO returns the loaded
+ * program.
+ *
+ * A new request is processed after the response of the last one has
+ * been sent. software/tools/rcmixcfg.py and hostctl.py implement the
+ * host side.
+ */
+
+static uint8_t const COMMAND_RESPONSE_TYPE = 0x02;
+
+typedef enum
+{
+  COMMAND_PARAM_INFO     = 0x10,
+  COMMAND_PARAM_GET      = 0x11,
+  COMMAND_PARAM_SET      = 0x12,
+  COMMAND_PARAM_SAVE     = 0x13,
+  COMMAND_PARAM_DEFAULTS = 0x14,
+  COMMAND_HOST_INPUTS    = 0x20,
+  COMMAND_HOST_OUTPUTS   = 0x21,
+  COMMAND_HOST_RELEASE   = 0x22,
+  COMMAND_BOOT_INFO      = 0x30,
+  COMMAND_LATENCY_GET    = 0x31,
+  COMMAND_LATENCY_ISR    = 0x32,
+  COMMAND_LATENCY_RESET  = 0x33,
+  COMMAND_RESET_INFO     = 0x34,
+  COMMAND_EVENT_LOG_READ = 0x35,
+  COMMAND_DIVERSITY_INFO = 0x36,
+  COMMAND_BYTECODE_WRITE = 0x40,
+  COMMAND_BYTECODE_STORE = 0x41,
+  COMMAND_BYTECODE_INFO  = 0x42
+} E_COMMAND;
+
+typedef enum
+{
+  COMMAND_OK              = 0,
+  COMMAND_ERROR_FRAME     = 1, /* COBS or checksum error */
+  COMMAND_ERROR_UNKNOWN   = 2,
+  COMMAND_ERROR_LENGTH    = 3,
+  COMMAND_ERROR_ID        = 4,
+  COMMAND_ERROR_RANGE     = 5,
+  COMMAND_ERROR_BUSY      = 6
+} E_COMMAND_STATUS;
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+class Command
+{
+
+public:
+
+  /**
+   * \brief initialize the Command module (USB CDC)
+   */
+  static void begin();
+
+  /**
+   * \brief receive and execute requests and send their responses as far as the USB
+   * buffers allow, never waits - has to be called periodically from a low priority task
+   */
+  static void process();
+
+private:
+
+  /**
+   * \brief no public constructing
+   */
+  Command() { }
+};
+
+#endif
+
+#endif /* COMMAND_H_ */
@@ -27,5 +27,166 @@
 
 //#define CONFIG_USE_CONTROL_DEMO
 #define CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS
+//#define CONFIG_USE_CONTROL_MECANUM_4_WHEELS
+//#define CONFIG_USE_CONTROL_DIFFERENTIAL
+//#define CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS_DSL
+
+/* Mixer which executes a user defined program stored in the EEPROM (see
+ * control_bytecode.h, assembled by software/tools/mixasm.py)
+ */
+
+//#define CONFIG_USE_CONTROL_BYTECODE
+
+/* Select one of several mixer profiles at runtime by the position of
+ * a switch channel (see ProfileControl) - takes precedence over
+ * CONFIG_USE_STATIC_CONTROL. The profiles are defined in rcmixarduino.ino,
+ * their gain is applied by the input curves (requires CONFIG_USE_CURVE).
+ */
+
+//#define CONFIG_USE_CONTROL_PROFILES
+#define CONFIG_CONTROL_PROFILE_SWITCH_CHANNEL (IN4)
+
+/* Fast deterministic boot: the outputs are in failsafe from reset and emit
+ * their failsafe preset (e.g. neutral for ESCs) within about 1 ms of
+ * setup(), an input is good after CONFIG_FAST_BOOT_ACQUIRE_PULSES
+ * consecutive valid pulses instead of after a full timer cycle (262 ms).
+ * The time to the first pulse and to mixing is measured (see boot.h).
+ */
+
+#define CONFIG_USE_FAST_BOOT
+#define CONFIG_FAST_BOOT_ACQUIRE_PULSES (3)
+
+/* Reset by the hardware watchdog if the control is not executed or the
+ * output isr stops. After a watchdog reset the outputs continue with their
+ * last pulses in failsafe, the reset causes are counted (see watchdog.h).
+ */
+
+#define CONFIG_USE_WATCHDOG
+
+/* Log failsafe and anomaly events (lost inputs, rejected pulses, resets)
+ * to a ring buffer in the EEPROM which is read over USB (see eventlog.h,
+ * requires CONFIG_USE_SCHEDULER)
+ */
+
+#define CONFIG_USE_EVENT_LOG
+
+/* Bind the mixer at compile time (StaticControl) instead of via function
+ * pointers at runtime (Control) - off until code size and cycle counts of
+ * both forms have been compared on the target
+ */
+
+//#define CONFIG_USE_STATIC_CONTROL
+
+/* Phase-lock the output frame to the input frame, the output pulses are
+ * started CONFIG_RCOUT_PHASE_LOCK_LEAD_US after an input frame is complete
+ */
+
+//#define CONFIG_USE_RCOUT_PHASE_LOCK
+#define CONFIG_RCOUT_PHASE_LOCK_LEAD_US (1000)
+
+/* Diversity of two receivers: receiver A on IN1/IN2, receiver B on
+ * IN3/IN4. The mixer reads IN1 and IN2, which deliver the healthier
+ * receiver and go to failsafe only when both receivers are lost (see
+ * rcin.h). Only for mixers with two inputs (e.g. differential), not with
+ * the profile switch or the bytecode mixer which may read IN3 and IN4.
+ */
+
+//#define CONFIG_USE_RC_IN_DIVERSITY
+
+/* Execute mixing and all other functionality via the cooperative
+ * scheduler (see scheduler.h) instead of calling control.execute()
+ * directly from the main loop
+ */
+
+#define CONFIG_USE_SCHEDULER
+
+/* Map the inputs through expo, dual rate or n-point curves with a
+ * smooth deadzone before mixing (see curve.h). This changes the response
+ * of the mixers, the deadzone of PARAM_DEADZONE_US replaces the fixed
+ * deadzone of the mixers.
+ */
+
+//#define CONFIG_USE_CURVE
+
+/* Put the cpu into idle sleep whenever no input event is pending and no
+ * task is due (requires CONFIG_USE_SCHEDULER)
+ */
+
+#define CONFIG_USE_IDLE_SLEEP
+
+/* Stream a telemetry record of every frame over USB CDC (see
+ * telemetry.h, requires CONFIG_USE_SCHEDULER)
+ */
+
+#define CONFIG_USE_TELEMETRY
+
+/* Enumerate as USB HID joystick in addition to the CDC port and report
+ * IN1 ... IN4 as axes as soon as a frame has been received (see
+ * joystick.h, requires CONFIG_USE_SCHEDULER)
+ */
+
+//#define CONFIG_USE_JOYSTICK
+
+/* Load tuning parameters (deadzone, stick center, valid input pulse
+ * range, output frame period, profile) from the EEPROM instead of using
+ * the compile time defaults (see param.h)
+ */
+
+#define CONFIG_USE_PARAM
+
+/* Accept requests on the USB CDC port, e.g. to read and change the
+ * parameters (see command.h, requires CONFIG_USE_SCHEDULER)
+ */
+
+#define CONFIG_USE_COMMAND
+
+/* Let a host computer override the mixer inputs or set the outputs
+ * directly over USB, with a link watchdog which falls back to rc control
+ * or failsafe (see hostlink.h, control_host.h, requires CONFIG_USE_COMMAND)
+ */
+
+//#define CONFIG_USE_HOST_CONTROL
+
+/* Record input to output latency histograms and the output isr jitter
+ * (see latency.h), light enough to stay enabled in production builds:
+ * the isrs only store a timestamp or update a histogram, the samples of
+ * a frame are taken at its start, at least 500 us before the first
+ * falling edge (see RcOut::setEndpoints)
+ */
+
+#define CONFIG_USE_LATENCY_INSTRUMENTATION
+
+/* Build with avr-gcc without the Arduino core (see baremetal.cpp) - own
+ * startup, no Timer 0 and USB interrupts which delay the input and output
+ * isrs. There is no USB port in this mode, the USB modules (telemetry,
+ * command, joystick, host control) have to be disabled.
+ */
+
+//#define CONFIG_USE_BARE_METAL
+
+#if defined(CONFIG_USE_BARE_METAL) && (defined(CONFIG_USE_TELEMETRY) || defined(CONFIG_USE_COMMAND) \
+    || defined(CONFIG_USE_JOYSTICK) || defined(CONFIG_USE_HOST_CONTROL))
+#error "CONFIG_USE_BARE_METAL: the USB modules require the Arduino core"
+#endif
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY) && (defined(CONFIG_USE_CONTROL_DEMO) || defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS) \
+    || defined(CONFIG_USE_CONTROL_MECANUM_4_WHEELS) || defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS_DSL) \
+    || defined(CONFIG_USE_CONTROL_PROFILES) || defined(CONFIG_USE_CONTROL_BYTECODE))
+#error "CONFIG_USE_RC_IN_DIVERSITY: IN3 and IN4 are the second receiver, the mixer may only use IN1 and IN2"
+#endif
+
+#if !defined(CONFIG_USE_SCHEDULER) && (defined(CONFIG_USE_EVENT_LOG) || defined(CONFIG_USE_TELEMETRY) \
+    || defined(CONFIG_USE_COMMAND) || defined(CONFIG_USE_JOYSTICK) || defined(CONFIG_USE_HOST_CONTROL) \
+    || defined(CONFIG_USE_IDLE_SLEEP))
+#error "CONFIG_USE_SCHEDULER: event log, telemetry, command, joystick, host control and idle sleep require the scheduler"
+#endif
+
+#if defined(CONFIG_USE_HOST_CONTROL) && !defined(CONFIG_USE_COMMAND)
+#error "CONFIG_USE_HOST_CONTROL: the host link is driven by the requests of CONFIG_USE_COMMAND"
+#endif
+
+#if defined(CONFIG_USE_CONTROL_PROFILES) && !defined(CONFIG_USE_CURVE)
+#error "CONFIG_USE_CONTROL_PROFILES: the gain of the profiles requires CONFIG_USE_CURVE"
+#endif
 
 #endif /* CONFIG_H_ */
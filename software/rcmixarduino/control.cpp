@@ -29,8 +29,65 @@
 #include "control.h"
 
 #include <util/delay.h>
+#include <util/atomic.h>
 
 #include "led.h"
+#include "rcout.h"
+#include "config.h"
+
+#if defined(CONFIG_USE_CURVE)
+#include "curve.h"
+#endif
+
+#if defined(CONFIG_USE_LATENCY_INSTRUMENTATION)
+#include "latency.h"
+#endif
+
+#if defined(CONFIG_USE_FAST_BOOT)
+#include "boot.h"
+#endif
+
+#if defined(CONFIG_USE_WATCHDOG)
+#include "watchdog.h"
+#endif
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+static uint16_t const MIN_SWITCH_PULSE_DURATION_US = 1000;
+static uint16_t const SWITCH_RANGE_US              = 1000;
+
+/* The switch channel has to move this far beyond the edge of a band
+ * before the profile is changed (avoids toggling at the edge)
+ */
+
+static uint16_t const SWITCH_HYSTERESIS_US = 25;
+
+/* Number of output frames within which the outputs are moved to the
+ * values of a new profile (200 ms)
+ */
+
+static uint8_t const PROFILE_TRANSFER_FRAMES = 10;
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS	                                                */
+/************************************************************************/
+
+/**
+ * \brief returns the profile selected by the pulse duration of the switch channel
+ */
+uint8_t getProfileForSwitchPosition(uint16_t const pulse_duration_us, uint8_t const num_profiles)
+{
+  if (pulse_duration_us <= MIN_SWITCH_PULSE_DURATION_US)
+  {
+    return 0;
+  }
+
+  uint16_t const profile = ((uint32_t) (pulse_duration_us - MIN_SWITCH_PULSE_DURATION_US) * num_profiles) / SWITCH_RANGE_US;
+
+  return (profile >= num_profiles) ? (num_profiles - 1) : profile;
+}
 
 /************************************************************************/
 /* PUBLIC FUNCTIONS	                                                    */
@@ -42,79 +99,74 @@
  */
 Control::Control(controlIsGoodFunc isGoodFunc, controlFailsafeFunc failsafeFunc, controlMixingFunc mixingFunc,
     controlOnTransitionToFailsafe transitionToFailsafeFunc, controlOnTransitionToMixing transitionToMixingFunc) :
-    _state(FAILSAFE), _isGoodFunc(isGoodFunc), _failsafeFunc(failsafeFunc), _mixingFunc(mixingFunc), _transitionToFailsafeFunc(
+    _isGoodFunc(isGoodFunc), _failsafeFunc(failsafeFunc), _mixingFunc(mixingFunc), _transitionToFailsafeFunc(
         transitionToFailsafeFunc), _transitionToMixingFunc(transitionToMixingFunc)
 {
 
 }
 
-/** 
- * \brief This function is executed in the main loop. Here we call the 
- * concrete failsafe and mixing functions and accomplish the state 
- * transition between those states.
+/**
+ * \brief The Constructor is handed over the profiles (which have to exist as
+ * long as the ProfileControl) and the channel which selects the profile.
  */
-void Control::execute()
+ProfileControl::ProfileControl(T_CONTROL_PROFILE const * profiles, uint8_t const num_profiles, E_RC_IN_SELECT const switch_channel) :
+    _profiles(profiles), _num_profiles(num_profiles), _switch_channel(switch_channel), _active_profile(0),
+    _fixed_profile(PROFILE_BY_SWITCH)
 {
-  switch (_state)
-  {
-  case FAILSAFE:
-  {
-    if (_failsafeFunc != 0)
-    {
-      _failsafeFunc();
-    }
-
-    /* Signal failsafe state */
 
-    toogleLed();
+}
 
-    _delay_ms(100);
+/**
+ * \brief signal the failsafe state (blink the led)
+ */
+void controlSignalFailsafe()
+{
+#if defined(CONFIG_USE_WATCHDOG)
+  Watchdog::feed(false);
+#endif
 
-    /* State handling */
+#if defined(CONFIG_USE_SCHEDULER)
+  /* The led is toggled by the led task of the scheduler - never block
+   * the scheduler here
+   */
 
-    if (isGood())
-    {
-      _state = MIXING;
+  Led::setState(LED_BLINK);
+#else
+  static bool is_led_turned_on = true;
 
-      if (_transitionToMixingFunc != 0)
-      {
-        _transitionToMixingFunc();
-      }
-    }
+  if (is_led_turned_on)
+  {
+    Led::setState(LED_ON);
   }
-    break;
-
-  case MIXING:
+  else
   {
-    if (_mixingFunc != 0)
-    {
-      _mixingFunc();
-    }
+    Led::setState(LED_OFF);
+  }
 
-    /* Signal active state */
+  is_led_turned_on = !is_led_turned_on;
 
-    turnLedOn();
+  _delay_ms(100);
+#endif
+}
 
-    /* State handling */
+/**
+ * \brief signal the mixing state after the mixing function has been executed
+ */
+void controlSignalMixing()
+{
+#if defined(CONFIG_USE_LATENCY_INSTRUMENTATION)
+  Latency::markMixComplete();
+#endif
 
-    if (!isGood())
-    {
-      _state = FAILSAFE;
+#if defined(CONFIG_USE_FAST_BOOT)
+  Boot::markMixing();
+#endif
 
-      if (_transitionToFailsafeFunc != 0)
-      {
-        _transitionToFailsafeFunc();
-      }
-    }
-  }
-    break;
+#if defined(CONFIG_USE_WATCHDOG)
+  Watchdog::feed(true);
+#endif
 
-  default:
-  {
-    _state = FAILSAFE;
-  }
-    break;
-  }
+  Led::setState(LED_ON);
 }
 
 /************************************************************************/
@@ -133,23 +185,147 @@ bool Control::isGood()
   }
 }
 
-void Control::toogleLed()
+void Control::failsafe()
 {
-  static bool is_led_turned_on = true;
+  if (_failsafeFunc != 0)
+  {
+    _failsafeFunc();
+  }
+}
 
-  if (is_led_turned_on)
+void Control::mixing()
+{
+  if (_mixingFunc != 0)
   {
-    Led::setState(LED_ON);
+    _mixingFunc();
+  }
+}
+
+void Control::transitionToFailsafe()
+{
+  if (_transitionToFailsafeFunc != 0)
+  {
+    _transitionToFailsafeFunc();
+  }
+}
+
+void Control::transitionToMixing()
+{
+  if (_transitionToMixingFunc != 0)
+  {
+    _transitionToMixingFunc();
+  }
+}
+
+/**
+ * \brief select the profile according to the switch channel, returns true if the profile has changed
+ */
+bool ProfileControl::selectProfile()
+{
+  if (_fixed_profile < _num_profiles)
+  {
+    if (_fixed_profile == _active_profile)
+    {
+      return false;
+    }
+
+    _active_profile = _fixed_profile;
+
+    applyProfileGain();
+
+    return true;
+  }
+
+  /* Keep the active profile if the switch channel is lost */
+
+  if (_num_profiles < 2 || !RcIn::isGood(_switch_channel))
+  {
+    return false;
+  }
+
+  uint16_t const pulse_duration_us = RcIn::getPulseDurationUs(_switch_channel);
+
+  uint16_t const lower_pulse_duration_us = (pulse_duration_us > SWITCH_HYSTERESIS_US) ? (pulse_duration_us - SWITCH_HYSTERESIS_US) : 0;
+
+  uint8_t const lower_profile = getProfileForSwitchPosition(lower_pulse_duration_us, _num_profiles);
+  uint8_t const upper_profile = getProfileForSwitchPosition(pulse_duration_us + SWITCH_HYSTERESIS_US, _num_profiles);
+
+  if (_active_profile >= lower_profile && _active_profile <= upper_profile)
+  {
+    return false;
+  }
+
+  _active_profile = getProfileForSwitchPosition(pulse_duration_us, _num_profiles);
+
+  applyProfileGain();
+
+  return true;
+}
+
+/**
+ * \brief apply the gain of the active profile to all inputs but the switch channel
+ */
+void ProfileControl::applyProfileGain()
+{
+#if defined(CONFIG_USE_CURVE)
+  for (uint8_t sel = IN1; sel <= IN4; sel++)
+  {
+    if (sel != _switch_channel)
+    {
+      Curve::setRate((E_RC_IN_SELECT) (sel), _profiles[_active_profile].rate_percent);
+    }
+  }
+#endif
+}
+
+bool ProfileControl::isGood()
+{
+  return _profiles[_active_profile].isGoodFunc();
+}
+
+void ProfileControl::failsafe()
+{
+  /* Outputs are in failsafe - the profile can be changed without transfer */
+
+  selectProfile();
+
+  _profiles[_active_profile].failsafeFunc();
+}
+
+void ProfileControl::mixing()
+{
+  uint8_t const previous_profile = _active_profile;
+
+  if (selectProfile())
+  {
+    /* Outputs which are not used by the new profile fall back to their
+     * failsafe policy. The outputs of the new profile are turned on again
+     * before the next frame can evaluate their state.
+     */
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      _profiles[previous_profile].transitionToFailsafeFunc();
+      _profiles[_active_profile].transitionToMixingFunc();
+    }
+    _profiles[_active_profile].mixingFunc();
+
+    RcOut::startBumplessTransfer(PROFILE_TRANSFER_FRAMES);
   }
   else
   {
-    Led::setState(LED_OFF);
+    _profiles[_active_profile].mixingFunc();
   }
+}
 
-  is_led_turned_on = !is_led_turned_on;
+void ProfileControl::transitionToFailsafe()
+{
+  _profiles[_active_profile].transitionToFailsafeFunc();
 }
 
-void Control::turnLedOn()
+void ProfileControl::transitionToMixing()
 {
-  Led::setState(LED_ON);
+  applyProfileGain();
+
+  _profiles[_active_profile].transitionToMixingFunc();
 }
@@ -29,8 +29,11 @@
 /* INCLUDES                                                             */
 /************************************************************************/
 
+#include <stdint.h>
 #include <stdbool.h>
 
+#include "rcin.h"
+
 /************************************************************************/
 /* PUBLIC TYPES                                                         */
 /************************************************************************/
@@ -41,28 +44,112 @@ typedef void (*controlMixingFunc)             (void); /* This function is execut
 typedef void (*controlOnTransitionToFailsafe) (void); /* This function is called on the transition from mixing to failsafe mode */
 typedef void (*controlOnTransitionToMixing)   (void); /* This function is called on the transition from failsafe to mixing mode */
 
+/* A mixer profile consists of the functions of a mixer and the gain of its
+ * inputs, see ProfileControl
+ */
+
+typedef struct
+{
+  controlIsGoodFunc             isGoodFunc;
+  controlFailsafeFunc           failsafeFunc;
+  controlMixingFunc             mixingFunc;
+  controlOnTransitionToFailsafe transitionToFailsafeFunc;
+  controlOnTransitionToMixing   transitionToMixingFunc;
+  uint8_t                       rate_percent;   /* Gain of the inputs (see Curve::setRate), only with CONFIG_USE_CURVE */
+} T_CONTROL_PROFILE;
+
 /************************************************************************/
 /* PUBLIC PROTOTYPES                                                    */
 /************************************************************************/
 
-class Control
+/**
+ * \brief signal the failsafe state (blink the led)
+ */
+void controlSignalFailsafe();
+
+/**
+ * \brief signal the mixing state after the mixing function has been executed
+ */
+void controlSignalMixing();
+
+/**
+ * \brief The state machine which switches between failsafe and mixing mode. It
+ * is implemented as CRTP base class - Derived provides isGood(), failsafe(),
+ * mixing(), transitionToFailsafe() and transitionToMixing() which are resolved
+ * at compile time and can therefore be inlined into execute().
+ */
+template <class Derived>
+class ControlStateMachine
 {
 
 public:
 
-  /**
-   * \brief The Constructor is handed over function pointers which point to the
-   * concrete implementation of the desired mixing functionality.
-   */
-  Control(controlIsGoodFunc isGoodFunc, controlFailsafeFunc failsafeFunc, controlMixingFunc mixingFunc,
-      controlOnTransitionToFailsafe transitionToFailsafeFunc, controlOnTransitionToMixing transitionToMixingFunc);
-
   /**
    * \brief This function is executed in the main loop. Here we call the
    * concrete failsafe and mixing functions and accomplish the state
    * transition between those states.
    */
-  void execute();
+  void execute()
+  {
+    Derived & derived = static_cast<Derived &>(*this);
+
+    switch (_state)
+    {
+    case FAILSAFE:
+    {
+      derived.failsafe();
+
+      /* Signal failsafe state */
+
+      controlSignalFailsafe();
+
+      /* State handling */
+
+      if (derived.isGood())
+      {
+        _state = MIXING;
+        derived.transitionToMixing();
+      }
+    }
+      break;
+
+    case MIXING:
+    {
+      derived.mixing();
+
+      /* Signal active state */
+
+      controlSignalMixing();
+
+      /* State handling */
+
+      if (!derived.isGood())
+      {
+        _state = FAILSAFE;
+        derived.transitionToFailsafe();
+      }
+    }
+      break;
+
+    default:
+    {
+      _state = FAILSAFE;
+    }
+      break;
+    }
+  }
+
+  /**
+   * \brief returns true if the control is in the mixing state
+   */
+  bool isMixing() const
+  {
+    return (_state == MIXING);
+  }
+
+protected:
+
+  ControlStateMachine() : _state(FAILSAFE) { }
 
 private:
 
@@ -70,6 +157,27 @@ private:
   {
     FAILSAFE, MIXING
   } _state;
+};
+
+/**
+ * \brief Control with the mixing functionality handed over as function pointers
+ * at runtime.
+ */
+class Control : public ControlStateMachine<Control>
+{
+
+  friend class ControlStateMachine<Control>;
+
+public:
+
+  /**
+   * \brief The Constructor is handed over function pointers which point to the
+   * concrete implementation of the desired mixing functionality.
+   */
+  Control(controlIsGoodFunc isGoodFunc, controlFailsafeFunc failsafeFunc, controlMixingFunc mixingFunc,
+      controlOnTransitionToFailsafe transitionToFailsafeFunc, controlOnTransitionToMixing transitionToMixingFunc);
+
+private:
 
   controlIsGoodFunc               _isGoodFunc;
   controlFailsafeFunc             _failsafeFunc;
@@ -78,8 +186,86 @@ private:
   controlOnTransitionToMixing     _transitionToMixingFunc;
 
   bool isGood();
-  void toogleLed();
-  void turnLedOn();
+  void failsafe();
+  void mixing();
+  void transitionToFailsafe();
+  void transitionToMixing();
+};
+
+/**
+ * \brief Control with several mixer profiles of which one is selected at runtime
+ * by the position of a switch channel. The range 1000 ... 2000 us of the switch
+ * channel is divided into num_profiles equal bands (e.g. a three position switch
+ * for three profiles). A new profile is active within the same pass, the outputs
+ * are moved to the values of the new profile without jump (bumpless transfer).
+ */
+class ProfileControl : public ControlStateMachine<ProfileControl>
+{
+
+  friend class ControlStateMachine<ProfileControl>;
+
+public:
+
+  /**
+   * \brief The Constructor is handed over the profiles (which have to exist as
+   * long as the ProfileControl) and the channel which selects the profile.
+   */
+  ProfileControl(T_CONTROL_PROFILE const * profiles, uint8_t const num_profiles, E_RC_IN_SELECT const switch_channel);
+
+  /**
+   * \brief returns the index of the active profile
+   */
+  uint8_t getActiveProfile() const { return _active_profile; }
+
+  /**
+   * \brief use the given profile regardless of the switch channel, a profile
+   * >= num_profiles (e.g. PROFILE_BY_SWITCH) selects it by the switch channel again
+   */
+  void setFixedProfile(uint8_t const profile) { _fixed_profile = profile; }
+
+  static uint8_t const PROFILE_BY_SWITCH = 0xFF;
+
+private:
+
+  T_CONTROL_PROFILE const * _profiles;
+  uint8_t                   _num_profiles;
+  E_RC_IN_SELECT            _switch_channel;
+  uint8_t                   _active_profile;
+  uint8_t                   _fixed_profile;
+
+  bool selectProfile();
+  void applyProfileGain();
+
+  bool isGood();
+  void failsafe();
+  void mixing();
+  void transitionToFailsafe();
+  void transitionToMixing();
+};
+
+/**
+ * \brief Control with the mixing functionality selected at compile time. Mixer
+ * is a class such as ControlDemo or ControlOmnidrive3Wheels which provides the
+ * static functions isGoodFunc(), failsafeFunc(), mixingFunc(),
+ * transitionToFailsafeFunc() and transitionToMixingFunc().
+ */
+template <class Mixer>
+class StaticControl : public ControlStateMachine<StaticControl<Mixer> >
+{
+
+  friend class ControlStateMachine<StaticControl<Mixer> >;
+
+public:
+
+  StaticControl() { }
+
+private:
+
+  bool isGood()               { return Mixer::isGoodFunc(); }
+  void failsafe()             { Mixer::failsafeFunc(); }
+  void mixing()               { Mixer::mixingFunc(); }
+  void transitionToFailsafe() { Mixer::transitionToFailsafeFunc(); }
+  void transitionToMixing()   { Mixer::transitionToMixingFunc(); }
 };
 
 #endif /* CONTROL_H_ */
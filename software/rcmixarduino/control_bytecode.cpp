@@ -0,0 +1,687 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "control_bytecode.h"
+
+#include <string.h>
+
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+
+#include "rcin.h"
+#include "rcout.h"
+
+#ifdef CONFIG_USE_CONTROL_BYTECODE
+
+/************************************************************************/
+/* PRIVATE TYPEDEFS                                                     */
+/************************************************************************/
+
+typedef struct
+{
+  uint8_t  size;      /* Size of the instruction including operands */
+  uint8_t  pops;      /* Values taken from the stack */
+  uint8_t  pushes;    /* Values put onto the stack */
+  uint16_t cycles;    /* Estimated execution time including dispatch */
+} T_BYTECODE_INSTRUCTION;
+
+typedef struct
+{
+  uint8_t target;     /* Address of a jump target not yet reached */
+  uint8_t depth;      /* Stack depth at the jump */
+} T_BYTECODE_JUMP;
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+/* The program is stored in the upper quarter of the 1 kB EEPROM */
+
+static uint16_t const EEPROM_PROGRAM_ADDRESS = 0x300;
+
+static uint8_t const PROGRAM_MAGIC = 0xB7;
+static uint8_t const INVALID_PROGRAM_MAGIC = 0xFF;
+static uint8_t const PROGRAM_HEADER_SIZE = 3;
+
+static uint16_t const CENTER_PULSE_DURATION_US = 1500;
+static int16_t const  MAX_OUTPUT_DEVIATION_US  = 1000;
+
+static uint8_t const NUM_RC_IN_CHANNELS = 4;
+static uint8_t const NUM_RC_OUT_CHANNELS = 6;
+
+static uint8_t const MAX_PENDING_JUMPS = 8;
+
+static int16_t const MAX_VALUE = 32767;
+static int16_t const MIN_VALUE = -32767 - 1;
+
+/* The cycles are estimates for the interpreter loop below compiled with
+ * avr-gcc -Os, IN and OUT include the calls into RcIn / RcOut (atomic
+ * access, output transform). They are not measured on the target and
+ * only used to reject programs which clearly exceed the budget. They
+ * have to be kept in sync with software/tools/mixasm.py.
+ */
+
+static T_BYTECODE_INSTRUCTION const BYTECODE_INSTRUCTION[NUM_OPCODES] PROGMEM =
+{
+  { 1, 0, 0,  10 }, /* OP_HALT */
+  { 2, 0, 1,  80 }, /* OP_IN   */
+  { 2, 1, 0, 300 }, /* OP_OUT  */
+  { 3, 0, 1,  30 }, /* OP_PUSH */
+  { 1, 2, 1,  40 }, /* OP_ADD  */
+  { 1, 2, 1,  40 }, /* OP_SUB  */
+  { 1, 2, 1,  80 }, /* OP_MULQ */
+  { 1, 1, 1,  25 }, /* OP_NEG  */
+  { 1, 1, 1,  25 }, /* OP_ABS  */
+  { 1, 2, 1,  35 }, /* OP_MIN  */
+  { 1, 2, 1,  35 }, /* OP_MAX  */
+  { 1, 2, 1,  35 }, /* OP_LT   */
+  { 1, 1, 2,  25 }, /* OP_DUP  */
+  { 1, 2, 2,  30 }, /* OP_SWAP */
+  { 1, 1, 0,  20 }, /* OP_DROP */
+  { 2, 1, 0,  30 }, /* OP_JZ   */
+  { 2, 0, 0,  20 }  /* OP_JMP  */
+};
+
+/************************************************************************/
+/* PRIVATE DATA                                                         */
+/************************************************************************/
+
+static uint8_t         BytecodeProgram[BYTECODE_MAX_PROGRAM_SIZE];
+static uint8_t         BytecodeSize = 0;
+static bool            BytecodeIsValid = false;
+static T_BYTECODE_INFO BytecodeInfo = { 0, 0, 0 };
+
+/* Upload buffer - the EEPROM image of a new program, written by
+ * process() in the order invalid magic, size, checksum, code, magic so
+ * that an upload which is interrupted by a reset leaves no valid program
+ */
+
+static uint8_t BytecodeStoreImage[PROGRAM_HEADER_SIZE + BYTECODE_MAX_PROGRAM_SIZE];
+static uint8_t BytecodeStoreImageSize = 0;
+static uint8_t BytecodeStoreWriteStep = 1;
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+/**
+ * \brief limit a value to the range of int16_t
+ */
+int16_t saturateBytecodeValue(int32_t const value)
+{
+  if (value > MAX_VALUE)
+  {
+    return MAX_VALUE;
+  }
+  else if (value < MIN_VALUE)
+  {
+    return MIN_VALUE;
+  }
+  else
+  {
+    return (int16_t) (value);
+  }
+}
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+/**
+ * \brief load the program from the EEPROM and verify it - without a valid
+ * program the mixer never leaves the failsafe state
+ */
+E_BYTECODE_RESULT ControlBytecode::load()
+{
+  uint8_t const * const address = (uint8_t const *) (EEPROM_PROGRAM_ADDRESS);
+
+  BytecodeIsValid = false;
+
+  uint8_t const magic = eeprom_read_byte(address);
+  uint8_t const size = eeprom_read_byte(address + 1);
+  uint8_t const checksum = eeprom_read_byte(address + 2);
+
+  if (magic != PROGRAM_MAGIC || size == 0 || size > BYTECODE_MAX_PROGRAM_SIZE)
+  {
+    return BYTECODE_ERROR_HEADER;
+  }
+
+  eeprom_read_block(BytecodeProgram, address + PROGRAM_HEADER_SIZE, size);
+
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < size; i++)
+  {
+    sum += BytecodeProgram[i];
+  }
+
+  if (sum != checksum)
+  {
+    return BYTECODE_ERROR_HEADER;
+  }
+
+  E_BYTECODE_RESULT const result = verify(BytecodeProgram, size, &BytecodeInfo);
+
+  if (result == BYTECODE_OK)
+  {
+    BytecodeSize = size;
+    BytecodeIsValid = true;
+  }
+
+  return result;
+}
+
+/**
+ * \brief verify a program (e.g. before it is written to the EEPROM) and
+ * estimate its worst case execution time
+ */
+E_BYTECODE_RESULT ControlBytecode::verify(uint8_t const * code, uint8_t const size, T_BYTECODE_INFO * info)
+{
+  T_BYTECODE_JUMP pending[MAX_PENDING_JUMPS];
+  uint8_t num_pending = 0;
+
+  uint8_t depth = 0;
+  bool is_reachable = true;
+  uint32_t cycles = 0;
+
+  info->in_mask = 0;
+  info->out_mask = 0;
+  info->worst_case_cycles = 0;
+
+  if (size > BYTECODE_MAX_PROGRAM_SIZE)
+  {
+    return BYTECODE_ERROR_HEADER;
+  }
+
+  for (uint8_t pc = 0; pc < size; )
+  {
+    /* Merge the stack depth of all jumps targeting this instruction */
+
+    for (uint8_t j = 0; j < num_pending; )
+    {
+      if (pending[j].target == pc)
+      {
+        if (is_reachable && pending[j].depth != depth)
+        {
+          return BYTECODE_ERROR_STACK;
+        }
+
+        depth = pending[j].depth;
+        is_reachable = true;
+        pending[j] = pending[--num_pending];
+      }
+      else
+      {
+        j++;
+      }
+    }
+
+    if (!is_reachable)
+    {
+      return BYTECODE_ERROR_UNREACHABLE;
+    }
+
+    uint8_t const op = code[pc];
+
+    if (op >= NUM_OPCODES)
+    {
+      return BYTECODE_ERROR_OPCODE;
+    }
+
+    T_BYTECODE_INSTRUCTION instruction;
+    memcpy_P(&instruction, &BYTECODE_INSTRUCTION[op], sizeof(instruction));
+
+    if (pc + instruction.size > size)
+    {
+      return BYTECODE_ERROR_OPERAND;
+    }
+
+    /* Operands */
+
+    uint8_t const next_pc = pc + instruction.size;
+
+    if (op == OP_IN)
+    {
+      if (code[pc + 1] >= NUM_RC_IN_CHANNELS)
+      {
+        return BYTECODE_ERROR_OPERAND;
+      }
+      info->in_mask |= (1 << code[pc + 1]);
+    }
+    else if (op == OP_OUT)
+    {
+      if (code[pc + 1] >= NUM_RC_OUT_CHANNELS)
+      {
+        return BYTECODE_ERROR_OPERAND;
+      }
+      info->out_mask |= (1 << code[pc + 1]);
+    }
+
+    /* Stack */
+
+    if (depth < instruction.pops || depth - instruction.pops + instruction.pushes > BYTECODE_STACK_SIZE)
+    {
+      return BYTECODE_ERROR_STACK;
+    }
+
+    depth = depth - instruction.pops + instruction.pushes;
+
+    /* Jumps - a target equal to size ends the program */
+
+    if (op == OP_JZ || op == OP_JMP)
+    {
+      uint16_t const target = next_pc + code[pc + 1];
+
+      if (target > size)
+      {
+        return BYTECODE_ERROR_JUMP;
+      }
+
+      if (target < size)
+      {
+        bool is_known_target = false;
+
+        for (uint8_t j = 0; j < num_pending; j++)
+        {
+          if (pending[j].target == target)
+          {
+            if (pending[j].depth != depth)
+            {
+              return BYTECODE_ERROR_STACK;
+            }
+            is_known_target = true;
+          }
+        }
+
+        if (!is_known_target)
+        {
+          if (num_pending >= MAX_PENDING_JUMPS)
+          {
+            return BYTECODE_ERROR_JUMP;
+          }
+
+          pending[num_pending].target = target;
+          pending[num_pending].depth = depth;
+          num_pending++;
+        }
+      }
+    }
+
+    if (op == OP_JMP || op == OP_HALT)
+    {
+      is_reachable = false;
+    }
+
+    /* Every instruction is executed at most once, the sum of all
+     * instructions therefore covers the longest path through the program
+     */
+
+    cycles += instruction.cycles;
+    pc = next_pc;
+  }
+
+  /* A remaining target lies within an instruction */
+
+  if (num_pending > 0)
+  {
+    return BYTECODE_ERROR_JUMP;
+  }
+
+  if (cycles > BYTECODE_MAX_PROGRAM_CYCLES)
+  {
+    return BYTECODE_ERROR_CYCLES;
+  }
+
+  info->worst_case_cycles = (uint16_t) (cycles);
+
+  return BYTECODE_OK;
+}
+
+/**
+ * \brief copy a part of a new program to the upload buffer, returns false if it exceeds
+ * BYTECODE_MAX_PROGRAM_SIZE or the last program is still written to the EEPROM
+ */
+bool ControlBytecode::write(uint8_t const offset, uint8_t const * data, uint8_t const size)
+{
+  if (isStoring() || (uint16_t) (offset) + size > BYTECODE_MAX_PROGRAM_SIZE)
+  {
+    return false;
+  }
+
+  memcpy(BytecodeStoreImage + PROGRAM_HEADER_SIZE + offset, data, size);
+
+  return true;
+}
+
+/**
+ * \brief verify the first size bytes of the upload buffer and write the program to the
+ * EEPROM in the background (see process()) if it is valid - the loaded program is not changed
+ */
+E_BYTECODE_RESULT ControlBytecode::store(uint8_t const size, T_BYTECODE_INFO * info)
+{
+  if (isStoring())
+  {
+    return BYTECODE_ERROR_BUSY;
+  }
+
+  if (size == 0)
+  {
+    return BYTECODE_ERROR_HEADER;
+  }
+
+  uint8_t const * const code = BytecodeStoreImage + PROGRAM_HEADER_SIZE;
+
+  E_BYTECODE_RESULT const result = verify(code, size, info);
+
+  if (result != BYTECODE_OK)
+  {
+    return result;
+  }
+
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < size; i++)
+  {
+    sum += code[i];
+  }
+
+  BytecodeStoreImage[0] = PROGRAM_MAGIC;
+  BytecodeStoreImage[1] = size;
+  BytecodeStoreImage[2] = sum;
+
+  BytecodeStoreImageSize = PROGRAM_HEADER_SIZE + size;
+  BytecodeStoreWriteStep = 0;
+
+  return BYTECODE_OK;
+}
+
+/**
+ * \brief returns true while a program is written to the EEPROM
+ */
+bool ControlBytecode::isStoring()
+{
+  return BytecodeStoreWriteStep <= BytecodeStoreImageSize;
+}
+
+/**
+ * \brief write the next byte of a stored program to the EEPROM if the EEPROM is ready,
+ * never waits - has to be called periodically from a low priority task
+ */
+void ControlBytecode::process()
+{
+  /* Writing one byte takes 3.4 ms, eeprom_update_byte would wait for the
+   * completion of the previous write. Step 0 invalidates the magic, the
+   * last step writes it.
+   */
+
+  while (isStoring() && eeprom_is_ready())
+  {
+    uint8_t const step = BytecodeStoreWriteStep++;
+    uint8_t const index = (step == BytecodeStoreImageSize) ? 0 : step;
+    uint8_t const value = (step == 0) ? INVALID_PROGRAM_MAGIC : BytecodeStoreImage[index];
+
+    uint8_t * const address = (uint8_t *) (EEPROM_PROGRAM_ADDRESS) + index;
+
+    if (eeprom_read_byte(address) != value)
+    {
+      eeprom_write_byte(address, value);
+      return;
+    }
+  }
+}
+
+/**
+ * \brief returns the information about the loaded program
+ */
+T_BYTECODE_INFO ControlBytecode::getInfo()
+{
+  return BytecodeInfo;
+}
+
+/**
+ * \brief returns true if a valid program has been loaded
+ */
+bool ControlBytecode::isLoaded()
+{
+  return BytecodeIsValid;
+}
+
+/** 
+ * \brief this function returns true when a valid program is loaded and all inputs read by it are good
+ */
+bool ControlBytecode::isGoodFunc()
+{
+  if (!BytecodeIsValid)
+  {
+    return false;
+  }
+
+  for (uint8_t sel = 0; sel < NUM_RC_IN_CHANNELS; sel++)
+  {
+    if ((BytecodeInfo.in_mask & (1 << sel)) && !RcIn::isGood((E_RC_IN_SELECT) (sel)))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/** 
+ * \brief this function implements the failsafe behaviour of this specific mixer
+ */
+void ControlBytecode::failsafeFunc()
+{
+  /* Nothing to do here, outputs are put into failsafe in the
+   * transition to failsafe and behave according to their
+   * failsafe policy (see RcOut::setFailsafePolicy)
+   */
+}
+
+/** 
+ * \brief this function executes the loaded program
+ */
+void ControlBytecode::mixingFunc()
+{
+  /* The program has been verified - no checks are necessary here */
+
+  int16_t stack[BYTECODE_STACK_SIZE];
+  uint8_t sp = 0;
+  uint8_t pc = 0;
+
+  while (pc < BytecodeSize)
+  {
+    uint8_t const op = BytecodeProgram[pc];
+
+    switch (op)
+    {
+    case OP_IN:
+    {
+      E_RC_IN_SELECT const sel = (E_RC_IN_SELECT) (BytecodeProgram[pc + 1]);
+      stack[sp++] = (int16_t) (RcIn::getPulseDurationUs(sel)) - (int16_t) (CENTER_PULSE_DURATION_US);
+      pc += 2;
+    }
+      break;
+    case OP_OUT:
+    {
+      E_RC_OUT_SELECT const sel = (E_RC_OUT_SELECT) (BytecodeProgram[pc + 1]);
+      int16_t value = stack[--sp];
+      if (value > MAX_OUTPUT_DEVIATION_US)
+      {
+        value = MAX_OUTPUT_DEVIATION_US;
+      }
+      else if (value < -MAX_OUTPUT_DEVIATION_US)
+      {
+        value = -MAX_OUTPUT_DEVIATION_US;
+      }
+      RcOut::setPwmPulseDurationUs(sel, (uint16_t) ((int16_t) (CENTER_PULSE_DURATION_US) + value));
+      pc += 2;
+    }
+      break;
+    case OP_PUSH:
+    {
+      stack[sp++] = (int16_t) (BytecodeProgram[pc + 1] | (BytecodeProgram[pc + 2] << 8));
+      pc += 3;
+    }
+      break;
+    case OP_ADD:
+    {
+      sp--;
+      stack[sp - 1] = saturateBytecodeValue((int32_t) (stack[sp - 1]) + stack[sp]);
+      pc++;
+    }
+      break;
+    case OP_SUB:
+    {
+      sp--;
+      stack[sp - 1] = saturateBytecodeValue((int32_t) (stack[sp - 1]) - stack[sp]);
+      pc++;
+    }
+      break;
+    case OP_MULQ:
+    {
+      sp--;
+      stack[sp - 1] = saturateBytecodeValue(((int32_t) (stack[sp - 1]) * stack[sp]) >> 8);
+      pc++;
+    }
+      break;
+    case OP_NEG:
+    {
+      stack[sp - 1] = saturateBytecodeValue(-(int32_t) (stack[sp - 1]));
+      pc++;
+    }
+      break;
+    case OP_ABS:
+    {
+      if (stack[sp - 1] < 0)
+      {
+        stack[sp - 1] = saturateBytecodeValue(-(int32_t) (stack[sp - 1]));
+      }
+      pc++;
+    }
+      break;
+    case OP_MIN:
+    {
+      sp--;
+      if (stack[sp] < stack[sp - 1])
+      {
+        stack[sp - 1] = stack[sp];
+      }
+      pc++;
+    }
+      break;
+    case OP_MAX:
+    {
+      sp--;
+      if (stack[sp] > stack[sp - 1])
+      {
+        stack[sp - 1] = stack[sp];
+      }
+      pc++;
+    }
+      break;
+    case OP_LT:
+    {
+      sp--;
+      stack[sp - 1] = (stack[sp - 1] < stack[sp]) ? 1 : 0;
+      pc++;
+    }
+      break;
+    case OP_DUP:
+    {
+      stack[sp] = stack[sp - 1];
+      sp++;
+      pc++;
+    }
+      break;
+    case OP_SWAP:
+    {
+      int16_t const tmp = stack[sp - 1];
+      stack[sp - 1] = stack[sp - 2];
+      stack[sp - 2] = tmp;
+      pc++;
+    }
+      break;
+    case OP_DROP:
+    {
+      sp--;
+      pc++;
+    }
+      break;
+    case OP_JZ:
+    {
+      uint8_t const offset = BytecodeProgram[pc + 1];
+      pc += 2;
+      if (stack[--sp] == 0)
+      {
+        pc += offset;
+      }
+    }
+      break;
+    case OP_JMP:
+    {
+      pc += 2 + BytecodeProgram[pc + 1];
+    }
+      break;
+    case OP_HALT:
+    default:
+    {
+      pc = BytecodeSize;
+    }
+      break;
+    }
+  }
+}
+
+/** 
+ * \brief this function puts all outputs written by the program into failsafe
+ */
+void ControlBytecode::transitionToFailsafeFunc()
+{
+  for (uint8_t sel = 0; sel < NUM_RC_OUT_CHANNELS; sel++)
+  {
+    if (BytecodeInfo.out_mask & (1 << sel))
+    {
+      RcOut::setRcOutState((E_RC_OUT_SELECT) (sel), OUTx_FAILSAFE);
+    }
+  }
+}
+
+/** 
+ * \brief this function turns on all outputs written by the program
+ */
+void ControlBytecode::transitionToMixingFunc()
+{
+  for (uint8_t sel = 0; sel < NUM_RC_OUT_CHANNELS; sel++)
+  {
+    if (BytecodeInfo.out_mask & (1 << sel))
+    {
+      RcOut::setRcOutState((E_RC_OUT_SELECT) (sel), OUTx_ON);
+    }
+  }
+}
+
+#endif
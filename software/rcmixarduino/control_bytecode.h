@@ -0,0 +1,209 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BYTECODE_H_
+#define BYTECODE_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+#ifdef CONFIG_USE_CONTROL_BYTECODE
+
+/************************************************************************/
+/* PUBLIC TYPES                                                         */
+/************************************************************************/
+
+/* The mixing program is executed by a stack machine with a stack of
+ * BYTECODE_STACK_SIZE signed 16 bit values. Pulse durations are handled
+ * as deviation from 1500 us. Jump offsets are unsigned and relative to
+ * the following instruction, therefore only forward jumps are possible
+ * and every instruction is executed at most once per pass.
+ *
+ * software/tools/mixasm.py assembles programs and has to be kept in
+ * sync with this instruction set.
+ */
+
+typedef enum
+{
+  OP_HALT = 0x00, /* -                        stop the program                             */
+  OP_IN   = 0x01, /* ch     -> a              a = pulse duration of IN(ch + 1) - 1500      */
+  OP_OUT  = 0x02, /* ch     a ->              pulse duration of OUT(ch + 1) = 1500 + a     */
+  OP_PUSH = 0x03, /* lo hi  -> a              a = immediate value                          */
+  OP_ADD  = 0x04, /* -      a b -> a + b      saturating                                   */
+  OP_SUB  = 0x05, /* -      a b -> a - b      saturating                                   */
+  OP_MULQ = 0x06, /* -      a b -> a * b / 256 (b is a 8.8 fixed point gain), saturating   */
+  OP_NEG  = 0x07, /* -      a -> -a                                                        */
+  OP_ABS  = 0x08, /* -      a -> |a|                                                       */
+  OP_MIN  = 0x09, /* -      a b -> min(a, b)                                               */
+  OP_MAX  = 0x0A, /* -      a b -> max(a, b)                                               */
+  OP_LT   = 0x0B, /* -      a b -> (a < b)                                                 */
+  OP_DUP  = 0x0C, /* -      a -> a a                                                       */
+  OP_SWAP = 0x0D, /* -      a b -> b a                                                     */
+  OP_DROP = 0x0E, /* -      a ->                                                           */
+  OP_JZ   = 0x0F, /* off    a ->              skip off bytes if a == 0                     */
+  OP_JMP  = 0x10, /* off    -                 skip off bytes                               */
+  NUM_OPCODES
+} E_BYTECODE_OPCODE;
+
+static uint8_t const BYTECODE_STACK_SIZE = 8;
+static uint8_t const BYTECODE_MAX_PROGRAM_SIZE = 128;
+
+/* Execution time budget of a program which is accepted (1 ms). The
+ * cycles per instruction are estimates (see control_bytecode.cpp) and
+ * not measured on the target, the estimate is therefore no guarantee.
+ * The interpreter has not been benchmarked against the native mixers
+ * yet, the measured execution time of the mixer is reported as
+ * mix_exec_time_us by the telemetry (see telemetry.h).
+ */
+
+static uint16_t const BYTECODE_MAX_PROGRAM_CYCLES = 16000;
+
+typedef enum
+{
+  BYTECODE_OK = 0,
+  BYTECODE_ERROR_HEADER,          /* Wrong magic, size or checksum */
+  BYTECODE_ERROR_OPCODE,          /* Unknown opcode */
+  BYTECODE_ERROR_OPERAND,         /* Channel out of range or instruction exceeds the program */
+  BYTECODE_ERROR_JUMP,            /* Jump target outside the program or within an instruction */
+  BYTECODE_ERROR_STACK,           /* Stack under- or overflow or inconsistent depth at a jump target */
+  BYTECODE_ERROR_UNREACHABLE,     /* Code which can never be executed */
+  BYTECODE_ERROR_CYCLES,          /* Estimated execution time exceeds BYTECODE_MAX_PROGRAM_CYCLES */
+  BYTECODE_ERROR_BUSY             /* The last program is still written to the EEPROM */
+} E_BYTECODE_RESULT;
+
+typedef struct
+{
+  uint8_t  in_mask;               /* Inputs read by the program (bit 0 = IN1) */
+  uint8_t  out_mask;              /* Outputs written by the program (bit 0 = OUT1) */
+  uint16_t worst_case_cycles;     /* Estimated execution time of the longest path in cpu cycles */
+} T_BYTECODE_INFO;
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+/* The program is stored in the EEPROM as
+ *
+ *   [magic 0xB7] [size] [checksum = sum of all code bytes] [code ...]
+ *
+ * A program is either written with avrdude (software/tools/mixasm.py
+ * --hex) and then only verified when it is loaded, or uploaded with
+ * write() and store() (rcmixcfg.py upload) which verify it before it is
+ * written to the EEPROM. The stored program is loaded at the next reset.
+ */
+
+class ControlBytecode
+{
+
+public:
+
+  /**
+   * \brief load the program from the EEPROM and verify it - without a valid
+   * program the mixer never leaves the failsafe state
+   */
+  static E_BYTECODE_RESULT load();
+
+  /**
+   * \brief verify a program (e.g. before it is written to the EEPROM) and
+   * estimate its worst case execution time
+   */
+  static E_BYTECODE_RESULT verify(uint8_t const * code, uint8_t const size, T_BYTECODE_INFO * info);
+
+  /**
+   * \brief copy a part of a new program to the upload buffer, returns false if it exceeds
+   * BYTECODE_MAX_PROGRAM_SIZE or the last program is still written to the EEPROM
+   */
+  static bool write(uint8_t const offset, uint8_t const * data, uint8_t const size);
+
+  /**
+   * \brief verify the first size bytes of the upload buffer and write the program to the
+   * EEPROM in the background (see process()) if it is valid - the loaded program is not changed
+   */
+  static E_BYTECODE_RESULT store(uint8_t const size, T_BYTECODE_INFO * info);
+
+  /**
+   * \brief returns true while a program is written to the EEPROM
+   */
+  static bool isStoring();
+
+  /**
+   * \brief write the next byte of a stored program to the EEPROM if the EEPROM is ready,
+   * never waits - has to be called periodically from a low priority task
+   */
+  static void process();
+
+  /**
+   * \brief returns the information about the loaded program
+   */
+  static T_BYTECODE_INFO getInfo();
+
+  /**
+   * \brief returns true if a valid program has been loaded
+   */
+  static bool isLoaded();
+
+  /**
+   * \brief this function returns true when a valid program is loaded and all inputs read by it are good
+   */
+  static bool isGoodFunc();
+
+  /**
+   * \brief this function implements the failsafe behavior of this specific mixer
+   */
+  static void failsafeFunc();
+
+  /**
+   * \brief this function executes the loaded program
+   */
+  static void mixingFunc();
+
+  /**
+   * \brief this function puts all outputs written by the program into failsafe
+   */
+  static void transitionToFailsafeFunc();
+
+  /**
+   * \brief this function turns on all outputs written by the program
+   */
+  static void transitionToMixingFunc();
+
+private:
+
+  /**
+   * \brief No public constructing
+   */
+  ControlBytecode()
+  {
+  }
+};
+
+#endif
+
+#endif /* BYTECODE_H_ */
@@ -52,8 +52,9 @@ bool ControlDemo::isGoodFunc()
  */
 void ControlDemo::failsafeFunc()
 {
-  /* Nothing to do here, outputs are turned off in the
-   * transition to failsafe
+  /* Nothing to do here, outputs are put into failsafe in the
+   * transition to failsafe and behave according to their
+   * failsafe policy (see RcOut::setFailsafePolicy)
    */
 }
 
@@ -73,10 +74,10 @@ void ControlDemo::mixingFunc()
  */
 void ControlDemo::transitionToFailsafeFunc()
 {
-  RcOut::setRcOutState(OUT1, OUTx_OFF);
-  RcOut::setRcOutState(OUT2, OUTx_OFF);
-  RcOut::setRcOutState(OUT3, OUTx_OFF);
-  RcOut::setRcOutState(OUT4, OUTx_OFF);
+  RcOut::setRcOutState(OUT1, OUTx_FAILSAFE);
+  RcOut::setRcOutState(OUT2, OUTx_FAILSAFE);
+  RcOut::setRcOutState(OUT3, OUTx_FAILSAFE);
+  RcOut::setRcOutState(OUT4, OUTx_FAILSAFE);
 }
 
 /** 
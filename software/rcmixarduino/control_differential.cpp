@@ -0,0 +1,219 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "control_differential.h"
+
+#include "rcin.h"
+#include "rcout.h"
+
+#if defined(CONFIG_USE_CURVE)
+#include "curve.h"
+#endif
+
+#ifdef CONFIG_USE_CONTROL_DIFFERENTIAL
+
+/************************************************************************/
+/* CONSTANTS                                                            */
+/************************************************************************/
+
+static uint16_t const CENTER_VALUE_PULSE_WIDTH_US = 1500;
+static int16_t const  MAX_STICK_POSITION          = 500;
+static int16_t const  UNITY_SCALE                 = 256;
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS	                                                    */
+/************************************************************************/
+
+/** 
+ * \brief this function returns true when all signals used in this specific mixer are good
+ */
+bool ControlDifferential::isGoodFunc()
+{
+  return (RcIn::isGood(IN1) && RcIn::isGood(IN2));
+}
+
+/** 
+ * \brief this function implements the failsafe behaviour of this specific mixer
+ */
+void ControlDifferential::failsafeFunc()
+{
+  /* Nothing to do here, outputs are put into failsafe in the
+   * transition to failsafe and behave according to their
+   * failsafe policy (see RcOut::setFailsafePolicy)
+   */
+}
+
+/** 
+ * \brief this function implements the mixing behavior (function fOUT(IN1, IN2, ...) of this specific mixer
+ */
+void ControlDifferential::mixingFunc()
+{
+  /* IN1
+   *  IN1 > 1500 -> FWD
+   *  IN1 < 1500 -> BWD
+   * IN2
+   *  IN2 > 1500 -> TURN RIGHT
+   *  IN2 < 1500 -> TURN LEFT
+   */
+
+#if defined(CONFIG_USE_CURVE)
+  /* The curve engine applies a smooth deadzone of DEADZONE_US (see setup()) */
+
+  int16_t const throttle = getStickPosition(Curve::getPulseDurationUs(IN1), 0);
+  int16_t const steering = getStickPosition(Curve::getPulseDurationUs(IN2), 0);
+#else
+  int16_t const throttle = getStickPosition(RcIn::getPulseDurationUs(IN1), DEADZONE_US);
+  int16_t const steering = getStickPosition(RcIn::getPulseDurationUs(IN2), DEADZONE_US);
+#endif
+
+  /* Arcade to tank conversion - at neutral throttle (pivot turn) the
+   * tracks run in opposite directions with reduced speed since turning
+   * on the spot strains the tracks the most. The reduction fades out
+   * until the throttle reaches PIVOT_BLEND_THROTTLE.
+   */
+
+  int16_t const throttle_magnitude = (throttle < 0) ? -throttle : throttle;
+  int16_t const blend = (throttle_magnitude < PIVOT_BLEND_THROTTLE) ? throttle_magnitude : PIVOT_BLEND_THROTTLE;
+  int16_t const steering_gain = PIVOT_TURN_GAIN + ((UNITY_SCALE - PIVOT_TURN_GAIN) * blend) / PIVOT_BLEND_THROTTLE;
+
+  int16_t const turn = scaleSpeed(steering, steering_gain);
+
+  int16_t left = throttle + turn;
+  int16_t right = throttle - turn;
+
+  /* Normalisation - scale both tracks down by the same factor if one of
+   * them exceeds its limit so that the curve radius is preserved
+   */
+
+  int16_t const left_scale = getLimitScale(left, MAX_LEFT_TRACK_SPEED);
+  int16_t const right_scale = getLimitScale(right, MAX_RIGHT_TRACK_SPEED);
+  int16_t const scale = (left_scale < right_scale) ? left_scale : right_scale;
+
+  if (scale < UNITY_SCALE)
+  {
+    left = scaleSpeed(left, scale);
+    right = scaleSpeed(right, scale);
+  }
+
+  /* OUT1 = LEFT TRACK
+   * OUT2 = RIGHT TRACK
+   */
+
+  ControlDifferential::setLeftTrack(left);
+  ControlDifferential::setRightTrack(right);
+}
+
+/** 
+ * \brief this function implements the behaviour if a transition from mixing to failsafe is taking place
+ */
+void ControlDifferential::transitionToFailsafeFunc()
+{
+  RcOut::setRcOutState(OUT1, OUTx_FAILSAFE);
+  RcOut::setRcOutState(OUT2, OUTx_FAILSAFE);
+}
+
+/** 
+ * \brief this function implements the behaviour if a transition from failsafe to mixing is taking place
+ */
+void ControlDifferential::transitionToMixingFunc()
+{
+  RcOut::setRcOutState(OUT1, OUTx_ON);
+  RcOut::setRcOutState(OUT2, OUTx_ON);
+}
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS	                                                */
+/************************************************************************/
+
+/** 
+ * \brief returns the deviation of the pulse duration from 1500 us, limited to +/- 500 us and
+ * 0 within the deadzone
+ */
+int16_t ControlDifferential::getStickPosition(uint16_t const pulse_duration_us, uint16_t const deadzone_us)
+{
+  int16_t const position = (int16_t) (pulse_duration_us) - (int16_t) (CENTER_VALUE_PULSE_WIDTH_US);
+
+  if (position <= (int16_t) (deadzone_us) && position >= -(int16_t) (deadzone_us))
+  {
+    return 0;
+  }
+  else if (position > MAX_STICK_POSITION)
+  {
+    return MAX_STICK_POSITION;
+  }
+  else if (position < -MAX_STICK_POSITION)
+  {
+    return -MAX_STICK_POSITION;
+  }
+  else
+  {
+    return position;
+  }
+}
+
+/** 
+ * \brief returns the scale factor (8.8 fixed point) which limits speed to max_speed
+ */
+int16_t ControlDifferential::getLimitScale(int16_t const speed, int16_t const max_speed)
+{
+  int16_t const magnitude = (speed < 0) ? -speed : speed;
+
+  if (magnitude <= max_speed)
+  {
+    return UNITY_SCALE;
+  }
+
+  return ((int32_t) (max_speed) << 8) / magnitude;
+}
+
+/** 
+ * \brief returns speed * scale (8.8 fixed point), rounded symmetrically so that
+ * mirrored inputs result in mirrored outputs
+ */
+int16_t ControlDifferential::scaleSpeed(int16_t const speed, int16_t const scale)
+{
+  int16_t const magnitude = (speed < 0) ? -speed : speed;
+  int16_t const scaled_magnitude = ((int32_t) (magnitude) * scale) >> 8;
+
+  return (speed < 0) ? -scaled_magnitude : scaled_magnitude;
+}
+
+/** 
+ * \brief control the two tracks
+ */
+void ControlDifferential::setLeftTrack(int16_t const speed)
+{
+  RcOut::setPwmPulseDurationUs(OUT1, (uint16_t) ((int16_t) (CENTER_VALUE_PULSE_WIDTH_US) + speed));
+}
+
+void ControlDifferential::setRightTrack(int16_t const speed)
+{
+  RcOut::setPwmPulseDurationUs(OUT2, (uint16_t) ((int16_t) (CENTER_VALUE_PULSE_WIDTH_US) + speed));
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef DIFFERENTIAL_H_
+#define DIFFERENTIAL_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+#ifdef CONFIG_USE_CONTROL_DIFFERENTIAL
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+class ControlDifferential
+{
+
+public:
+
+  /**
+   * \brief this function returns true when all signals used in this specific mixer are good
+   */
+  static bool isGoodFunc();
+
+  /**
+   * \brief this function implements the failsafe behavior of this specific mixer
+   */
+  static void failsafeFunc();
+
+  /**
+   * \brief this function implements the mixing behavior (function fOUT(IN1, IN2, ...) of this specific mixer
+   */
+  static void mixingFunc();
+
+  /**
+   * \brief this function implements the behaviour if a transition from mixing to failsafe is taking place
+   */
+  static void transitionToFailsafeFunc();
+
+  /**
+   * \brief this function implements the behaviour if a transition from failsafe to mixing is taking place
+   */
+  static void transitionToMixingFunc();
+
+  static uint16_t const DEADZONE_US = 50;
+
+  /* Maximum speed of each track (deviation from 1500 us), e.g. to match
+   * a faster motor to a slower one. Both tracks are scaled down by the
+   * same factor if one of them exceeds its limit.
+   */
+
+  static int16_t const MAX_LEFT_TRACK_SPEED = 500;
+  static int16_t const MAX_RIGHT_TRACK_SPEED = 500;
+
+  /* Gain of the steering when turning on the spot (throttle in neutral)
+   * as 8.8 fixed point value (192 = 75 %). The gain rises linearly to
+   * 100 % until the throttle reaches PIVOT_BLEND_THROTTLE so that the
+   * tracks do not jump when the throttle leaves neutral.
+   */
+
+  static int16_t const PIVOT_TURN_GAIN = 192;
+  static int16_t const PIVOT_BLEND_THROTTLE = 100;
+
+private:
+
+  /**
+   * \brief No public constructing
+   */
+  ControlDifferential()
+  {
+  }
+
+  /**
+   * \brief returns the deviation of the pulse duration from 1500 us, limited to +/- 500 us and
+   * 0 within the deadzone
+   */
+  static int16_t getStickPosition(uint16_t const pulse_duration_us, uint16_t const deadzone_us);
+
+  /**
+   * \brief returns the scale factor (8.8 fixed point) which limits speed to max_speed
+   */
+  static int16_t getLimitScale(int16_t const speed, int16_t const max_speed);
+
+  /**
+   * \brief returns speed * scale (8.8 fixed point), rounded symmetrically so that
+   * mirrored inputs result in mirrored outputs
+   */
+  static int16_t scaleSpeed(int16_t const speed, int16_t const scale);
+
+  /**
+   * \brief control the two tracks
+   */
+  static void setLeftTrack(int16_t const speed);
+  static void setRightTrack(int16_t const speed);
+};
+
+#endif
+
+#endif /* DIFFERENTIAL_H_ */
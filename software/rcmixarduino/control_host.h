@@ -0,0 +1,203 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CONTROL_HOST_H_
+#define CONTROL_HOST_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <util/atomic.h>
+
+#include "config.h"
+
+#ifdef CONFIG_USE_HOST_CONTROL
+
+#include "rcout.h"
+#include "hostlink.h"
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+/**
+ * \brief Mixer adapter which arbitrates between the rc inputs and a host
+ * computer (see HostLink). It provides the same static functions as the
+ * Mixer it wraps and can therefore be used with every Control variant:
+ *
+ *   HOST_LINK_IDLE     Mixer with the rc inputs
+ *   HOST_LINK_INPUTS   Mixer with the inputs overridden by the host
+ *   HOST_LINK_OUTPUTS  the host sets the outputs, the Mixer is bypassed and
+ *                      the outputs not set by the host are in failsafe
+ *   HOST_LINK_LOST     failsafe
+ *
+ * The outputs move to the new source without jump on every change of the
+ * link state (bumpless transfer).
+ */
+template <class Mixer>
+class ControlHost
+{
+
+public:
+
+  /**
+   * \brief good if the host sets the outputs, otherwise as good as the Mixer (with
+   * overridden inputs)
+   */
+  static bool isGoodFunc()
+  {
+    switch (HostLink::update())
+    {
+    case HOST_LINK_OUTPUTS: return true;
+    case HOST_LINK_LOST:    return false;
+    default:                return Mixer::isGoodFunc();
+    }
+  }
+
+  static void failsafeFunc()
+  {
+    Mixer::failsafeFunc();
+  }
+
+  static void mixingFunc()
+  {
+    E_HOST_LINK_STATE const state = HostLink::update();
+
+    /* The state changes of the outputs are atomic with respect to the
+     * output isr, an output which is on before and after never emits a
+     * failsafe frame
+     */
+
+    if (state == HOST_LINK_OUTPUTS)
+    {
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+      {
+        if (_state != HOST_LINK_OUTPUTS)
+        {
+          /* The outputs of the Mixer which are not set by the host would
+           * keep the last rc mix - they go to failsafe, the outputs set by
+           * the host are turned on again
+           */
+
+          Mixer::transitionToFailsafeFunc();
+          _output_mask = 0;
+        }
+
+        setOutputStates(HostLink::getOutputMask());
+      }
+
+      HostLink::applyOutputs();
+    }
+    else
+    {
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+      {
+        setOutputStates(0);
+
+        /* The outputs of the Mixer are in failsafe since the host has set
+         * the outputs - turn them on again
+         */
+
+        if (_state == HOST_LINK_OUTPUTS)
+        {
+          Mixer::transitionToMixingFunc();
+        }
+      }
+
+      Mixer::mixingFunc();
+    }
+
+    if (state != _state)
+    {
+      RcOut::startBumplessTransfer(HANDOVER_TRANSFER_FRAMES);
+      _state = state;
+    }
+  }
+
+  static void transitionToFailsafeFunc()
+  {
+    Mixer::transitionToFailsafeFunc();
+
+    setOutputStates(0);
+
+    /* All outputs are in failsafe, mixingFunc() starts from scratch */
+
+    _state = HOST_LINK_LOST;
+  }
+
+  static void transitionToMixingFunc()
+  {
+    Mixer::transitionToMixingFunc();
+  }
+
+private:
+
+  /* Number of output frames within which the outputs are moved to the
+   * values of the new source (200 ms)
+   */
+
+  static uint8_t const HANDOVER_TRANSFER_FRAMES = 10;
+
+  static uint8_t           _output_mask;
+  static E_HOST_LINK_STATE _state;
+
+  /**
+   * \brief turn on the outputs set by the host, outputs which are not set by the
+   * host anymore go to failsafe
+   */
+  static void setOutputStates(uint8_t const output_mask)
+  {
+    for (uint8_t i = 0; i < 6; i++)
+    {
+      uint8_t const bm = (1 << i);
+
+      if ((output_mask & bm) && !(_output_mask & bm))
+      {
+        RcOut::setRcOutState((E_RC_OUT_SELECT) (i), OUTx_ON);
+      }
+      else if (!(output_mask & bm) && (_output_mask & bm))
+      {
+        RcOut::setRcOutState((E_RC_OUT_SELECT) (i), OUTx_FAILSAFE);
+      }
+    }
+
+    _output_mask = output_mask;
+  }
+
+  /**
+   * \brief no public constructing
+   */
+  ControlHost() { }
+};
+
+template <class Mixer> uint8_t           ControlHost<Mixer>::_output_mask = 0;
+template <class Mixer> E_HOST_LINK_STATE ControlHost<Mixer>::_state = HOST_LINK_IDLE;
+
+#endif
+
+#endif /* CONTROL_HOST_H_ */
@@ -0,0 +1,234 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "control_mecanum_4_wheels.h"
+
+#include "rcin.h"
+#include "rcout.h"
+
+#if defined(CONFIG_USE_CURVE)
+#include "curve.h"
+#endif
+
+#ifdef CONFIG_USE_CONTROL_MECANUM_4_WHEELS
+
+/************************************************************************/
+/* CONSTANTS                                                            */
+/************************************************************************/
+
+static uint16_t const CENTER_VALUE_PULSE_WIDTH_US = 1500;
+static int16_t const  MAX_SPEED                   = 500;
+static uint8_t const  NUM_MOTORS                  = 4;
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS	                                                    */
+/************************************************************************/
+
+/** 
+ * \brief this function returns true when all signals used in this specific mixer are good
+ */
+bool ControlMecanum4Wheels::isGoodFunc()
+{
+  return (RcIn::isGood(IN1) && RcIn::isGood(IN2) && RcIn::isGood(IN3));
+}
+
+/** 
+ * \brief this function implements the failsafe behaviour of this specific mixer
+ */
+void ControlMecanum4Wheels::failsafeFunc()
+{
+  /* Nothing to do here, outputs are put into failsafe in the
+   * transition to failsafe and behave according to their
+   * failsafe policy (see RcOut::setFailsafePolicy)
+   */
+}
+
+/** 
+ * \brief this function implements the mixing behavior (function fOUT(IN1, IN2, ...) of this specific mixer
+ */
+void ControlMecanum4Wheels::mixingFunc()
+{
+  /* IN1
+   *  IN1 > 1500 -> FWD
+   *  IN1 < 1500 -> BWD
+   * IN2
+   *  IN2 > 1500 -> STRAFE RIGHT
+   *  IN2 < 1500 -> STRAFE LEFT
+   * IN3
+   *  IN3 > 1500 -> ROTATE CLOCKWISE
+   *  IN3 < 1500 -> ROTATE COUNTER CLOCKWISE
+   *
+   * In contrast to the omnidrive all three movements are combined.
+   */
+
+#if defined(CONFIG_USE_CURVE)
+  /* The curve engine applies a smooth deadzone of DEADZONE_US (see setup()) */
+
+  int16_t const fwd_bwd = getStickPosition(Curve::getPulseDurationUs(IN1), 0);
+  int16_t const left_right = getStickPosition(Curve::getPulseDurationUs(IN2), 0);
+  int16_t const rotate = getStickPosition(Curve::getPulseDurationUs(IN3), 0);
+#else
+  int16_t const fwd_bwd = getStickPosition(RcIn::getPulseDurationUs(IN1), DEADZONE_US);
+  int16_t const left_right = getStickPosition(RcIn::getPulseDurationUs(IN2), DEADZONE_US);
+  int16_t const rotate = getStickPosition(RcIn::getPulseDurationUs(IN3), DEADZONE_US);
+#endif
+
+  /* Wheel speeds of a mecanum platform with the rollers forming an 'X'
+   * when viewed from above, positive = wheel drives the platform forward.
+   * The right motors are mounted mirrored, use RcOut::setReverse for
+   * OUT2 and OUT4 if the ESCs are not reversed themselves.
+   */
+
+  int16_t speed[NUM_MOTORS] =
+  {
+    (int16_t) (fwd_bwd + left_right + rotate), /* FRONT LEFT  */
+    (int16_t) (fwd_bwd - left_right - rotate), /* FRONT RIGHT */
+    (int16_t) (fwd_bwd - left_right + rotate), /* REAR LEFT   */
+    (int16_t) (fwd_bwd + left_right - rotate)  /* REAR RIGHT  */
+  };
+
+  /* Normalisation - scale all wheels down by the same factor if one of
+   * them exceeds the maximum speed so that the direction of movement is
+   * preserved. The factor is calculated once as 8.8 fixed point value.
+   */
+
+  int16_t max_speed = MAX_SPEED;
+
+  for (uint8_t m = 0; m < NUM_MOTORS; m++)
+  {
+    int16_t const magnitude = (speed[m] < 0) ? -speed[m] : speed[m];
+
+    if (magnitude > max_speed)
+    {
+      max_speed = magnitude;
+    }
+  }
+
+  if (max_speed > MAX_SPEED)
+  {
+    int16_t const scale = ((int32_t) (MAX_SPEED) << 8) / max_speed;
+
+    /* Scale the magnitude so that forward and reverse round the same way */
+
+    for (uint8_t m = 0; m < NUM_MOTORS; m++)
+    {
+      int16_t const magnitude = (speed[m] < 0) ? -speed[m] : speed[m];
+      int16_t const scaled_magnitude = ((int32_t) (magnitude) * scale) >> 8;
+
+      speed[m] = (speed[m] < 0) ? -scaled_magnitude : scaled_magnitude;
+    }
+  }
+
+  /* OUT1 = MOTOR FRONT LEFT
+   * OUT2 = MOTOR FRONT RIGHT
+   * OUT3 = MOTOR REAR LEFT
+   * OUT4 = MOTOR REAR RIGHT
+   */
+
+  ControlMecanum4Wheels::setMotorFrontLeft(speed[0]);
+  ControlMecanum4Wheels::setMotorFrontRight(speed[1]);
+  ControlMecanum4Wheels::setMotorRearLeft(speed[2]);
+  ControlMecanum4Wheels::setMotorRearRight(speed[3]);
+}
+
+/** 
+ * \brief this function implements the behaviour if a transition from mixing to failsafe is taking place
+ */
+void ControlMecanum4Wheels::transitionToFailsafeFunc()
+{
+  RcOut::setRcOutState(OUT1, OUTx_FAILSAFE);
+  RcOut::setRcOutState(OUT2, OUTx_FAILSAFE);
+  RcOut::setRcOutState(OUT3, OUTx_FAILSAFE);
+  RcOut::setRcOutState(OUT4, OUTx_FAILSAFE);
+}
+
+/** 
+ * \brief this function implements the behaviour if a transition from failsafe to mixing is taking place
+ */
+void ControlMecanum4Wheels::transitionToMixingFunc()
+{
+  RcOut::setRcOutState(OUT1, OUTx_ON);
+  RcOut::setRcOutState(OUT2, OUTx_ON);
+  RcOut::setRcOutState(OUT3, OUTx_ON);
+  RcOut::setRcOutState(OUT4, OUTx_ON);
+}
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS	                                                */
+/************************************************************************/
+
+/** 
+ * \brief returns the deviation of the pulse duration from 1500 us, limited to +/- 500 us and
+ * 0 within the deadzone
+ */
+int16_t ControlMecanum4Wheels::getStickPosition(uint16_t const pulse_duration_us, uint16_t const deadzone_us)
+{
+  int16_t const position = (int16_t) (pulse_duration_us) - (int16_t) (CENTER_VALUE_PULSE_WIDTH_US);
+
+  if (position <= (int16_t) (deadzone_us) && position >= -(int16_t) (deadzone_us))
+  {
+    return 0;
+  }
+  else if (position > MAX_SPEED)
+  {
+    return MAX_SPEED;
+  }
+  else if (position < -MAX_SPEED)
+  {
+    return -MAX_SPEED;
+  }
+  else
+  {
+    return position;
+  }
+}
+
+/** 
+ * \brief control the four motors
+ */
+void ControlMecanum4Wheels::setMotorFrontLeft(int16_t const speed)
+{
+  RcOut::setPwmPulseDurationUs(OUT1, (uint16_t) ((int16_t) (CENTER_VALUE_PULSE_WIDTH_US) + speed));
+}
+
+void ControlMecanum4Wheels::setMotorFrontRight(int16_t const speed)
+{
+  RcOut::setPwmPulseDurationUs(OUT2, (uint16_t) ((int16_t) (CENTER_VALUE_PULSE_WIDTH_US) + speed));
+}
+
+void ControlMecanum4Wheels::setMotorRearLeft(int16_t const speed)
+{
+  RcOut::setPwmPulseDurationUs(OUT3, (uint16_t) ((int16_t) (CENTER_VALUE_PULSE_WIDTH_US) + speed));
+}
+
+void ControlMecanum4Wheels::setMotorRearRight(int16_t const speed)
+{
+  RcOut::setPwmPulseDurationUs(OUT4, (uint16_t) ((int16_t) (CENTER_VALUE_PULSE_WIDTH_US) + speed));
+}
+
+#endif
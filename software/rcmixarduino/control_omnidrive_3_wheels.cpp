@@ -33,6 +33,10 @@
 #include "rcin.h"
 #include "rcout.h"
 
+#if defined(CONFIG_USE_CURVE)
+#include "curve.h"
+#endif
+
 #ifdef CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS
 
 /************************************************************************/
@@ -58,8 +62,9 @@ bool ControlOmnidrive3Wheels::isGoodFunc()
  */
 void ControlOmnidrive3Wheels::failsafeFunc()
 {
-  /* Nothing to do here, outputs are turned off in the
-   * transition to failsafe
+  /* Nothing to do here, outputs are put into failsafe in the
+   * transition to failsafe and behave according to their
+   * failsafe policy (see RcOut::setFailsafePolicy)
    */
 }
 
@@ -79,13 +84,27 @@ void ControlOmnidrive3Wheels::mixingFunc()
    *  IN3 < 1500 -> ROTATE COUNTER CLOCKWISE
    */
 
+#if defined(CONFIG_USE_CURVE)
+  /* The curve engine applies a smooth deadzone of DEADZONE_US (see
+   * setup()), sticks within the deadzone are exactly at 1500 us
+   */
+
+  uint16_t const fwd_bwd = Curve::getPulseDurationUs(IN1);
+  uint16_t const left_right = Curve::getPulseDurationUs(IN2);
+  uint16_t const rotate = Curve::getPulseDurationUs(IN3);
+
+  uint16_t const deadzone_us = 0;
+#else
   uint16_t const fwd_bwd = RcIn::getPulseDurationUs(IN1);
   uint16_t const left_right = RcIn::getPulseDurationUs(IN2);
   uint16_t const rotate = RcIn::getPulseDurationUs(IN3);
 
-  bool const do_move = !isStickInCenterPosition(fwd_bwd, DEADZONE_US)
-      || !isStickInCenterPosition(left_right, DEADZONE_US);
-  bool const do_rotate = !isStickInCenterPosition(rotate, DEADZONE_US);
+  uint16_t const deadzone_us = DEADZONE_US;
+#endif
+
+  bool const do_move = !isStickInCenterPosition(fwd_bwd, deadzone_us)
+      || !isStickInCenterPosition(left_right, deadzone_us);
+  bool const do_rotate = !isStickInCenterPosition(rotate, deadzone_us);
 
   /* OUT1 = MOTOR A
    * OUT2 = MOTOR B
@@ -111,9 +130,9 @@ void ControlOmnidrive3Wheels::mixingFunc()
  */
 void ControlOmnidrive3Wheels::transitionToFailsafeFunc()
 {
-  RcOut::setRcOutState(OUT1, OUTx_OFF);
-  RcOut::setRcOutState(OUT2, OUTx_OFF);
-  RcOut::setRcOutState(OUT3, OUTx_OFF);
+  RcOut::setRcOutState(OUT1, OUTx_FAILSAFE);
+  RcOut::setRcOutState(OUT2, OUTx_FAILSAFE);
+  RcOut::setRcOutState(OUT3, OUTx_FAILSAFE);
 }
 
 /** 
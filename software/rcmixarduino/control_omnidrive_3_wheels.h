@@ -34,7 +34,9 @@
 
 #include "config.h"
 
-#ifdef CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS
+/* The DSL variant (see control_omnidrive_3_wheels_dsl.h) uses DEADZONE_US */
+
+#if defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS) || defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS_DSL)
 
 /************************************************************************/
 /* PUBLIC PROTOTYPES                                                    */
@@ -70,6 +72,8 @@ public:
    */
   static void transitionToMixingFunc();
 
+  static uint16_t const DEADZONE_US = 50;
+
 private:
 
   /**
@@ -79,7 +83,6 @@ private:
   {
   }
 
-  static uint16_t const DEADZONE_US = 50;
 
   /**
    * \brief returns true if 1500 - deadzone_us <= pulse_duration_us <= 1500 + deadzone_us
@@ -0,0 +1,104 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "control_omnidrive_3_wheels_dsl.h"
+
+#include "mixdsl.h"
+#include "control_omnidrive_3_wheels.h"
+
+#ifdef CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS_DSL
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS	                                                    */
+/************************************************************************/
+
+/** 
+ * \brief this function returns true when all signals used in this specific mixer are good
+ */
+bool ControlOmnidrive3WheelsDsl::isGoodFunc()
+{
+  return (RcIn::isGood(IN1) && RcIn::isGood(IN2) && RcIn::isGood(IN3));
+}
+
+/** 
+ * \brief this function implements the failsafe behaviour of this specific mixer
+ */
+void ControlOmnidrive3WheelsDsl::failsafeFunc()
+{
+  /* Nothing to do here, outputs are put into failsafe in the
+   * transition to failsafe and behave according to their
+   * failsafe policy (see RcOut::setFailsafePolicy)
+   */
+}
+
+/** 
+ * \brief this function implements the mixing behavior (function fOUT(IN1, IN2, ...) of this specific mixer
+ */
+void ControlOmnidrive3WheelsDsl::mixingFunc()
+{
+  using namespace MixDsl;
+
+  /* The same mix as ControlOmnidrive3Wheels::mixingFunc (without curves)
+   * in fixed point: IN1 = FWD/BWD, IN2 = LEFT/RIGHT and IN3 = ROTATE,
+   * DEADZONE_US only decides whether a stick is moved. Moving has
+   * priority over rotating, rotating sets all motors to IN3.
+   *
+   *   C1 = 2/3, C2 = -1/3, C3 = -1/sqrt(3)
+   */
+
+  int16_t const dz = ControlOmnidrive3Wheels::DEADZONE_US;
+
+  auto const do_move = outside(in(IN1), dz) || outside(in(IN2), dz);
+  auto const do_rotate = outside(in(IN3), dz);
+
+  out(OUT1) = select(do_move,  0.6667_q * in(IN2),                      select(do_rotate, in(IN3), 0));
+  out(OUT2) = select(do_move, -0.3333_q * in(IN2) - 0.5774_q * in(IN1), select(do_rotate, in(IN3), 0));
+  out(OUT3) = select(do_move, -0.3333_q * in(IN2) + 0.5774_q * in(IN1), select(do_rotate, in(IN3), 0));
+}
+
+/** 
+ * \brief this function implements the behaviour if a transition from mixing to failsafe is taking place
+ */
+void ControlOmnidrive3WheelsDsl::transitionToFailsafeFunc()
+{
+  RcOut::setRcOutState(OUT1, OUTx_FAILSAFE);
+  RcOut::setRcOutState(OUT2, OUTx_FAILSAFE);
+  RcOut::setRcOutState(OUT3, OUTx_FAILSAFE);
+}
+
+/** 
+ * \brief this function implements the behaviour if a transition from failsafe to mixing is taking place
+ */
+void ControlOmnidrive3WheelsDsl::transitionToMixingFunc()
+{
+  RcOut::setRcOutState(OUT1, OUTx_ON);
+  RcOut::setRcOutState(OUT2, OUTx_ON);
+  RcOut::setRcOutState(OUT3, OUTx_ON);
+}
+
+#endif
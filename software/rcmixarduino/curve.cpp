@@ -0,0 +1,317 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "curve.h"
+
+#include <avr/pgmspace.h>
+
+#ifdef CONFIG_USE_CURVE
+
+#include "curve_tables.h"
+
+/************************************************************************/
+/* PRIVATE TYPEDEFS                                                     */
+/************************************************************************/
+
+typedef struct
+{
+  E_CURVE_TYPE    type;
+  uint8_t         expo_row;          /* Row of CURVE_EXPO_TABLE */
+  int16_t const * points;            /* N-point curve (PROGMEM) */
+  uint8_t         points_shift;      /* log2 of the distance between two points in us */
+  uint8_t         num_points;
+  uint16_t        rate_scale;        /* Rate as 8.8 fixed point value (256 = 100 %) */
+  uint16_t        deadzone_us;
+  uint16_t        deadzone_scale;    /* DOMAIN_US / (DOMAIN_US - deadzone_us) as 8.8 fixed point value */
+  uint16_t        center_us;         /* Input pulse duration which is mapped to 1500 us */
+} T_CURVE_DATA;
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+static uint8_t const NUM_RC_IN_CHANNELS = 4;
+
+static uint16_t const CENTER_PULSE_DURATION_US = 1500;
+
+/* These values have to match the ones in software/tools/curve_tables.py */
+
+static int16_t const DOMAIN_US         = 512;
+static uint8_t const EXPO_SEGMENT_SHIFT = 5;   /* 32 us between two points of the expo table */
+static uint8_t const EXPO_STEP_PERCENT = 10;
+static uint8_t const NUM_EXPO_ROWS     = 11;
+
+static uint16_t const MAX_DEADZONE_US  = 256;
+static uint16_t const MAX_CENTER_OFFSET_US = 100;
+static uint16_t const RATE_SCALE_100_PERCENT = 256;
+
+/************************************************************************/
+/* PRIVATE DATA                                                         */
+/************************************************************************/
+
+static T_CURVE_DATA CurveData[NUM_RC_IN_CHANNELS];
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+/**
+ * \brief apply the smooth deadzone - magnitude_us = 0 ... DOMAIN_US
+ */
+uint16_t applyCurveDeadzone(T_CURVE_DATA const & curve, uint16_t const magnitude_us)
+{
+  if (magnitude_us <= curve.deadzone_us)
+  {
+    return 0;
+  }
+
+  /* Stretch the remaining range to 0 ... DOMAIN_US so that there is
+   * no step at the edge of the deadzone
+   */
+
+  uint16_t const stretched_us = (uint16_t) (((uint32_t) (magnitude_us - curve.deadzone_us) * curve.deadzone_scale) >> 8);
+
+  return (stretched_us > DOMAIN_US) ? DOMAIN_US : stretched_us;
+}
+
+/**
+ * \brief interpolate the expo table - magnitude_us = 0 ... DOMAIN_US
+ */
+uint16_t lookupCurveExpo(uint8_t const row, uint16_t const magnitude_us)
+{
+  uint8_t const index = magnitude_us >> EXPO_SEGMENT_SHIFT;
+  uint8_t const frac = magnitude_us & ((1 << EXPO_SEGMENT_SHIFT) - 1);
+
+  uint16_t const y0 = pgm_read_word(&CURVE_EXPO_TABLE[row][index]);
+
+  if (frac == 0)
+  {
+    return y0;
+  }
+
+  uint16_t const y1 = pgm_read_word(&CURVE_EXPO_TABLE[row][index + 1]);
+
+  return y0 + (((y1 - y0) * frac) >> EXPO_SEGMENT_SHIFT);
+}
+
+/**
+ * \brief interpolate the n-point curve - value_us = -DOMAIN_US ... DOMAIN_US
+ */
+int16_t lookupCurvePoints(T_CURVE_DATA const & curve, int16_t const value_us)
+{
+  uint16_t const position_us = (uint16_t) (value_us + DOMAIN_US);
+  uint8_t const index = position_us >> curve.points_shift;
+  uint8_t const frac = position_us & ((1 << curve.points_shift) - 1);
+
+  int16_t const y0 = (int16_t) pgm_read_word(&curve.points[index]);
+
+  if (frac == 0)
+  {
+    return y0;
+  }
+
+  int16_t const y1 = (int16_t) pgm_read_word(&curve.points[index + 1]);
+
+  return y0 + (int16_t) (((int32_t) (y1 - y0) * frac) >> curve.points_shift);
+}
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+/**
+ * \brief initialize the Curve module - all inputs are linear, with a rate of 100 %, without deadzone
+ * and centered at 1500 us
+ */
+void Curve::begin()
+{
+  for (uint8_t sel = 0; sel < NUM_RC_IN_CHANNELS; sel++)
+  {
+    CurveData[sel].type = CURVE_LINEAR;
+    CurveData[sel].expo_row = 0;
+    CurveData[sel].points = 0;
+    CurveData[sel].points_shift = 0;
+    CurveData[sel].num_points = 0;
+    CurveData[sel].rate_scale = RATE_SCALE_100_PERCENT;
+    CurveData[sel].deadzone_us = 0;
+    CurveData[sel].deadzone_scale = 256;
+    CurveData[sel].center_us = CENTER_PULSE_DURATION_US;
+  }
+}
+
+/**
+ * \brief use a linear curve for the selected input
+ */
+void Curve::setLinear(E_RC_IN_SELECT const sel)
+{
+  CurveData[sel].type = CURVE_LINEAR;
+}
+
+/**
+ * \brief use an expo curve for the selected input, expo_percent = 0 ... 100 % (rounded to 10 %)
+ */
+void Curve::setExpo(E_RC_IN_SELECT const sel, uint8_t const expo_percent)
+{
+  uint8_t const expo_row = (expo_percent + EXPO_STEP_PERCENT / 2) / EXPO_STEP_PERCENT;
+
+  CurveData[sel].type = CURVE_EXPO;
+  CurveData[sel].expo_row = (expo_row >= NUM_EXPO_ROWS) ? (NUM_EXPO_ROWS - 1) : expo_row;
+}
+
+/**
+ * \brief use a n-point curve for the selected input. points is an array of num_points (3, 5, 9 or 17)
+ * offsets from 1500 us stored in the flash memory (PROGMEM) which are equally distributed over
+ * 1500 - 512 us ... 1500 + 512 us. Returns false if num_points is not supported.
+ */
+bool Curve::setPoints(E_RC_IN_SELECT const sel, int16_t const * points, uint8_t const num_points)
+{
+  uint8_t points_shift = 0;
+
+  /* The distance between two points has to be a power of two
+   * to avoid a division when interpolating
+   */
+
+  switch (num_points)
+  {
+  case 3:  points_shift = 9; break;
+  case 5:  points_shift = 8; break;
+  case 9:  points_shift = 7; break;
+  case 17: points_shift = 6; break;
+  default: return false;
+  }
+
+  CurveData[sel].type = CURVE_POINTS;
+  CurveData[sel].points = points;
+  CurveData[sel].points_shift = points_shift;
+  CurveData[sel].num_points = num_points;
+
+  return true;
+}
+
+/**
+ * \brief set the rate (dual rate) of the selected input, rate_percent = 0 ... 100 %
+ */
+void Curve::setRate(E_RC_IN_SELECT const sel, uint8_t const rate_percent)
+{
+  uint16_t const limited_rate_percent = (rate_percent > 100) ? 100 : rate_percent;
+
+  CurveData[sel].rate_scale = (limited_rate_percent * RATE_SCALE_100_PERCENT) / 100;
+}
+
+/**
+ * \brief set the deadzone around 1500 us of the selected input (0 ... 256 us). The output is
+ * 1500 us within the deadzone and rises continuously from the edge of the deadzone.
+ */
+void Curve::setDeadzone(E_RC_IN_SELECT const sel, uint16_t const deadzone_us)
+{
+  uint16_t const limited_deadzone_us = (deadzone_us > MAX_DEADZONE_US) ? MAX_DEADZONE_US : deadzone_us;
+
+  CurveData[sel].deadzone_us = limited_deadzone_us;
+  CurveData[sel].deadzone_scale = ((uint32_t) (DOMAIN_US) << 8) / (DOMAIN_US - limited_deadzone_us);
+}
+
+/**
+ * \brief set the input pulse duration of the stick center of the selected input (1500 +/- 100 us),
+ * it is mapped to 1500 us (center trim)
+ */
+void Curve::setCenter(E_RC_IN_SELECT const sel, uint16_t const center_us)
+{
+  uint16_t limited_center_us = center_us;
+  if (limited_center_us < CENTER_PULSE_DURATION_US - MAX_CENTER_OFFSET_US)
+  {
+    limited_center_us = CENTER_PULSE_DURATION_US - MAX_CENTER_OFFSET_US;
+  }
+  if (limited_center_us > CENTER_PULSE_DURATION_US + MAX_CENTER_OFFSET_US)
+  {
+    limited_center_us = CENTER_PULSE_DURATION_US + MAX_CENTER_OFFSET_US;
+  }
+
+  CurveData[sel].center_us = limited_center_us;
+}
+
+/**
+ * \brief maps the pulse duration through the curve of the selected input
+ */
+uint16_t Curve::apply(E_RC_IN_SELECT const sel, uint16_t const pulse_duration_us)
+{
+  T_CURVE_DATA const & curve = CurveData[sel];
+
+  int16_t value_us = (int16_t) (pulse_duration_us) - (int16_t) (curve.center_us);
+
+  if (value_us > DOMAIN_US)
+  {
+    value_us = DOMAIN_US;
+  }
+  else if (value_us < -DOMAIN_US)
+  {
+    value_us = -DOMAIN_US;
+  }
+
+  bool const is_negative = (value_us < 0);
+  uint16_t magnitude_us = is_negative ? -value_us : value_us;
+
+  magnitude_us = applyCurveDeadzone(curve, magnitude_us);
+
+  switch (curve.type)
+  {
+  case CURVE_EXPO:
+  {
+    magnitude_us = lookupCurveExpo(curve.expo_row, magnitude_us);
+    value_us = is_negative ? -(int16_t) (magnitude_us) : (int16_t) (magnitude_us);
+  }
+  break;
+  case CURVE_POINTS:
+  {
+    value_us = lookupCurvePoints(curve, is_negative ? -(int16_t) (magnitude_us) : (int16_t) (magnitude_us));
+  }
+  break;
+  case CURVE_LINEAR:
+  default:
+  {
+    value_us = is_negative ? -(int16_t) (magnitude_us) : (int16_t) (magnitude_us);
+  }
+  break;
+  }
+
+  if (curve.rate_scale != RATE_SCALE_100_PERCENT)
+  {
+    value_us = (int16_t) (((int32_t) (value_us) * curve.rate_scale) >> 8);
+  }
+
+  return (uint16_t) ((int16_t) (CENTER_PULSE_DURATION_US) + value_us);
+}
+
+/**
+ * \brief returns the pulse duration of the selected input mapped through its curve
+ */
+uint16_t Curve::getPulseDurationUs(E_RC_IN_SELECT const sel)
+{
+  return apply(sel, RcIn::getPulseDurationUs(sel));
+}
+
+#endif
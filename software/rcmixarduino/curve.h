@@ -0,0 +1,129 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CURVE_H_
+#define CURVE_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+#include "rcin.h"
+
+#ifdef CONFIG_USE_CURVE
+
+/************************************************************************/
+/* PUBLIC TYPES                                                         */
+/************************************************************************/
+
+typedef enum
+{
+  CURVE_LINEAR = 0, CURVE_EXPO = 1, CURVE_POINTS = 2
+} E_CURVE_TYPE;
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+/* The curve engine maps the pulse duration of an input channel within
+ * 1500 +/- 512 us to an output pulse duration within the same range:
+ *
+ *   center trim -> smooth deadzone -> curve (linear, expo or n-point) -> rate
+ *
+ * All curves are evaluated by linear interpolation of tables stored in
+ * the flash memory (expo tables see curve_tables.h, generated by
+ * software/tools/curve_tables.py).
+ */
+
+class Curve
+{
+
+public:
+
+  /**
+   * \brief initialize the Curve module - all inputs are linear, with a rate of 100 %, without deadzone
+   * and centered at 1500 us
+   */
+  static void begin();
+
+  /**
+   * \brief use a linear curve for the selected input
+   */
+  static void setLinear(E_RC_IN_SELECT const sel);
+
+  /**
+   * \brief use an expo curve for the selected input, expo_percent = 0 ... 100 % (rounded to 10 %)
+   */
+  static void setExpo(E_RC_IN_SELECT const sel, uint8_t const expo_percent);
+
+  /**
+   * \brief use a n-point curve for the selected input. points is an array of num_points (3, 5, 9 or 17)
+   * offsets from 1500 us stored in the flash memory (PROGMEM) which are equally distributed over
+   * 1500 - 512 us ... 1500 + 512 us. Returns false if num_points is not supported.
+   */
+  static bool setPoints(E_RC_IN_SELECT const sel, int16_t const * points, uint8_t const num_points);
+
+  /**
+   * \brief set the rate (dual rate) of the selected input, rate_percent = 0 ... 100 %
+   */
+  static void setRate(E_RC_IN_SELECT const sel, uint8_t const rate_percent);
+
+  /**
+   * \brief set the deadzone around 1500 us of the selected input (0 ... 256 us). The output is
+   * 1500 us within the deadzone and rises continuously from the edge of the deadzone.
+   */
+  static void setDeadzone(E_RC_IN_SELECT const sel, uint16_t const deadzone_us);
+
+  /**
+   * \brief set the input pulse duration of the stick center of the selected input (1500 +/- 100 us),
+   * it is mapped to 1500 us (center trim)
+   */
+  static void setCenter(E_RC_IN_SELECT const sel, uint16_t const center_us);
+
+  /**
+   * \brief maps the pulse duration through the curve of the selected input
+   */
+  static uint16_t apply(E_RC_IN_SELECT const sel, uint16_t const pulse_duration_us);
+
+  /**
+   * \brief returns the pulse duration of the selected input mapped through its curve
+   */
+  static uint16_t getPulseDurationUs(E_RC_IN_SELECT const sel);
+
+private:
+
+  /**
+   * \brief no public constructing
+   */
+  Curve() { }
+};
+
+#endif
+
+#endif /* CURVE_H_ */
@@ -0,0 +1,53 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Generated by software/tools/curve_tables.py - do not edit */
+
+#ifndef CURVE_TABLES_H_
+#define CURVE_TABLES_H_
+
+#include <stdint.h>
+
+#include <avr/pgmspace.h>
+
+/* y = (1 - e) * x + e * x^3 for 0 <= x <= 512 us in steps of 32 us,
+ * one row per 10 % of expo (e = 0 % ... 100 %)
+ */
+
+static uint16_t const CURVE_EXPO_TABLE[11][17] PROGMEM =
+{
+  {  0,  32,  64,  96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 480, 512}, /*   0 % */
+  {  0,  29,  58,  87, 116, 146, 176, 206, 237, 268, 300, 333, 367, 402, 438, 474, 512}, /*  10 % */
+  {  0,  26,  51,  77, 104, 131, 159, 188, 218, 249, 281, 315, 350, 388, 427, 468, 512}, /*  20 % */
+  {  0,  22,  45,  68,  92, 117, 142, 170, 198, 229, 262, 296, 334, 374, 416, 463, 512}, /*  30 % */
+  {  0,  19,  39,  59,  80, 102, 126, 152, 179, 209, 242, 278, 317, 359, 406, 457, 512}, /*  40 % */
+  {  0,  16,  32,  50,  68,  88, 110, 133, 160, 190, 222, 259, 300, 345, 396, 451, 512}, /*  50 % */
+  {  0,  13,  26,  40,  56,  73,  93, 115, 141, 170, 203, 241, 283, 331, 385, 445, 512}, /*  60 % */
+  {  0,  10,  20,  31,  44,  59,  76,  97, 122, 150, 184, 222, 266, 317, 374, 439, 512}, /*  70 % */
+  {  0,   6,  14,  22,  32,  44,  60,  79, 102, 130, 164, 204, 250, 303, 364, 434, 512}, /*  80 % */
+  {  0,   3,   7,  13,  20,  30,  44,  61,  83, 111, 144, 185, 233, 289, 354, 428, 512}, /*  90 % */
+  {  0,   0,   1,   3,   8,  16,  27,  43,  64,  91, 125, 166, 216, 275, 343, 422, 512} /* 100 % */
+};
+
+#endif /* CURVE_TABLES_H_ */
@@ -0,0 +1,411 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "eventlog.h"
+
+#include <avr/eeprom.h>
+
+#ifdef CONFIG_USE_EVENT_LOG
+
+#include "rcin.h"
+#include "scheduler.h"
+
+#if defined(CONFIG_USE_WATCHDOG)
+#include "watchdog.h"
+#endif
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+/* EEPROM layout of the log (0x100 ... 0x2FF between the parameter store
+ * and the bytecode program): a ring of 64 records of 8 bytes
+ *
+ *   [sequence] [type << 4 | channel] [value] [time ms:4] [checksum]
+ *
+ * The sequence number is incremented with every record, the newest record
+ * is the one which is not followed by its successor. The checksum is
+ * chosen so that the sum of all bytes of the record is EVENT_LOG_CHECKSUM,
+ * an erased EEPROM or a record which was interrupted by a reset is not
+ * valid. Every record is written once per 64 events.
+ */
+
+static uint16_t const EEPROM_EVENT_LOG_ADDRESS = 0x100;
+
+static uint8_t const EVENT_LOG_RECORD_SIZE = 8;
+static uint8_t const EVENT_LOG_NUM_RECORDS = 64;
+static uint8_t const EVENT_LOG_CHECKSUM    = 0xA5;
+
+static uint8_t const NUM_RC_IN_CHANNELS = 4;
+
+static uint8_t const EVENT_LOG_QUEUE_SIZE = 8;
+
+/* Reset cause logged with EVENT_BOOT if it is unknown */
+
+static uint8_t const EVENT_LOG_UNKNOWN_RESET_CAUSE = 0xFF;
+
+/* At most one record is written per EVENT_LOG_MIN_RECORD_PERIOD_MS - a
+ * flapping input fills the queue instead of wearing out the EEPROM, the
+ * events in excess are counted by EVENT_EVENTS_DROPPED
+ */
+
+static uint16_t const EVENT_LOG_MIN_RECORD_PERIOD_MS = 500;
+
+/* Rejected pulses are counted within a window of one second, single
+ * glitches are not logged
+ */
+
+static uint16_t const EVENT_LOG_REJECT_WINDOW_MS     = 1000;
+static uint8_t  const EVENT_LOG_MIN_REJECTED_PULSES = 5;
+
+/************************************************************************/
+/* PRIVATE DATA                                                         */
+/************************************************************************/
+
+/* All data is only accessed from the main loop */
+
+static T_EVENT_LOG_ENTRY EventLogQueue[EVENT_LOG_QUEUE_SIZE];
+static uint8_t           EventLogQueueHead    = 0;
+static uint8_t           EventLogQueueCount   = 0;
+static uint8_t           EventLogDroppedCount = 0;
+
+/* Record which is written to the EEPROM byte by byte */
+
+static uint8_t  EventLogRecordImage[EVENT_LOG_RECORD_SIZE];
+static uint8_t  EventLogRecordWriteIndex = EVENT_LOG_RECORD_SIZE;
+static uint8_t  EventLogWriteSlot        = 0;
+static uint8_t  EventLogWriteSequence    = 0;
+static uint8_t  EventLogNumRecords       = 0;
+static uint32_t EventLogLastRecordTimeMs = 0;
+
+static uint32_t EventLogTimeMs   = 0;
+static uint16_t EventLogLastTick = 0;
+
+/* State of the event detection */
+
+static bool     EventLogIsMixing = false;
+static bool     EventLogInputIsGood[NUM_RC_IN_CHANNELS];
+static uint8_t  EventLogRejectedPulseCount[NUM_RC_IN_CHANNELS];
+static uint8_t  EventLogRejectedInWindow[NUM_RC_IN_CHANNELS];
+static uint32_t EventLogRejectWindowStartMs = 0;
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+/**
+ * \brief read a record from the EEPROM, returns false if the record is not valid
+ */
+bool readEventLogRecord(uint8_t const slot, uint8_t * record)
+{
+  uint8_t const * address = (uint8_t const *) (EEPROM_EVENT_LOG_ADDRESS) + slot * EVENT_LOG_RECORD_SIZE;
+  uint8_t sum = 0;
+
+  for (uint8_t i = 0; i < EVENT_LOG_RECORD_SIZE; i++)
+  {
+    record[i] = eeprom_read_byte(address++);
+    sum += record[i];
+  }
+
+  return sum == EVENT_LOG_CHECKSUM;
+}
+
+/**
+ * \brief returns true if the record in slot is valid and has the given sequence number
+ */
+bool isEventLogRecord(uint8_t const slot, uint8_t const sequence)
+{
+  uint8_t record[EVENT_LOG_RECORD_SIZE];
+
+  return readEventLogRecord(slot, record) && record[0] == sequence;
+}
+
+/**
+ * \brief add an event to the queue, it is dropped if the queue is full
+ */
+void queueEvent(E_EVENT_TYPE const type, uint8_t const channel, uint8_t const value)
+{
+  if (EventLogQueueCount == EVENT_LOG_QUEUE_SIZE)
+  {
+    if (EventLogDroppedCount < 0xFF)
+    {
+      EventLogDroppedCount++;
+    }
+    return;
+  }
+
+  T_EVENT_LOG_ENTRY & entry = EventLogQueue[(EventLogQueueHead + EventLogQueueCount) % EVENT_LOG_QUEUE_SIZE];
+
+  entry.type    = type;
+  entry.channel = channel;
+  entry.value   = value;
+  entry.time_ms = EventLogTimeMs;
+
+  EventLogQueueCount++;
+}
+
+/**
+ * \brief compare the state of the inputs and of the control with the last call and
+ * queue an event for every change
+ */
+void detectEvents(bool const is_mixing)
+{
+  bool const is_reject_window_complete = (EventLogTimeMs - EventLogRejectWindowStartMs) >= EVENT_LOG_REJECT_WINDOW_MS;
+
+  for (uint8_t sel = IN1; sel <= IN4; sel++)
+  {
+    bool const is_good = RcIn::isGood((E_RC_IN_SELECT) (sel));
+
+    if (is_good != EventLogInputIsGood[sel])
+    {
+      EventLogInputIsGood[sel] = is_good;
+      queueEvent(is_good ? EVENT_INPUT_GOOD : EVENT_INPUT_LOST, sel, 0);
+    }
+
+    uint8_t const rejected_pulse_count = RcIn::getRejectedPulseCount((E_RC_IN_SELECT) (sel));
+    uint8_t const rejected_pulses = rejected_pulse_count - EventLogRejectedPulseCount[sel];
+
+    EventLogRejectedPulseCount[sel] = rejected_pulse_count;
+    EventLogRejectedInWindow[sel] = (EventLogRejectedInWindow[sel] > 0xFF - rejected_pulses)
+        ? 0xFF : (EventLogRejectedInWindow[sel] + rejected_pulses);
+
+    if (is_reject_window_complete)
+    {
+      if (EventLogRejectedInWindow[sel] >= EVENT_LOG_MIN_REJECTED_PULSES)
+      {
+        queueEvent(EVENT_PULSES_REJECTED, sel, EventLogRejectedInWindow[sel]);
+      }
+      EventLogRejectedInWindow[sel] = 0;
+    }
+  }
+
+  if (is_reject_window_complete)
+  {
+    EventLogRejectWindowStartMs = EventLogTimeMs;
+  }
+
+  if (is_mixing != EventLogIsMixing)
+  {
+    EventLogIsMixing = is_mixing;
+    queueEvent(is_mixing ? EVENT_FAILSAFE_EXITED : EVENT_FAILSAFE_ENTERED, 0, 0);
+  }
+
+  if (EventLogDroppedCount > 0 && EventLogQueueCount < EVENT_LOG_QUEUE_SIZE)
+  {
+    queueEvent(EVENT_EVENTS_DROPPED, 0, EventLogDroppedCount);
+    EventLogDroppedCount = 0;
+  }
+}
+
+/**
+ * \brief take the oldest event from the queue and prepare its record for writing
+ */
+void startEventLogRecord()
+{
+  T_EVENT_LOG_ENTRY const & entry = EventLogQueue[EventLogQueueHead];
+
+  uint8_t * ptr = EventLogRecordImage;
+
+  *ptr++ = EventLogWriteSequence;
+  *ptr++ = (uint8_t) (entry.type << 4) | (entry.channel & 0x0F);
+  *ptr++ = entry.value;
+  *ptr++ = (uint8_t) (entry.time_ms);
+  *ptr++ = (uint8_t) (entry.time_ms >> 8);
+  *ptr++ = (uint8_t) (entry.time_ms >> 16);
+  *ptr++ = (uint8_t) (entry.time_ms >> 24);
+
+  uint8_t sum = 0;
+  for (uint8_t * p = EventLogRecordImage; p < ptr; p++)
+  {
+    sum += *p;
+  }
+  *ptr++ = EVENT_LOG_CHECKSUM - sum;
+
+  EventLogQueueHead = (EventLogQueueHead + 1) % EVENT_LOG_QUEUE_SIZE;
+  EventLogQueueCount--;
+
+  /* The oldest record is overwritten, it is not part of the log anymore */
+
+  if (EventLogNumRecords == EVENT_LOG_NUM_RECORDS)
+  {
+    EventLogNumRecords--;
+  }
+
+  EventLogRecordWriteIndex = 0;
+  EventLogLastRecordTimeMs = EventLogTimeMs;
+}
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+/**
+ * \brief find the newest record in the EEPROM and log the start of the firmware
+ * together with the cause of the reset - has to be called after Watchdog::begin
+ */
+void EventLog::begin()
+{
+  uint8_t record[EVENT_LOG_RECORD_SIZE];
+
+  EventLogWriteSlot = 0;
+  EventLogWriteSequence = 0;
+  EventLogNumRecords = 0;
+
+  for (uint8_t slot = 0; slot < EVENT_LOG_NUM_RECORDS; slot++)
+  {
+    uint8_t const next_slot = (slot + 1) % EVENT_LOG_NUM_RECORDS;
+
+    if (readEventLogRecord(slot, record) && !isEventLogRecord(next_slot, record[0] + 1))
+    {
+      /* Count the records back from the newest one */
+
+      uint8_t sequence = record[0];
+      uint8_t count_slot = slot;
+
+      do
+      {
+        EventLogNumRecords++;
+        sequence--;
+        count_slot = (count_slot + EVENT_LOG_NUM_RECORDS - 1) % EVENT_LOG_NUM_RECORDS;
+      } while (EventLogNumRecords < EVENT_LOG_NUM_RECORDS && isEventLogRecord(count_slot, sequence));
+
+      EventLogWriteSlot = next_slot;
+      EventLogWriteSequence = record[0] + 1;
+      break;
+    }
+  }
+
+  for (uint8_t sel = IN1; sel <= IN4; sel++)
+  {
+    EventLogInputIsGood[sel] = false;
+    EventLogRejectedPulseCount[sel] = RcIn::getRejectedPulseCount((E_RC_IN_SELECT) (sel));
+    EventLogRejectedInWindow[sel] = 0;
+  }
+
+#if defined(CONFIG_USE_WATCHDOG)
+  T_WATCHDOG_RESET_INFO info;
+  Watchdog::getResetInfo(&info);
+  queueEvent(EVENT_BOOT, 0, info.cause);
+#else
+  queueEvent(EVENT_BOOT, 0, EVENT_LOG_UNKNOWN_RESET_CAUSE);
+#endif
+
+  /* The first record is written immediately */
+
+  EventLogLastRecordTimeMs = EventLogTimeMs - EVENT_LOG_MIN_RECORD_PERIOD_MS;
+}
+
+/**
+ * \brief detect the events, write queued events to the EEPROM if it is ready (never
+ * waits) - has to be called periodically from a low priority task
+ */
+void EventLog::process(bool const is_mixing)
+{
+  uint16_t const tick = Scheduler::getTick();
+
+  EventLogTimeMs += (uint16_t) (tick - EventLogLastTick);
+  EventLogLastTick = tick;
+
+  detectEvents(is_mixing);
+
+  if (EventLogRecordWriteIndex == EVENT_LOG_RECORD_SIZE)
+  {
+    if (EventLogQueueCount == 0 || (EventLogTimeMs - EventLogLastRecordTimeMs) < EVENT_LOG_MIN_RECORD_PERIOD_MS)
+    {
+      return;
+    }
+
+    startEventLogRecord();
+  }
+
+  /* Writing one byte takes 3.4 ms, eeprom_update_byte would wait for the
+   * completion of the previous write (see Param::process)
+   */
+
+  uint8_t * const address = (uint8_t *) (EEPROM_EVENT_LOG_ADDRESS) + EventLogWriteSlot * EVENT_LOG_RECORD_SIZE;
+
+  while (EventLogRecordWriteIndex < EVENT_LOG_RECORD_SIZE && eeprom_is_ready())
+  {
+    uint8_t const value = EventLogRecordImage[EventLogRecordWriteIndex];
+
+    if (eeprom_read_byte(address + EventLogRecordWriteIndex) != value)
+    {
+      eeprom_write_byte(address + EventLogRecordWriteIndex, value);
+      EventLogRecordWriteIndex++;
+      break;
+    }
+
+    EventLogRecordWriteIndex++;
+  }
+
+  if (EventLogRecordWriteIndex == EVENT_LOG_RECORD_SIZE)
+  {
+    EventLogWriteSlot = (EventLogWriteSlot + 1) % EVENT_LOG_NUM_RECORDS;
+    EventLogWriteSequence++;
+    EventLogNumRecords++;
+  }
+}
+
+/**
+ * \brief returns the number of records in the log
+ */
+uint8_t EventLog::getNumEntries()
+{
+  return EventLogNumRecords;
+}
+
+/**
+ * \brief read a record from the log (0 = oldest), returns false if the index is out
+ * of range or the EEPROM is busy with a write
+ */
+bool EventLog::getEntry(uint8_t const index, T_EVENT_LOG_ENTRY * entry)
+{
+  /* eeprom_read_byte would wait for the completion of a write */
+
+  if (index >= EventLogNumRecords || !eeprom_is_ready())
+  {
+    return false;
+  }
+
+  uint8_t const slot = (EventLogWriteSlot + EVENT_LOG_NUM_RECORDS - EventLogNumRecords + index) % EVENT_LOG_NUM_RECORDS;
+  uint8_t record[EVENT_LOG_RECORD_SIZE];
+
+  if (!readEventLogRecord(slot, record))
+  {
+    return false;
+  }
+
+  entry->type    = (E_EVENT_TYPE) (record[1] >> 4);
+  entry->channel = record[1] & 0x0F;
+  entry->value   = record[2];
+  entry->time_ms = record[3] | ((uint32_t) (record[4]) << 8) | ((uint32_t) (record[5]) << 16) | ((uint32_t) (record[6]) << 24);
+
+  return true;
+}
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EVENTLOG_H_
+#define EVENTLOG_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+#ifdef CONFIG_USE_EVENT_LOG
+
+/************************************************************************/
+/* PUBLIC TYPES                                                         */
+/************************************************************************/
+
+/* Has to match EVENT_TYPES in software/tools/rcmixcfg.py */
+
+typedef enum
+{
+  EVENT_BOOT             = 0, /* value: cause of the reset (E_RESET_CAUSE, 0xFF without the watchdog) */
+  EVENT_INPUT_LOST       = 1, /* channel: input which has lost its signals */
+  EVENT_INPUT_GOOD       = 2, /* channel: input which receives valid signals (again) */
+  EVENT_PULSES_REJECTED  = 3, /* channel: input, value: number of pulses out of range within one second */
+  EVENT_FAILSAFE_ENTERED = 4, /* The control has entered failsafe */
+  EVENT_FAILSAFE_EXITED  = 5, /* The control is mixing again */
+  EVENT_EVENTS_DROPPED   = 6  /* value: number of events lost because the queue was full */
+} E_EVENT_TYPE;
+
+typedef struct
+{
+  E_EVENT_TYPE type;
+  uint8_t      channel;
+  uint8_t      value;
+  uint32_t     time_ms;   /* Time since the start of the firmware */
+} T_EVENT_LOG_ENTRY;
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+/* Flight recorder of failsafe and anomaly events. The events are detected
+ * by process() from the main loop (never from an isr), queued in RAM and
+ * written to a ring of records in the EEPROM one byte per call, so that
+ * logging never delays the mixing. Every event is written to the next
+ * record of the ring, the EEPROM cells therefore wear evenly. The log
+ * survives a power cycle and is read with the EVENT_LOG_READ command.
+ */
+
+class EventLog
+{
+
+public:
+
+  /**
+   * \brief find the newest record in the EEPROM and log the start of the firmware
+   * together with the cause of the reset - has to be called after Watchdog::begin
+   */
+  static void begin();
+
+  /**
+   * \brief detect the events, write queued events to the EEPROM if it is ready (never
+   * waits) - has to be called periodically from a low priority task
+   */
+  static void process(bool const is_mixing);
+
+  /**
+   * \brief returns the number of records in the log
+   */
+  static uint8_t getNumEntries();
+
+  /**
+   * \brief read a record from the log (0 = oldest), returns false if the index is out
+   * of range or the record is damaged
+   */
+  static bool getEntry(uint8_t const index, T_EVENT_LOG_ENTRY * entry);
+
+private:
+
+  /**
+   * \brief no public constructing
+   */
+  EventLog() { }
+};
+
+#endif
+
+#endif /* EVENTLOG_H_ */
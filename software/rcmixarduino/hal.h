@@ -35,6 +35,10 @@
 /* DEFINES                                                              */
 /************************************************************************/
 
+/* The outputs are distributed over PORTB, PORTC and PORTD - RcOut
+ * writes all edges of one port with a single store
+ */
+
 /* OUT1 = PD7 */
 
 #define OUT1_DDR		(DDRD)
@@ -0,0 +1,234 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "hostlink.h"
+
+#ifdef CONFIG_USE_HOST_CONTROL
+
+#include "rcin.h"
+#include "rcout.h"
+#include "scheduler.h"
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+static uint8_t const NUM_RC_IN_CHANNELS = 4;
+static uint8_t const NUM_RC_OUT_CHANNELS = 6;
+
+static uint16_t const DEFAULT_TIMEOUT_MS = 100;
+
+static uint16_t const MIN_PULSE_DURATION_US = 800;
+static uint16_t const MAX_PULSE_DURATION_US = 2200;
+
+/************************************************************************/
+/* PRIVATE DATA                                                         */
+/************************************************************************/
+
+/* Changed by commands and read by the mix path, both are executed from
+ * the main loop - no locking is necessary
+ */
+
+static E_HOST_LINK_STATE HostLinkState           = HOST_LINK_IDLE;
+static E_HOST_FALLBACK   HostLinkFallback        = HOST_FALLBACK_RC;
+static uint16_t          HostLinkTimeoutMs       = DEFAULT_TIMEOUT_MS;
+static uint16_t          HostLinkLastCommandTick = 0;
+
+static uint8_t           HostLinkOutputMask      = 0;
+static uint16_t          HostLinkOutputPulseDurationUs[NUM_RC_OUT_CHANNELS];
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+/**
+ * \brief returns true if all pulse durations selected by mask are valid
+ */
+bool isHostLinkPulseDurationValid(uint8_t const mask, uint16_t const * pulse_duration_us, uint8_t const num_channels)
+{
+  for (uint8_t i = 0; i < num_channels; i++)
+  {
+    if ((mask & (1 << i)) && (pulse_duration_us[i] < MIN_PULSE_DURATION_US || pulse_duration_us[i] > MAX_PULSE_DURATION_US))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * \brief override the inputs selected by mask, all other inputs are received again
+ */
+void setHostLinkInputOverride(uint8_t const mask, uint16_t const * pulse_duration_us)
+{
+  for (uint8_t i = 0; i < NUM_RC_IN_CHANNELS; i++)
+  {
+    if (mask & (1 << i))
+    {
+      RcIn::setOverride((E_RC_IN_SELECT) (i), pulse_duration_us[i]);
+    }
+    else
+    {
+      RcIn::clearOverride((E_RC_IN_SELECT) (i));
+    }
+  }
+}
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+/**
+ * \brief initialize the HostLink module - timeout 100 ms, fallback to rc control
+ */
+void HostLink::begin()
+{
+  HostLinkState = HOST_LINK_IDLE;
+  HostLinkFallback = HOST_FALLBACK_RC;
+  HostLinkTimeoutMs = DEFAULT_TIMEOUT_MS;
+  HostLinkOutputMask = 0;
+}
+
+/**
+ * \brief set the time after the last command of the host after which the link is lost
+ */
+void HostLink::setTimeoutMs(uint16_t const timeout_ms)
+{
+  HostLinkTimeoutMs = timeout_ms;
+}
+
+/**
+ * \brief set the action taken when the link is lost
+ */
+void HostLink::setFallback(E_HOST_FALLBACK const fallback)
+{
+  HostLinkFallback = fallback;
+}
+
+/**
+ * \brief override the mixer inputs selected by mask (bit 0 = IN1) with pulse_duration_us,
+ * returns false (and changes nothing) if a pulse duration is invalid
+ */
+bool HostLink::setInputs(uint8_t const mask, uint16_t const * pulse_duration_us)
+{
+  if (!isHostLinkPulseDurationValid(mask, pulse_duration_us, NUM_RC_IN_CHANNELS))
+  {
+    return false;
+  }
+
+  setHostLinkInputOverride(mask, pulse_duration_us);
+
+  HostLinkOutputMask = 0;
+  HostLinkState = HOST_LINK_INPUTS;
+  HostLinkLastCommandTick = Scheduler::getTick();
+
+  return true;
+}
+
+/**
+ * \brief set the outputs selected by mask (bit 0 = OUT1) to pulse_duration_us and bypass
+ * the mixer, returns false (and changes nothing) if a pulse duration is invalid
+ */
+bool HostLink::setOutputs(uint8_t const mask, uint16_t const * pulse_duration_us)
+{
+  if (!isHostLinkPulseDurationValid(mask, pulse_duration_us, NUM_RC_OUT_CHANNELS))
+  {
+    return false;
+  }
+
+  setHostLinkInputOverride(0, 0);
+
+  for (uint8_t i = 0; i < NUM_RC_OUT_CHANNELS; i++)
+  {
+    HostLinkOutputPulseDurationUs[i] = pulse_duration_us[i];
+  }
+
+  HostLinkOutputMask = mask;
+  HostLinkState = HOST_LINK_OUTPUTS;
+  HostLinkLastCommandTick = Scheduler::getTick();
+
+  return true;
+}
+
+/**
+ * \brief hand the control back to the rc inputs
+ */
+void HostLink::release()
+{
+  setHostLinkInputOverride(0, 0);
+
+  HostLinkOutputMask = 0;
+  HostLinkState = HOST_LINK_IDLE;
+}
+
+/**
+ * \brief check the link watchdog and return the state of the link - has to be called
+ * from the mix path
+ */
+E_HOST_LINK_STATE HostLink::update()
+{
+  if (HostLinkState != HOST_LINK_INPUTS && HostLinkState != HOST_LINK_OUTPUTS)
+  {
+    return HostLinkState;
+  }
+
+  if ((uint16_t) (Scheduler::getTick() - HostLinkLastCommandTick) > HostLinkTimeoutMs)
+  {
+    setHostLinkInputOverride(0, 0);
+
+    HostLinkOutputMask = 0;
+    HostLinkState = (HostLinkFallback == HOST_FALLBACK_FAILSAFE) ? HOST_LINK_LOST : HOST_LINK_IDLE;
+  }
+
+  return HostLinkState;
+}
+
+/**
+ * \brief returns the outputs set by the host (bit 0 = OUT1) in state HOST_LINK_OUTPUTS
+ */
+uint8_t HostLink::getOutputMask()
+{
+  return HostLinkOutputMask;
+}
+
+/**
+ * \brief write the outputs set by the host to RcOut (state HOST_LINK_OUTPUTS)
+ */
+void HostLink::applyOutputs()
+{
+  for (uint8_t i = 0; i < NUM_RC_OUT_CHANNELS; i++)
+  {
+    if (HostLinkOutputMask & (1 << i))
+    {
+      RcOut::setPwmPulseDurationUs((E_RC_OUT_SELECT) (i), HostLinkOutputPulseDurationUs[i]);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef HOSTLINK_H_
+#define HOSTLINK_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+#ifdef CONFIG_USE_HOST_CONTROL
+
+/************************************************************************/
+/* PUBLIC TYPES                                                         */
+/************************************************************************/
+
+typedef enum
+{
+  HOST_LINK_IDLE,    /* The rc inputs control the mixer */
+  HOST_LINK_INPUTS,  /* The host overrides mixer inputs (see RcIn::setOverride) */
+  HOST_LINK_OUTPUTS, /* The host sets the outputs directly, the mixer is bypassed */
+  HOST_LINK_LOST     /* The link timed out, failsafe until the host resumes or releases */
+} E_HOST_LINK_STATE;
+
+/* Action taken when the host has not sent a command within the timeout */
+
+typedef enum
+{
+  HOST_FALLBACK_RC       = 0, /* Return to rc control (failsafe if the rc inputs are not good) */
+  HOST_FALLBACK_FAILSAFE = 1  /* Failsafe until the host resumes or releases the control */
+} E_HOST_FALLBACK;
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+/* Control of the mixer by a host computer over USB (see the HOST_*
+ * commands in command.h). Every command of the host retriggers the link
+ * watchdog, the link falls back according to the fallback policy if no
+ * command is received within the timeout. The arbitration between rc and
+ * host happens in the mixer adapter ControlHost (control_host.h).
+ */
+
+class HostLink
+{
+
+public:
+
+  /**
+   * \brief initialize the HostLink module - timeout 100 ms, fallback to rc control
+   */
+  static void begin();
+
+  /**
+   * \brief set the time after the last command of the host after which the link is lost
+   */
+  static void setTimeoutMs(uint16_t const timeout_ms);
+
+  /**
+   * \brief set the action taken when the link is lost
+   */
+  static void setFallback(E_HOST_FALLBACK const fallback);
+
+  /**
+   * \brief override the mixer inputs selected by mask (bit 0 = IN1) with pulse_duration_us,
+   * returns false (and changes nothing) if a pulse duration is invalid
+   */
+  static bool setInputs(uint8_t const mask, uint16_t const * pulse_duration_us);
+
+  /**
+   * \brief set the outputs selected by mask (bit 0 = OUT1) to pulse_duration_us and bypass
+   * the mixer, returns false (and changes nothing) if a pulse duration is invalid
+   */
+  static bool setOutputs(uint8_t const mask, uint16_t const * pulse_duration_us);
+
+  /**
+   * \brief hand the control back to the rc inputs
+   */
+  static void release();
+
+  /**
+   * \brief check the link watchdog and return the state of the link - has to be called
+   * from the mix path
+   */
+  static E_HOST_LINK_STATE update();
+
+  /**
+   * \brief returns the outputs set by the host (bit 0 = OUT1) in state HOST_LINK_OUTPUTS
+   */
+  static uint8_t getOutputMask();
+
+  /**
+   * \brief write the outputs set by the host to RcOut (state HOST_LINK_OUTPUTS)
+   */
+  static void applyOutputs();
+
+private:
+
+  /**
+   * \brief no public constructing
+   */
+  HostLink() { }
+};
+
+#endif
+
+#endif /* HOSTLINK_H_ */
@@ -0,0 +1,350 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "joystick.h"
+
+#ifdef CONFIG_USE_JOYSTICK
+
+#include <Arduino.h>
+#include <HID.h>
+
+#include <avr/pgmspace.h>
+
+#if defined(CONFIG_USE_IDLE_SLEEP)
+#include "scheduler.h"
+#endif
+
+/************************************************************************/
+/* PRIVATE TYPEDEFS                                                     */
+/************************************************************************/
+
+typedef struct
+{
+  uint16_t center_us;
+  uint32_t positive_scale;  /* MAX_AXIS_VALUE / (max_us - center_us) as 22.10 fixed point value */
+  uint32_t negative_scale;  /* MAX_AXIS_VALUE / (center_us - min_us) as 22.10 fixed point value */
+} T_JOYSTICK_AXIS;
+
+typedef struct
+{
+  int16_t axis[4];
+} T_JOYSTICK_REPORT;
+
+/* USB interface of the joystick - has to be constructed statically in
+ * order to be plugged before the USB device is attached
+ */
+
+class JoystickUsbModule : public PluggableUSBModule
+{
+
+public:
+
+  JoystickUsbModule();
+
+  /**
+   * \brief returns true if the host has fetched the last report (the endpoint is free)
+   */
+  bool isReady();
+
+  /**
+   * \brief send a report, the endpoint has to be free (see isReady())
+   */
+  void send(T_JOYSTICK_REPORT const & report);
+
+protected:
+
+  int getInterface(uint8_t * interface_count);
+  int getDescriptor(USBSetup & setup);
+  bool setup(USBSetup & setup);
+
+private:
+
+  EPTYPE_DESCRIPTOR_SIZE _endpoint_type[1];
+  uint8_t                _protocol;
+  uint8_t                _idle;
+};
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+static uint8_t const NUM_RC_IN_CHANNELS = 4;
+
+static int16_t const MAX_AXIS_VALUE = 32767;
+static uint8_t const AXIS_SCALE_SHIFT = 10;
+
+/* Limits the scale so that the product with any pulse duration fits into 32 bit */
+
+static uint16_t const MIN_CALIBRATION_RANGE_US = 100;
+
+static uint8_t const JOYSTICK_POLLING_INTERVAL_MS = 1;
+
+static uint8_t const JOYSTICK_REPORT_DESCRIPTOR[] PROGMEM =
+{
+  0x05, 0x01,       /* USAGE_PAGE (Generic Desktop) */
+  0x09, 0x04,       /* USAGE (Joystick) */
+  0xA1, 0x01,       /* COLLECTION (Application) */
+  0x09, 0x01,       /*   USAGE (Pointer) */
+  0xA1, 0x00,       /*   COLLECTION (Physical) */
+  0x09, 0x30,       /*     USAGE (X) - IN1 */
+  0x09, 0x31,       /*     USAGE (Y) - IN2 */
+  0x09, 0x32,       /*     USAGE (Z) - IN3 */
+  0x09, 0x33,       /*     USAGE (Rx) - IN4 */
+  0x16, 0x01, 0x80, /*     LOGICAL_MINIMUM (-32767) */
+  0x26, 0xFF, 0x7F, /*     LOGICAL_MAXIMUM (32767) */
+  0x75, 0x10,       /*     REPORT_SIZE (16) */
+  0x95, 0x04,       /*     REPORT_COUNT (4) */
+  0x81, 0x02,       /*     INPUT (Data, Var, Abs) */
+  0xC0,             /*   END_COLLECTION */
+  0xC0              /* END_COLLECTION */
+};
+
+/************************************************************************/
+/* PRIVATE DATA                                                         */
+/************************************************************************/
+
+static JoystickUsbModule JoystickUsb;
+
+static T_JOYSTICK_AXIS JoystickAxis[NUM_RC_IN_CHANNELS];
+
+static uint8_t JoystickLastFrameCount = 0;
+static uint8_t JoystickLastGoodMask   = 0;
+static bool    JoystickReportIsPending = false;
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+JoystickUsbModule::JoystickUsbModule() :
+    PluggableUSBModule(1, 1, _endpoint_type), _protocol(HID_REPORT_PROTOCOL), _idle(0)
+{
+  _endpoint_type[0] = EP_TYPE_INTERRUPT_IN;
+  PluggableUSB().plug(this);
+}
+
+bool JoystickUsbModule::isReady()
+{
+  return USBDevice.configured() && USB_SendSpace(pluggedEndpoint) >= sizeof(T_JOYSTICK_REPORT);
+}
+
+void JoystickUsbModule::send(T_JOYSTICK_REPORT const & report)
+{
+  USB_Send(pluggedEndpoint | TRANSFER_RELEASE, &report, sizeof(report));
+}
+
+int JoystickUsbModule::getInterface(uint8_t * interface_count)
+{
+  *interface_count += 1;
+
+  HIDDescriptor interface =
+  {
+    D_INTERFACE(pluggedInterface, 1, USB_DEVICE_CLASS_HUMAN_INTERFACE, HID_SUBCLASS_NONE, HID_PROTOCOL_NONE),
+    D_HIDREPORT(sizeof(JOYSTICK_REPORT_DESCRIPTOR)),
+    D_ENDPOINT(USB_ENDPOINT_IN(pluggedEndpoint), USB_ENDPOINT_TYPE_INTERRUPT, USB_EP_SIZE, JOYSTICK_POLLING_INTERVAL_MS)
+  };
+
+  return USB_SendControl(0, &interface, sizeof(interface));
+}
+
+int JoystickUsbModule::getDescriptor(USBSetup & setup)
+{
+  if (setup.bmRequestType != REQUEST_DEVICETOHOST_STANDARD_INTERFACE || setup.wValueH != HID_REPORT_DESCRIPTOR_TYPE
+      || setup.wIndex != pluggedInterface)
+  {
+    return 0;
+  }
+
+  _protocol = HID_REPORT_PROTOCOL;
+
+  return USB_SendControl(TRANSFER_PGM, JOYSTICK_REPORT_DESCRIPTOR, sizeof(JOYSTICK_REPORT_DESCRIPTOR));
+}
+
+bool JoystickUsbModule::setup(USBSetup & setup)
+{
+  if (setup.wIndex != pluggedInterface)
+  {
+    return false;
+  }
+
+  if (setup.bmRequestType == REQUEST_DEVICETOHOST_CLASS_INTERFACE)
+  {
+    switch (setup.bRequest)
+    {
+    case HID_GET_REPORT:   return true;
+    case HID_GET_PROTOCOL: return true;
+    case HID_GET_IDLE:     USB_SendControl(0, &_idle, 1); return true;
+    default:               return false;
+    }
+  }
+
+  if (setup.bmRequestType == REQUEST_HOSTTODEVICE_CLASS_INTERFACE)
+  {
+    switch (setup.bRequest)
+    {
+    case HID_SET_PROTOCOL: _protocol = setup.wValueL; return true;
+    case HID_SET_IDLE:     _idle = setup.wValueL; return true;
+    case HID_SET_REPORT:   return true;
+    default:               return false;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * \brief returns magnitude_us * scale (rounded) limited to MAX_AXIS_VALUE
+ */
+int16_t scaleJoystickAxis(uint16_t const magnitude_us, uint32_t const scale)
+{
+  uint32_t const value = ((uint32_t) (magnitude_us) * scale + (1 << (AXIS_SCALE_SHIFT - 1))) >> AXIS_SCALE_SHIFT;
+
+  return (value > (uint32_t) (MAX_AXIS_VALUE)) ? MAX_AXIS_VALUE : (int16_t) (value);
+}
+
+/**
+ * \brief map the pulse duration of an input to the value of its axis
+ */
+int16_t getJoystickAxisValue(E_RC_IN_SELECT const sel)
+{
+  T_JOYSTICK_AXIS const & axis = JoystickAxis[sel];
+
+  if (!RcIn::isGood(sel))
+  {
+    return 0;
+  }
+
+  uint16_t const pulse_duration_us = RcIn::getPulseDurationUs(sel);
+
+  if (pulse_duration_us >= axis.center_us)
+  {
+    return scaleJoystickAxis(pulse_duration_us - axis.center_us, axis.positive_scale);
+  }
+  else
+  {
+    return -scaleJoystickAxis(axis.center_us - pulse_duration_us, axis.negative_scale);
+  }
+}
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+/**
+ * \brief initialize the Joystick module - all axes are calibrated to 1000 / 1500 / 2000 us
+ */
+void Joystick::begin()
+{
+  for (uint8_t sel = 0; sel < NUM_RC_IN_CHANNELS; sel++)
+  {
+    setCalibration((E_RC_IN_SELECT) (sel), 1000, 1500, 2000);
+  }
+
+  JoystickLastFrameCount = RcIn::getFrameCount();
+}
+
+/**
+ * \brief calibrate the axis of the selected input, center_us has to be
+ * at least 100 us away from min_us and max_us, otherwise the calibration is ignored
+ */
+void Joystick::setCalibration(E_RC_IN_SELECT const sel, uint16_t const min_us, uint16_t const center_us, uint16_t const max_us)
+{
+  if (center_us < min_us + MIN_CALIBRATION_RANGE_US || max_us < center_us + MIN_CALIBRATION_RANGE_US)
+  {
+    return;
+  }
+
+  JoystickAxis[sel].center_us = center_us;
+  JoystickAxis[sel].positive_scale = ((uint32_t) (MAX_AXIS_VALUE) << AXIS_SCALE_SHIFT) / (max_us - center_us);
+  JoystickAxis[sel].negative_scale = ((uint32_t) (MAX_AXIS_VALUE) << AXIS_SCALE_SHIFT) / (center_us - min_us);
+}
+
+/**
+ * \brief send a report if a new input frame has been received and the endpoint is
+ * free, never waits - has to be called in every pass of the scheduler
+ */
+void Joystick::update()
+{
+  /* A report is due for every new frame and whenever an input is lost
+   * or regained (no more frames are completed without signals)
+   */
+
+  uint8_t const frame_count = RcIn::getFrameCount();
+
+  uint8_t good_mask = 0;
+  for (uint8_t sel = 0; sel < NUM_RC_IN_CHANNELS; sel++)
+  {
+    if (RcIn::isGood((E_RC_IN_SELECT) (sel)))
+    {
+      good_mask |= (1 << sel);
+    }
+  }
+
+  if (frame_count != JoystickLastFrameCount || good_mask != JoystickLastGoodMask)
+  {
+    JoystickLastFrameCount = frame_count;
+    JoystickLastGoodMask = good_mask;
+    JoystickReportIsPending = true;
+  }
+
+  /* USB_Send would wait until the host has fetched the previous report.
+   * The report is built right before it is sent so that a report which
+   * had to wait for the host contains the latest frame.
+   */
+
+  if (!JoystickReportIsPending)
+  {
+    return;
+  }
+
+  if (!JoystickUsb.isReady())
+  {
+#if defined(CONFIG_USE_IDLE_SLEEP)
+    /* Stay awake until the host polls (at most 1 ms) instead of
+     * sleeping until the next input pulse
+     */
+    if (USBDevice.configured())
+    {
+      Scheduler::signalEvent();
+    }
+#endif
+    return;
+  }
+
+  T_JOYSTICK_REPORT report;
+
+  for (uint8_t sel = 0; sel < NUM_RC_IN_CHANNELS; sel++)
+  {
+    report.axis[sel] = getJoystickAxisValue((E_RC_IN_SELECT) (sel));
+  }
+
+  JoystickUsb.send(report);
+
+  JoystickReportIsPending = false;
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef JOYSTICK_H_
+#define JOYSTICK_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+#include "rcin.h"
+
+#ifdef CONFIG_USE_JOYSTICK
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+/* The board enumerates as USB HID joystick (in addition to the CDC port)
+ * with the axes X, Y, Z and Rx which report IN1 ... IN4. The interrupt
+ * endpoint is polled every 1 ms, a report is sent as soon as a complete
+ * input frame has been received (see RcIn::getFrameCount) and the host
+ * has fetched the previous one. Each axis is calibrated by the pulse
+ * durations of its minimum, center and maximum position, which are
+ * reported as -32767, 0 and +32767. Inputs without good signals are
+ * reported at their center position.
+ */
+
+class Joystick
+{
+
+public:
+
+  /**
+   * \brief initialize the Joystick module - all axes are calibrated to 1000 / 1500 / 2000 us
+   */
+  static void begin();
+
+  /**
+   * \brief calibrate the axis of the selected input, center_us has to be
+   * at least 100 us away from min_us and max_us, otherwise the calibration is ignored
+   */
+  static void setCalibration(E_RC_IN_SELECT const sel, uint16_t const min_us, uint16_t const center_us, uint16_t const max_us);
+
+  /**
+   * \brief send a report if a new input frame has been received and the endpoint is
+   * free, never waits - has to be called in every pass of the scheduler
+   */
+  static void update();
+
+private:
+
+  /**
+   * \brief no public constructing
+   */
+  Joystick() { }
+};
+
+#endif
+
+#endif /* JOYSTICK_H_ */
@@ -0,0 +1,387 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "latency.h"
+
+#include <avr/io.h>
+
+#include <util/atomic.h>
+
+#ifdef CONFIG_USE_LATENCY_INSTRUMENTATION
+
+/************************************************************************/
+/* PRIVATE TYPEDEFS                                                     */
+/************************************************************************/
+
+/* The histogram uses 16 buckets with a width of 256 us (0 - 4 ms) followed
+ * by 16 buckets with a width of 1024 us (4 ms - 20 ms, the last bucket
+ * collects everything above). The buckets are 8 bit wide, once a bucket
+ * saturates all buckets are halved which preserves the shape of the
+ * distribution.
+ */
+
+typedef struct
+{
+  uint16_t num_samples;
+  uint16_t min_timer_steps;
+  uint16_t max_timer_steps;
+  uint32_t sum_timer_steps;
+  uint8_t  bucket[32];
+} T_LATENCY_HISTOGRAM;
+
+typedef struct
+{
+  uint16_t num_samples;
+  uint16_t min_timer_steps;
+  uint16_t max_timer_steps;
+  uint32_t sum_timer_steps;
+} T_LATENCY_ISR_ENTRY;
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+static uint8_t const NUM_LATENCY_PATHS = 7;
+
+/* Timer 3 is running freely with a step of 4 us (see RcIn::begin) */
+
+static uint16_t const TIMERSTEP_DURATION_US = 4;
+
+/* Timer 1 is running with a step of 0.5 us (see RcOut::begin) */
+
+static uint16_t const OUTPUT_TIMERSTEP_DURATION_NS = 500;
+
+static uint8_t const NUM_FINE_BUCKETS          = 16;
+static uint8_t const FINE_BUCKET_WIDTH_SHIFT   = 6;  /* 64 timer steps = 256 us */
+static uint8_t const COARSE_BUCKET_WIDTH_SHIFT = 8;  /* 256 timer steps = 1024 us */
+static uint8_t const NUM_BUCKETS               = 32;
+
+static uint16_t const FINE_BUCKETS_END_TIMER_STEPS = (uint16_t) (NUM_FINE_BUCKETS) << FINE_BUCKET_WIDTH_SHIFT;
+
+/************************************************************************/
+/* PRIVATE DATA                                                         */
+/************************************************************************/
+
+static volatile T_LATENCY_HISTOGRAM LatencyHistogram[NUM_LATENCY_PATHS];
+
+static volatile uint16_t LatestInputEdgeTimestamp   = 0;
+static volatile bool     IsInputEdgePendingForMix   = false;
+static volatile uint16_t MixedInputEdgeTimestamp    = 0;
+static volatile uint8_t  OutputEdgePendingMask      = 0;
+
+static volatile T_LATENCY_ISR_ENTRY LatencyIsrEntry;
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+/**
+ * \brief add a latency sample (in timer steps) to the histogram of the selected path
+ */
+void addLatencySample(uint8_t const path, uint16_t const latency_timer_steps)
+{
+  volatile T_LATENCY_HISTOGRAM & histogram = LatencyHistogram[path];
+
+  if (histogram.num_samples == 0 || latency_timer_steps < histogram.min_timer_steps)
+  {
+    histogram.min_timer_steps = latency_timer_steps;
+  }
+  if (histogram.num_samples == 0 || latency_timer_steps > histogram.max_timer_steps)
+  {
+    histogram.max_timer_steps = latency_timer_steps;
+  }
+
+  /* Halve sum and counter before the counter overflows, the average remains the same */
+
+  if (histogram.num_samples == 0xFFFF)
+  {
+    histogram.num_samples /= 2;
+    histogram.sum_timer_steps /= 2;
+  }
+
+  histogram.num_samples++;
+  histogram.sum_timer_steps += latency_timer_steps;
+
+  uint8_t bucket = 0;
+  if (latency_timer_steps < FINE_BUCKETS_END_TIMER_STEPS)
+  {
+    bucket = latency_timer_steps >> FINE_BUCKET_WIDTH_SHIFT;
+  }
+  else
+  {
+    uint16_t const coarse_bucket = (latency_timer_steps - FINE_BUCKETS_END_TIMER_STEPS) >> COARSE_BUCKET_WIDTH_SHIFT;
+    bucket = (coarse_bucket < (NUM_BUCKETS - NUM_FINE_BUCKETS)) ? (NUM_FINE_BUCKETS + coarse_bucket) : (NUM_BUCKETS - 1);
+  }
+
+  if (histogram.bucket[bucket] == 0xFF)
+  {
+    for (uint8_t i = 0; i < NUM_BUCKETS; i++)
+    {
+      histogram.bucket[i] /= 2;
+    }
+  }
+
+  histogram.bucket[bucket]++;
+}
+
+/**
+ * \brief returns the upper bound of a histogram bucket in timer steps
+ */
+uint32_t getBucketUpperBoundTimerSteps(uint8_t const bucket)
+{
+  if (bucket < NUM_FINE_BUCKETS)
+  {
+    return (uint32_t) (bucket + 1) << FINE_BUCKET_WIDTH_SHIFT;
+  }
+  else
+  {
+    return FINE_BUCKETS_END_TIMER_STEPS + ((uint32_t) (bucket - NUM_FINE_BUCKETS + 1) << COARSE_BUCKET_WIDTH_SHIFT);
+  }
+}
+
+/**
+ * \brief converts timer 1 steps into ns, saturating at 0xFFFF ns
+ */
+uint16_t convertOutputTimerStepsToNs(uint32_t const timer_steps)
+{
+  uint32_t const ns = timer_steps * OUTPUT_TIMERSTEP_DURATION_NS;
+  return (ns > 0xFFFF) ? 0xFFFF : (uint16_t) (ns);
+}
+
+/**
+ * \brief converts timer steps into us, saturating at 0xFFFF us
+ */
+uint16_t convertTimerStepsToUs(uint32_t const timer_steps)
+{
+  uint32_t const us = timer_steps * TIMERSTEP_DURATION_US;
+  return (us > 0xFFFF) ? 0xFFFF : (uint16_t) (us);
+}
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+/**
+ * \brief called from the input isr upon the falling edge of a valid input pulse
+ */
+void Latency::markInputEdge(uint16_t const timestamp)
+{
+  LatestInputEdgeTimestamp = timestamp;
+  IsInputEdgePendingForMix = true;
+}
+
+/**
+ * \brief called from the main loop after the mixing function has been executed
+ */
+void Latency::markMixComplete()
+{
+  uint16_t const now = TCNT3;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    /* Only the first mix after a new input pulse is of interest, all
+     * further mixes are operating on the same input values.
+     */
+
+    if (IsInputEdgePendingForMix)
+    {
+      IsInputEdgePendingForMix = false;
+
+      addLatencySample(LATENCY_IN_TO_MIX, now - LatestInputEdgeTimestamp);
+
+      MixedInputEdgeTimestamp = LatestInputEdgeTimestamp;
+      OutputEdgePendingMask = (1 << OUT1) | (1 << OUT2) | (1 << OUT3) | (1 << OUT4) | (1 << OUT5) | (1 << OUT6);
+    }
+  }
+}
+
+/**
+ * \brief called from the output isr upon the rising edge of the output pulses
+ * (bit 0 of out_mask = OUT1)
+ */
+void Latency::markOutputEdges(uint8_t const out_mask)
+{
+  uint8_t const sample_mask = OutputEdgePendingMask & out_mask;
+
+  if (sample_mask == 0)
+  {
+    return;
+  }
+
+  OutputEdgePendingMask &= ~sample_mask;
+
+  uint16_t const latency_timer_steps = TCNT3 - MixedInputEdgeTimestamp;
+
+  for (uint8_t sel = OUT1; sel <= OUT6; sel++)
+  {
+    if (sample_mask & (1 << sel))
+    {
+      addLatencySample(LATENCY_IN_TO_OUT1 + sel, latency_timer_steps);
+    }
+  }
+}
+
+/**
+ * \brief called from the output isr with the delay of its entry in timer 1 steps (0.5 us)
+ */
+void Latency::markOutputIsrEntry(uint16_t const delay_timer_steps)
+{
+  if (LatencyIsrEntry.num_samples == 0 || delay_timer_steps < LatencyIsrEntry.min_timer_steps)
+  {
+    LatencyIsrEntry.min_timer_steps = delay_timer_steps;
+  }
+  if (LatencyIsrEntry.num_samples == 0 || delay_timer_steps > LatencyIsrEntry.max_timer_steps)
+  {
+    LatencyIsrEntry.max_timer_steps = delay_timer_steps;
+  }
+
+  if (LatencyIsrEntry.num_samples == 0xFFFF)
+  {
+    LatencyIsrEntry.num_samples /= 2;
+    LatencyIsrEntry.sum_timer_steps /= 2;
+  }
+
+  LatencyIsrEntry.num_samples++;
+  LatencyIsrEntry.sum_timer_steps += delay_timer_steps;
+}
+
+/**
+ * \brief returns the accumulated statistics of the selected latency path,
+ * false if no samples have been recorded so far
+ */
+bool Latency::getStats(E_LATENCY_PATH const path, T_LATENCY_STATS * stats)
+{
+  T_LATENCY_HISTOGRAM histogram;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    histogram.num_samples     = LatencyHistogram[path].num_samples;
+    histogram.min_timer_steps = LatencyHistogram[path].min_timer_steps;
+    histogram.max_timer_steps = LatencyHistogram[path].max_timer_steps;
+    histogram.sum_timer_steps = LatencyHistogram[path].sum_timer_steps;
+    for (uint8_t i = 0; i < NUM_BUCKETS; i++)
+    {
+      histogram.bucket[i] = LatencyHistogram[path].bucket[i];
+    }
+  }
+
+  if (histogram.num_samples == 0)
+  {
+    return false;
+  }
+
+  /* Determine the bucket which contains the 99th percentile */
+
+  uint16_t num_bucket_samples = 0;
+  for (uint8_t i = 0; i < NUM_BUCKETS; i++)
+  {
+    num_bucket_samples += histogram.bucket[i];
+  }
+
+  uint16_t const p99_rank = num_bucket_samples - num_bucket_samples / 100;
+  uint16_t cumulated_bucket_samples = 0;
+  uint8_t p99_bucket = NUM_BUCKETS - 1;
+  for (uint8_t i = 0; i < NUM_BUCKETS; i++)
+  {
+    cumulated_bucket_samples += histogram.bucket[i];
+    if (cumulated_bucket_samples >= p99_rank)
+    {
+      p99_bucket = i;
+      break;
+    }
+  }
+
+  /* The p99 can never be larger than the largest latency observed */
+
+  uint32_t p99_timer_steps = getBucketUpperBoundTimerSteps(p99_bucket);
+  if (p99_timer_steps > histogram.max_timer_steps)
+  {
+    p99_timer_steps = histogram.max_timer_steps;
+  }
+
+  stats->num_samples = histogram.num_samples;
+  stats->min_us      = convertTimerStepsToUs(histogram.min_timer_steps);
+  stats->avg_us      = convertTimerStepsToUs(histogram.sum_timer_steps / histogram.num_samples);
+  stats->max_us      = convertTimerStepsToUs(histogram.max_timer_steps);
+  stats->p99_us      = convertTimerStepsToUs(p99_timer_steps);
+
+  return true;
+}
+
+/**
+ * \brief returns the statistics of the output isr entry delay, false if no
+ * samples have been recorded so far
+ */
+bool Latency::getIsrStats(T_LATENCY_ISR_STATS * stats)
+{
+  T_LATENCY_ISR_ENTRY isr_entry;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    isr_entry.num_samples     = LatencyIsrEntry.num_samples;
+    isr_entry.min_timer_steps = LatencyIsrEntry.min_timer_steps;
+    isr_entry.max_timer_steps = LatencyIsrEntry.max_timer_steps;
+    isr_entry.sum_timer_steps = LatencyIsrEntry.sum_timer_steps;
+  }
+
+  if (isr_entry.num_samples == 0)
+  {
+    return false;
+  }
+
+  stats->num_samples = isr_entry.num_samples;
+  stats->min_ns      = convertOutputTimerStepsToNs(isr_entry.min_timer_steps);
+  stats->avg_ns      = convertOutputTimerStepsToNs(isr_entry.sum_timer_steps / isr_entry.num_samples);
+  stats->max_ns      = convertOutputTimerStepsToNs(isr_entry.max_timer_steps);
+
+  return true;
+}
+
+/**
+ * \brief discard all recorded samples
+ */
+void Latency::reset()
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    LatencyIsrEntry.num_samples = 0;
+    LatencyIsrEntry.sum_timer_steps = 0;
+
+    for (uint8_t path = 0; path < NUM_LATENCY_PATHS; path++)
+    {
+      LatencyHistogram[path].num_samples = 0;
+      LatencyHistogram[path].sum_timer_steps = 0;
+      for (uint8_t i = 0; i < NUM_BUCKETS; i++)
+      {
+        LatencyHistogram[path].bucket[i] = 0;
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+#include "rcin.h"
+#include "rcout.h"
+
+#ifdef CONFIG_USE_LATENCY_INSTRUMENTATION
+
+/************************************************************************/
+/* PUBLIC TYPES                                                         */
+/************************************************************************/
+
+typedef enum
+{
+  LATENCY_IN_TO_MIX  = 0, /* Falling edge of the latest input pulse until the completion of the mix */
+  LATENCY_IN_TO_OUT1 = 1, /* Falling edge of the latest input pulse until the rising edge of OUTx */
+  LATENCY_IN_TO_OUT2 = 2,
+  LATENCY_IN_TO_OUT3 = 3,
+  LATENCY_IN_TO_OUT4 = 4,
+  LATENCY_IN_TO_OUT5 = 5,
+  LATENCY_IN_TO_OUT6 = 6
+} E_LATENCY_PATH;
+
+typedef struct
+{
+  uint16_t num_samples;
+  uint16_t min_us;
+  uint16_t avg_us;
+  uint16_t max_us;
+  uint16_t p99_us;      /* Upper bound of the histogram bucket containing the 99th percentile */
+} T_LATENCY_STATS;
+
+/* Delay between the scheduled time of an output edge (Timer 1 overflow or
+ * compare match) and the entry into its interrupt service routine. The
+ * spread max - min is the jitter of the output edges caused by other
+ * interrupts (e.g. Timer 0 and USB of the Arduino core).
+ */
+
+typedef struct
+{
+  uint16_t num_samples;
+  uint16_t min_ns;
+  uint16_t avg_ns;
+  uint16_t max_ns;
+} T_LATENCY_ISR_STATS;
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+class Latency
+{
+
+public:
+
+  /**
+   * \brief called from the input isr upon the falling edge of a valid input pulse
+   */
+  static void markInputEdge(uint16_t const timestamp);
+
+  /**
+   * \brief called from the main loop after the mixing function has been executed
+   */
+  static void markMixComplete();
+
+  /**
+   * \brief called from the output isr upon the rising edge of the output pulses
+   * (bit 0 of out_mask = OUT1)
+   */
+  static void markOutputEdges(uint8_t const out_mask);
+
+  /**
+   * \brief called from the output isr with the delay of its entry in timer 1 steps (0.5 us)
+   */
+  static void markOutputIsrEntry(uint16_t const delay_timer_steps);
+
+  /**
+   * \brief returns the accumulated statistics of the selected latency path,
+   * false if no samples have been recorded so far
+   */
+  static bool getStats(E_LATENCY_PATH const path, T_LATENCY_STATS * stats);
+
+  /**
+   * \brief returns the statistics of the output isr entry delay, false if no
+   * samples have been recorded so far
+   */
+  static bool getIsrStats(T_LATENCY_ISR_STATS * stats);
+
+  /**
+   * \brief discard all recorded samples
+   */
+  static void reset();
+
+private:
+
+  /**
+   * \brief no public constructing
+   */
+  Latency() { }
+};
+
+#endif
+
+#endif /* LATENCY_H_ */
@@ -30,6 +30,29 @@
 
 #include "hal.h"
 
+/************************************************************************/
+/* PRIVATE DATA                                                         */
+/************************************************************************/
+
+static E_LED_STATE LedState       = LED_OFF;
+static bool        LedIsTurnedOn  = false;
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+void turnLedOn()
+{
+  clearULed();
+  LedIsTurnedOn = true;
+}
+
+void turnLedOff()
+{
+  setULed();
+  LedIsTurnedOn = false;
+}
+
 /************************************************************************/
 /* PUBLIC FUNCTIONS	                                                    */
 /************************************************************************/
@@ -49,10 +72,31 @@ void Led::begin()
  */
 void Led::setState(E_LED_STATE const state)
 {
+  LedState = state;
+
   switch (state)
   {
-  case LED_ON:  clearULed();  break;
-  case LED_OFF: setULed();    break;
-  default:      setULed();    break;
+  case LED_ON:    turnLedOn();  break;
+  case LED_OFF:   turnLedOff(); break;
+  case LED_BLINK:               break;
+  default:        turnLedOff(); break;
+  }
+}
+
+/**
+ * \brief toggle the led if it is blinking - has to be called periodically
+ */
+void Led::update()
+{
+  if (LedState == LED_BLINK)
+  {
+    if (LedIsTurnedOn)
+    {
+      turnLedOff();
+    }
+    else
+    {
+      turnLedOn();
+    }
   }
 }
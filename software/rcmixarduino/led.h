@@ -31,7 +31,7 @@
 
 typedef enum
 {
-  LED_ON, LED_OFF
+  LED_ON, LED_OFF, LED_BLINK
 } E_LED_STATE;
 
 /************************************************************************/
@@ -52,6 +52,11 @@ public:
    */
   static void setState(E_LED_STATE const state);
 
+  /**
+   * \brief toggle the led if it is blinking - has to be called periodically
+   */
+  static void update();
+
 private:
   /**
    * \brief no public constructing
@@ -0,0 +1,304 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MIXDSL_H_
+#define MIXDSL_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+
+#include "rcin.h"
+#include "rcout.h"
+
+/************************************************************************/
+/* DESCRIPTION                                                          */
+/************************************************************************/
+
+/* Header only DSL for declaring a mix within a mixingFunc, e.g.
+ *
+ *   using namespace MixDsl;
+ *
+ *   out(OUT1) = 0.66_q * in(IN2) - deadzone(in(IN3), 50);
+ *
+ * Every expression is an object whose type describes the whole mix
+ * (expression templates), all gains are 8.8 fixed point constants
+ * evaluated at compile time. The assignment to out() evaluates the
+ * expression, the compiler inlines it into straight-line integer code.
+ *
+ * All values are the deviation of a pulse duration from 1500 us, every
+ * operation saturates to the range of int16_t and the output is limited
+ * to 1500 +/- 1000 us (see RcOut::setEndpoints for tighter limits).
+ *
+ *   in(INx)                  deviation of INx from 1500 us
+ *   <gain>_q * e, e * <gain>_q   e * gain (gain as literal, e.g. 0.66_q, -1.5_q)
+ *   e + e, e - e, -e         arithmetic, integer constants are allowed as operand
+ *   deadzone(e, dz)          0 within +/- dz, e -/+ dz outside (no step at the edge)
+ *   clamp(e, lo, hi)         limit e to lo ... hi
+ *   outside(e, dz)           1 if e is outside of +/- dz, else 0 (a gate, e is not changed)
+ *   c || c                   1 if any condition is not 0, else 0
+ *   select(c, a, b)          a if the condition c is not 0, else b (only one is evaluated)
+ *   out(OUTx) = e            set OUTx to 1500 us + e
+ */
+
+namespace MixDsl
+{
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+static uint16_t const CENTER_PULSE_DURATION_US = 1500;
+static int16_t const  MAX_OUTPUT_DEVIATION_US  = 1000;
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+/**
+ * \brief limit a value to lo ... hi
+ */
+inline int16_t limit(int32_t const value, int16_t const lo, int16_t const hi)
+{
+  return (value > hi) ? hi : ((value < lo) ? lo : (int16_t) (value));
+}
+
+/**
+ * \brief limit a value to the range of int16_t
+ */
+inline int16_t saturate(int32_t const value)
+{
+  return limit(value, -32767 - 1, 32767);
+}
+
+/************************************************************************/
+/* EXPRESSIONS                                                          */
+/************************************************************************/
+
+/**
+ * \brief base of all expressions (CRTP) - restricts the operators to expressions
+ */
+template <class Derived>
+struct Expr
+{
+  int16_t eval() const { return static_cast<Derived const &>(*this).eval(); }
+};
+
+/**
+ * \brief a 8.8 fixed point gain, created by the _q literal
+ */
+struct Gain
+{
+  int16_t q;
+  constexpr explicit Gain(int16_t const value) : q(value) { }
+  constexpr Gain operator - () const { return Gain(-q); }
+};
+
+struct Const : Expr<Const>
+{
+  int16_t value;
+  constexpr explicit Const(int16_t const v) : value(v) { }
+  int16_t eval() const { return value; }
+};
+
+struct In : Expr<In>
+{
+  E_RC_IN_SELECT sel;
+  constexpr explicit In(E_RC_IN_SELECT const s) : sel(s) { }
+  int16_t eval() const { return (int16_t) (RcIn::getPulseDurationUs(sel)) - (int16_t) (CENTER_PULSE_DURATION_US); }
+};
+
+template <class E>
+struct Scale : Expr<Scale<E> >
+{
+  E e;
+  int16_t q;
+  constexpr Scale(E const & expr, Gain const gain) : e(expr), q(gain.q) { }
+  int16_t eval() const { return saturate(((int32_t) (e.eval()) * q) >> 8); }
+};
+
+template <class E>
+struct Negate : Expr<Negate<E> >
+{
+  E e;
+  constexpr explicit Negate(E const & expr) : e(expr) { }
+  int16_t eval() const { return saturate(-(int32_t) (e.eval())); }
+};
+
+template <class L, class R>
+struct Add : Expr<Add<L, R> >
+{
+  L l;
+  R r;
+  constexpr Add(L const & left, R const & right) : l(left), r(right) { }
+  int16_t eval() const { return saturate((int32_t) (l.eval()) + r.eval()); }
+};
+
+template <class L, class R>
+struct Sub : Expr<Sub<L, R> >
+{
+  L l;
+  R r;
+  constexpr Sub(L const & left, R const & right) : l(left), r(right) { }
+  int16_t eval() const { return saturate((int32_t) (l.eval()) - r.eval()); }
+};
+
+template <class E>
+struct Deadzone : Expr<Deadzone<E> >
+{
+  E e;
+  int16_t dz;
+  constexpr Deadzone(E const & expr, int16_t const deadzone) : e(expr), dz(deadzone) { }
+  int16_t eval() const
+  {
+    int16_t const value = e.eval();
+    return (value > dz) ? (value - dz) : ((value < -dz) ? (value + dz) : 0);
+  }
+};
+
+template <class E>
+struct Clamp : Expr<Clamp<E> >
+{
+  E e;
+  int16_t lo;
+  int16_t hi;
+  constexpr Clamp(E const & expr, int16_t const low, int16_t const high) : e(expr), lo(low), hi(high) { }
+  int16_t eval() const { return limit(e.eval(), lo, hi); }
+};
+
+template <class E>
+struct Outside : Expr<Outside<E> >
+{
+  E e;
+  int16_t dz;
+  constexpr Outside(E const & expr, int16_t const deadzone) : e(expr), dz(deadzone) { }
+  int16_t eval() const
+  {
+    int16_t const value = e.eval();
+    return (value > dz || value < -dz) ? 1 : 0;
+  }
+};
+
+template <class L, class R>
+struct Or : Expr<Or<L, R> >
+{
+  L l;
+  R r;
+  constexpr Or(L const & left, R const & right) : l(left), r(right) { }
+  int16_t eval() const { return (l.eval() != 0 || r.eval() != 0) ? 1 : 0; }
+};
+
+template <class C, class A, class B>
+struct Select : Expr<Select<C, A, B> >
+{
+  C c;
+  A a;
+  B b;
+  constexpr Select(C const & cond, A const & if_true, B const & if_false) : c(cond), a(if_true), b(if_false) { }
+  int16_t eval() const { return (c.eval() != 0) ? a.eval() : b.eval(); }
+};
+
+/**
+ * \brief the target of an assignment, sets the pulse duration of an output
+ */
+struct Out
+{
+  E_RC_OUT_SELECT sel;
+  constexpr explicit Out(E_RC_OUT_SELECT const s) : sel(s) { }
+
+  template <class E>
+  void operator = (Expr<E> const & expr) const
+  {
+    int16_t const value = limit(static_cast<E const &>(expr).eval(), -MAX_OUTPUT_DEVIATION_US, MAX_OUTPUT_DEVIATION_US);
+    RcOut::setPwmPulseDurationUs(sel, (uint16_t) ((int16_t) (CENTER_PULSE_DURATION_US) + value));
+  }
+};
+
+/************************************************************************/
+/* OPERATORS                                                            */
+/************************************************************************/
+
+constexpr Gain operator "" _q(long double const value)
+{
+  return Gain((int16_t) (value * 256.0L + ((value < 0) ? -0.5L : 0.5L)));
+}
+
+constexpr Gain operator "" _q(unsigned long long const value)
+{
+  return Gain((int16_t) (value * 256));
+}
+
+constexpr In in(E_RC_IN_SELECT const sel) { return In(sel); }
+constexpr Out out(E_RC_OUT_SELECT const sel) { return Out(sel); }
+
+template <class E>
+constexpr Scale<E> operator * (Gain const gain, Expr<E> const & e) { return Scale<E>(static_cast<E const &>(e), gain); }
+template <class E>
+constexpr Scale<E> operator * (Expr<E> const & e, Gain const gain) { return Scale<E>(static_cast<E const &>(e), gain); }
+
+template <class E>
+constexpr Negate<E> operator - (Expr<E> const & e) { return Negate<E>(static_cast<E const &>(e)); }
+
+template <class L, class R>
+constexpr Add<L, R> operator + (Expr<L> const & l, Expr<R> const & r) { return Add<L, R>(static_cast<L const &>(l), static_cast<R const &>(r)); }
+template <class L>
+constexpr Add<L, Const> operator + (Expr<L> const & l, int16_t const r) { return Add<L, Const>(static_cast<L const &>(l), Const(r)); }
+template <class R>
+constexpr Add<Const, R> operator + (int16_t const l, Expr<R> const & r) { return Add<Const, R>(Const(l), static_cast<R const &>(r)); }
+
+template <class L, class R>
+constexpr Sub<L, R> operator - (Expr<L> const & l, Expr<R> const & r) { return Sub<L, R>(static_cast<L const &>(l), static_cast<R const &>(r)); }
+template <class L>
+constexpr Sub<L, Const> operator - (Expr<L> const & l, int16_t const r) { return Sub<L, Const>(static_cast<L const &>(l), Const(r)); }
+template <class R>
+constexpr Sub<Const, R> operator - (int16_t const l, Expr<R> const & r) { return Sub<Const, R>(Const(l), static_cast<R const &>(r)); }
+
+template <class E>
+constexpr Deadzone<E> deadzone(Expr<E> const & e, int16_t const dz) { return Deadzone<E>(static_cast<E const &>(e), dz); }
+
+template <class E>
+constexpr Clamp<E> clamp(Expr<E> const & e, int16_t const lo, int16_t const hi) { return Clamp<E>(static_cast<E const &>(e), lo, hi); }
+
+template <class E>
+constexpr Outside<E> outside(Expr<E> const & e, int16_t const dz) { return Outside<E>(static_cast<E const &>(e), dz); }
+
+template <class L, class R>
+constexpr Or<L, R> operator || (Expr<L> const & l, Expr<R> const & r) { return Or<L, R>(static_cast<L const &>(l), static_cast<R const &>(r)); }
+
+template <class C, class A, class B>
+constexpr Select<C, A, B> select(Expr<C> const & c, Expr<A> const & a, Expr<B> const & b)
+{
+  return Select<C, A, B>(static_cast<C const &>(c), static_cast<A const &>(a), static_cast<B const &>(b));
+}
+template <class C, class A>
+constexpr Select<C, A, Const> select(Expr<C> const & c, Expr<A> const & a, int16_t const b)
+{
+  return Select<C, A, Const>(static_cast<C const &>(c), static_cast<A const &>(a), Const(b));
+}
+
+} /* MixDsl */
+
+#endif /* MIXDSL_H_ */
@@ -0,0 +1,357 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "param.h"
+
+#ifdef CONFIG_USE_PARAM
+
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+
+#include <util/crc16.h>
+
+#include "rcout.h"
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+/* EEPROM layout of the parameter store (0x000 ... 0x0FF, the bytecode
+ * program is stored at 0x300):
+ *
+ *   [magic] [layout version] [number of parameters n] [value:2] * n [crc16:2]
+ *
+ * The crc16 (_crc16_update, initial value 0xFFFF) covers all bytes before
+ * it, values are little endian. A store with less parameters than known
+ * (older firmware) is loaded and the missing parameters get their default
+ * value. The layout version is only changed if this format changes.
+ */
+
+static uint16_t const EEPROM_PARAM_ADDRESS = 0x000;
+static uint16_t const EEPROM_PARAM_SIZE    = 0x100;
+
+static uint8_t const PARAM_STORE_MAGIC = 0x50;
+
+static uint8_t const PARAM_STORE_HEADER_SIZE = 3;
+static uint8_t const PARAM_STORE_SIZE        = PARAM_STORE_HEADER_SIZE + NUM_PARAMS * 2 + 2;
+static uint8_t const MAX_STORED_PARAMS       = (EEPROM_PARAM_SIZE - PARAM_STORE_HEADER_SIZE - 2) / 2;
+
+static T_PARAM_INFO const PARAM_INFO[NUM_PARAMS] PROGMEM =
+{
+  {     0,   256,    50 }, /* PARAM_DEADZONE_US */
+  {  1400,  1600,  1500 }, /* PARAM_CENTER_US */
+  {   800,  1500,  1000 }, /* PARAM_MIN_PULSE_WIDTH_US */
+  {  1500,  2200,  2000 }, /* PARAM_MAX_PULSE_WIDTH_US */
+  {  5000, 30000, 20000 }, /* PARAM_FRAME_PERIOD_US */
+  {     0,   255,     0 }, /* PARAM_PROFILE */
+  {    20,  2000,   100 }, /* PARAM_HOST_TIMEOUT_MS */
+  {     0,     1,     0 }  /* PARAM_HOST_FALLBACK */
+};
+
+/************************************************************************/
+/* PRIVATE DATA                                                         */
+/************************************************************************/
+
+/* ParamActive is read by the mix path, ParamPending is changed by set()
+ * and copied to ParamActive at the next frame boundary. Both are only
+ * accessed from the main loop.
+ */
+
+static uint16_t ParamActive[NUM_PARAMS];
+static uint16_t ParamPending[NUM_PARAMS];
+static bool     ParamIsPending         = false;
+static uint8_t  ParamPendingFrameCount = 0;
+
+/* Image of the store which is written to the EEPROM byte by byte */
+
+static uint8_t  ParamStoreImage[PARAM_STORE_SIZE];
+static uint8_t  ParamStoreWriteIndex = PARAM_STORE_SIZE;
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+/**
+ * \brief returns the default value of a parameter
+ */
+uint16_t getParamDefault(uint8_t const sel)
+{
+  return pgm_read_word(&PARAM_INFO[sel].default_value);
+}
+
+/**
+ * \brief returns true if value is within the range of the parameter
+ */
+bool isParamInRange(uint8_t const sel, uint16_t const value)
+{
+  return value >= pgm_read_word(&PARAM_INFO[sel].min_value) && value <= pgm_read_word(&PARAM_INFO[sel].max_value);
+}
+
+/**
+ * \brief mark the pending parameters to be activated at the next frame boundary
+ */
+void markParamPending()
+{
+  ParamIsPending = true;
+  ParamPendingFrameCount = RcOut::getFrameCount();
+}
+
+/**
+ * \brief read the parameter store from the EEPROM into ParamPending, returns false if
+ * the store is invalid (ParamPending then contains the default values)
+ */
+bool loadParamStore()
+{
+  for (uint8_t sel = 0; sel < NUM_PARAMS; sel++)
+  {
+    ParamPending[sel] = getParamDefault(sel);
+  }
+
+  uint8_t const * address = (uint8_t const *) (EEPROM_PARAM_ADDRESS);
+
+  uint8_t const magic = eeprom_read_byte(address++);
+  uint8_t const layout_version = eeprom_read_byte(address++);
+  uint8_t const num_stored_params = eeprom_read_byte(address++);
+
+  if (magic != PARAM_STORE_MAGIC || layout_version != PARAM_STORE_LAYOUT_VERSION || num_stored_params > MAX_STORED_PARAMS)
+  {
+    return false;
+  }
+
+  uint16_t crc = 0xFFFF;
+  crc = _crc16_update(crc, magic);
+  crc = _crc16_update(crc, layout_version);
+  crc = _crc16_update(crc, num_stored_params);
+
+  uint16_t stored_value[NUM_PARAMS];
+
+  for (uint8_t sel = 0; sel < num_stored_params; sel++)
+  {
+    uint8_t const low = eeprom_read_byte(address++);
+    uint8_t const high = eeprom_read_byte(address++);
+
+    crc = _crc16_update(crc, low);
+    crc = _crc16_update(crc, high);
+
+    if (sel < NUM_PARAMS)
+    {
+      stored_value[sel] = ((uint16_t) (high) << 8) | low;
+    }
+  }
+
+  uint16_t const stored_crc = eeprom_read_byte(address) | ((uint16_t) (eeprom_read_byte(address + 1)) << 8);
+
+  if (crc != stored_crc)
+  {
+    return false;
+  }
+
+  for (uint8_t sel = 0; sel < num_stored_params && sel < NUM_PARAMS; sel++)
+  {
+    if (isParamInRange(sel, stored_value[sel]))
+    {
+      ParamPending[sel] = stored_value[sel];
+    }
+  }
+
+  return true;
+}
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+/**
+ * \brief load all parameters from the EEPROM - parameters which are not stored or
+ * invalid (wrong layout version, wrong crc, out of range) get their default value
+ */
+void Param::begin()
+{
+  loadParamStore();
+
+  for (uint8_t sel = 0; sel < NUM_PARAMS; sel++)
+  {
+    ParamActive[sel] = ParamPending[sel];
+  }
+
+  ParamIsPending = false;
+}
+
+/**
+ * \brief returns the active value of a parameter (RAM only)
+ */
+uint16_t Param::get(E_PARAM_SELECT const sel)
+{
+  return ParamActive[sel];
+}
+
+/**
+ * \brief returns the value of a parameter including changes which are not active yet
+ */
+uint16_t Param::getPending(E_PARAM_SELECT const sel)
+{
+  return ParamPending[sel];
+}
+
+/**
+ * \brief returns range and default value of a parameter, false if sel is invalid
+ */
+bool Param::getInfo(uint8_t const sel, T_PARAM_INFO * info)
+{
+  if (sel >= NUM_PARAMS)
+  {
+    return false;
+  }
+
+  memcpy_P(info, &PARAM_INFO[sel], sizeof(T_PARAM_INFO));
+
+  return true;
+}
+
+/**
+ * \brief change a parameter, it is activated at the next frame boundary (see update()).
+ * Returns false if the value is out of range.
+ */
+bool Param::set(E_PARAM_SELECT const sel, uint16_t const value)
+{
+  if (sel >= NUM_PARAMS || !isParamInRange(sel, value))
+  {
+    return false;
+  }
+
+  ParamPending[sel] = value;
+
+  markParamPending();
+
+  return true;
+}
+
+/**
+ * \brief set all parameters to their default value, activated at the next frame boundary
+ */
+void Param::restoreDefaults()
+{
+  for (uint8_t sel = 0; sel < NUM_PARAMS; sel++)
+  {
+    ParamPending[sel] = getParamDefault(sel);
+  }
+
+  markParamPending();
+}
+
+/**
+ * \brief activate changed parameters once a new output frame has started - has to be
+ * called from the mix path, returns true if the parameters have been changed
+ */
+bool Param::update()
+{
+  if (!ParamIsPending || RcOut::getFrameCount() == ParamPendingFrameCount)
+  {
+    return false;
+  }
+
+  for (uint8_t sel = 0; sel < NUM_PARAMS; sel++)
+  {
+    ParamActive[sel] = ParamPending[sel];
+  }
+
+  ParamIsPending = false;
+
+  return true;
+}
+
+/**
+ * \brief write all parameters to the EEPROM in the background (see process()), returns
+ * false if the last save is still in progress
+ */
+bool Param::save()
+{
+  if (isSaving())
+  {
+    return false;
+  }
+
+  uint8_t * ptr = ParamStoreImage;
+
+  *ptr++ = PARAM_STORE_MAGIC;
+  *ptr++ = PARAM_STORE_LAYOUT_VERSION;
+  *ptr++ = NUM_PARAMS;
+
+  for (uint8_t sel = 0; sel < NUM_PARAMS; sel++)
+  {
+    *ptr++ = (uint8_t) (ParamPending[sel]);
+    *ptr++ = (uint8_t) (ParamPending[sel] >> 8);
+  }
+
+  uint16_t crc = 0xFFFF;
+  for (uint8_t * p = ParamStoreImage; p < ptr; p++)
+  {
+    crc = _crc16_update(crc, *p);
+  }
+
+  *ptr++ = (uint8_t) (crc);
+  *ptr++ = (uint8_t) (crc >> 8);
+
+  ParamStoreWriteIndex = 0;
+
+  return true;
+}
+
+/**
+ * \brief returns true while parameters are written to the EEPROM
+ */
+bool Param::isSaving()
+{
+  return ParamStoreWriteIndex < PARAM_STORE_SIZE;
+}
+
+/**
+ * \brief write the next byte of a requested save to the EEPROM if the EEPROM is ready,
+ * never waits - has to be called periodically from a low priority task
+ */
+void Param::process()
+{
+  /* Writing one byte takes 3.4 ms, eeprom_update_byte would wait for the
+   * completion of the previous write. The crc is written last - a save
+   * which is interrupted by a reset leaves an invalid store.
+   */
+
+  while (isSaving() && eeprom_is_ready())
+  {
+    uint8_t * const address = (uint8_t *) (EEPROM_PARAM_ADDRESS) + ParamStoreWriteIndex;
+    uint8_t const value = ParamStoreImage[ParamStoreWriteIndex++];
+
+    if (eeprom_read_byte(address) != value)
+    {
+      eeprom_write_byte(address, value);
+      return;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PARAM_H_
+#define PARAM_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+#ifdef CONFIG_USE_PARAM
+
+/************************************************************************/
+/* PUBLIC TYPES                                                         */
+/************************************************************************/
+
+/* The index of a parameter is also its position in the EEPROM - new
+ * parameters have to be appended, existing ones must never be reordered
+ * (software/tools/rcmixcfg.py uses the same list)
+ */
+
+typedef enum
+{
+  PARAM_DEADZONE_US        = 0, /* Smooth deadzone of IN1 ... IN3 (see Curve::setDeadzone), only with CONFIG_USE_CURVE */
+  PARAM_CENTER_US          = 1, /* Stick center of IN1 ... IN3 (see Curve::setCenter, Joystick::setCalibration) */
+  PARAM_MIN_PULSE_WIDTH_US = 2, /* Shortest valid input pulse (see RcIn::setPulseWidthLimits) */
+  PARAM_MAX_PULSE_WIDTH_US = 3, /* Longest valid input pulse */
+  PARAM_FRAME_PERIOD_US    = 4, /* Period of the output frame (see RcOut::setFramePeriodUs) */
+  PARAM_PROFILE            = 5, /* 0 = profile selected by the switch channel, n = profile n (see ProfileControl) */
+  PARAM_HOST_TIMEOUT_MS    = 6, /* Timeout of the host link (see HostLink::setTimeoutMs) */
+  PARAM_HOST_FALLBACK      = 7, /* Action when the host link is lost (see E_HOST_FALLBACK) */
+  NUM_PARAMS               = 8
+} E_PARAM_SELECT;
+
+/* Version of the EEPROM layout of the parameter store (see param.cpp) */
+
+static uint8_t const PARAM_STORE_LAYOUT_VERSION = 1;
+
+typedef struct
+{
+  uint16_t min_value;
+  uint16_t max_value;
+  uint16_t default_value;
+} T_PARAM_INFO;
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+/* All parameters are unsigned 16 bit values with a valid range. They are
+ * loaded from the EEPROM once by begin() into a RAM cache, get() never
+ * accesses the EEPROM. Changed values are activated at the next output
+ * frame boundary by update(), they are written back to the EEPROM in the
+ * background (process()) only when save() is requested.
+ */
+
+class Param
+{
+
+public:
+
+  /**
+   * \brief load all parameters from the EEPROM - parameters which are not stored or
+   * invalid (wrong layout version, wrong crc, out of range) get their default value
+   */
+  static void begin();
+
+  /**
+   * \brief returns the active value of a parameter (RAM only)
+   */
+  static uint16_t get(E_PARAM_SELECT const sel);
+
+  /**
+   * \brief returns the value of a parameter including changes which are not active yet
+   */
+  static uint16_t getPending(E_PARAM_SELECT const sel);
+
+  /**
+   * \brief returns range and default value of a parameter, false if sel is invalid
+   */
+  static bool getInfo(uint8_t const sel, T_PARAM_INFO * info);
+
+  /**
+   * \brief change a parameter, it is activated at the next frame boundary (see update()).
+   * Returns false if the value is out of range.
+   */
+  static bool set(E_PARAM_SELECT const sel, uint16_t const value);
+
+  /**
+   * \brief set all parameters to their default value, activated at the next frame boundary
+   */
+  static void restoreDefaults();
+
+  /**
+   * \brief activate changed parameters once a new output frame has started - has to be
+   * called from the mix path, returns true if the parameters have been changed
+   */
+  static bool update();
+
+  /**
+   * \brief write all parameters to the EEPROM in the background (see process()), returns
+   * false if the last save is still in progress
+   */
+  static bool save();
+
+  /**
+   * \brief returns true while parameters are written to the EEPROM
+   */
+  static bool isSaving();
+
+  /**
+   * \brief write the next byte of a requested save to the EEPROM if the EEPROM is ready,
+   * never waits - has to be called periodically from a low priority task
+   */
+  static void process();
+
+private:
+
+  /**
+   * \brief no public constructing
+   */
+  Param() { }
+};
+
+#endif
+
+#endif /* PARAM_H_ */
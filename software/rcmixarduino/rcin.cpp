@@ -31,7 +31,22 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 
+#include <util/atomic.h>
+
 #include "hal.h"
+#include "config.h"
+
+#if defined(CONFIG_USE_LATENCY_INSTRUMENTATION)
+#include "latency.h"
+#endif
+
+#if defined(CONFIG_USE_IDLE_SLEEP)
+#include "scheduler.h"
+#endif
+
+#if defined(CONFIG_USE_FAST_BOOT)
+#include "boot.h"
+#endif
 
 /************************************************************************/
 /* PRIVATE TYPEDEFS													                            */
@@ -88,8 +103,34 @@ typedef struct
 static uint8_t const NUM_RC_IN_CHANNELS = 4;
 
 static uint8_t const MIN_PULSES_PER_TIMER_CYCLE = 10; // 262 ms / 20 ms = 13 (-3 to give a little room for error)
-static uint16_t const MIN_PULSE_WIDTH_US = 1000;
-static uint16_t const MAX_PULSE_WIDTH_US = 2000;
+static uint16_t const DEFAULT_MIN_PULSE_WIDTH_US = 1000;
+static uint16_t const DEFAULT_MAX_PULSE_WIDTH_US = 2000;
+
+static uint16_t const TIMERSTEP_DURATION_US = 4;
+static uint16_t const MAX_FRAME_PERIOD_IN_TIMER_STEPS = 0xFFFF / TIMERSTEP_DURATION_US;
+
+#if defined(CONFIG_USE_FAST_BOOT)
+/* Consecutive valid pulses have to be at most 40 ms apart in order to
+ * count towards the acquisition of an input
+ */
+
+static uint16_t const MAX_ACQUIRE_PULSE_PERIOD_IN_TIMER_STEPS = 40000 / TIMERSTEP_DURATION_US;
+#endif
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+/* The selected receiver is replaced by the other one as soon as one of
+ * its channels has not delivered a valid pulse for 25 ms (one 20 ms frame
+ * plus margin). While both are good the one with the better quality is
+ * selected, a change requires a difference of DIVERSITY_QUALITY_HYSTERESIS.
+ */
+
+static uint16_t const MAX_DIVERSITY_PULSE_AGE_IN_TIMER_STEPS = 25000 / TIMERSTEP_DURATION_US;
+static uint8_t  const DIVERSITY_QUALITY_HYSTERESIS = 3;
+
+/* Receiver A: IN1 + IN2, receiver B: IN3 + IN4 */
+
+static uint8_t const NUM_DIVERSITY_CHANNELS = 2;
+#endif
 
 /************************************************************************/
 /* PRIVATE DATA														    */
@@ -103,6 +144,61 @@ static volatile T_RC_IN_DATA RcInData[NUM_RC_IN_CHANNELS] =
 { false, 0, RISING, 0, 0, 0, initIn4, triggerIn4AtRisingEdge, triggerIn4AtFallingEdge } /* IN4 */
 };
 
+/* Frame completion tracking - a bit is set in RcInFrameFreshMask for every
+ * input channel which has delivered a new pulse since the last completed frame
+ */
+
+static volatile uint8_t               RcInFrameFreshMask            = 0;
+static volatile uint16_t              RcInFrameCompleteTimer        = 0;
+static volatile bool                  RcInFrameCompleteTimerIsValid = false;
+static volatile rcInFrameCompleteFunc RcInFrameCompleteCallback     = 0;
+static volatile uint8_t               RcInFrameCount                = 0;
+
+#if defined(CONFIG_USE_HOST_CONTROL)
+/* Inputs overridden by the host (see RcIn::setOverride), only accessed
+ * from the main loop
+ */
+
+static uint8_t                        RcInOverrideMask              = 0;
+static uint16_t                       RcInOverridePulseDurationUs[NUM_RC_IN_CHANNELS];
+#endif
+
+#if defined(CONFIG_USE_FAST_BOOT)
+/* Acquisition of an input which is not good yet - it is good as soon as
+ * CONFIG_FAST_BOOT_ACQUIRE_PULSES consecutive valid pulses have been
+ * received instead of waiting for the end of the timer cycle. The number
+ * of pulses required within the rest of that timer cycle is reduced
+ * accordingly.
+ */
+
+static volatile uint8_t               RcInAcquirePulses[NUM_RC_IN_CHANNELS];
+static volatile uint8_t               RcInMinPulsesPerTimerCycle[NUM_RC_IN_CHANNELS] =
+{ MIN_PULSES_PER_TIMER_CYCLE, MIN_PULSES_PER_TIMER_CYCLE, MIN_PULSES_PER_TIMER_CYCLE, MIN_PULSES_PER_TIMER_CYCLE };
+#endif
+
+/* Pulses outside of [RcInMinPulseWidthUs, RcInMaxPulseWidthUs] are ignored */
+
+static volatile uint16_t              RcInMinPulseWidthUs           = DEFAULT_MIN_PULSE_WIDTH_US;
+static volatile uint16_t              RcInMaxPulseWidthUs           = DEFAULT_MAX_PULSE_WIDTH_US;
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+/* Selected receiver (see E_RC_IN_SOURCE), the timer value of the last
+ * valid pulse of every input and the signal quality of both receivers
+ */
+
+static volatile uint8_t               RcInDiversitySource           = RC_IN_SOURCE_A;
+static volatile uint16_t              RcInDiversityValidPulseTimer[NUM_RC_IN_CHANNELS];
+static volatile uint8_t               RcInDiversityRejectedPulses[2];
+static volatile uint8_t               RcInDiversityQuality[2];
+static volatile uint16_t              RcInDiversityNumSwitches      = 0;
+#endif
+
+#if defined(CONFIG_USE_EVENT_LOG)
+/* Number of rejected pulses per input, evaluated by EventLog::process */
+
+static volatile uint8_t               RcInRejectedPulseCount[NUM_RC_IN_CHANNELS];
+#endif
+
 /************************************************************************/
 /* PUBLIC FUNCTIONS	                                                    */
 /************************************************************************/
@@ -159,6 +255,21 @@ void RcIn::begin()
  */
 bool RcIn::isGood(E_RC_IN_SELECT const sel)
 {
+#if defined(CONFIG_USE_HOST_CONTROL)
+  if (RcInOverrideMask & (1 << sel))
+  {
+    return true;
+  }
+#endif
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+  /* The logical channels IN1 and IN2 deliver the selected receiver */
+  if (sel < NUM_DIVERSITY_CHANNELS)
+  {
+    return RcInData[sel + RcInDiversitySource * NUM_DIVERSITY_CHANNELS].is_good;
+  }
+#endif
+
   return RcInData[sel].is_good;
 }
 
@@ -167,9 +278,285 @@ bool RcIn::isGood(E_RC_IN_SELECT const sel)
  */
 uint16_t RcIn::getPulseDurationUs(E_RC_IN_SELECT const sel)
 {
+#if defined(CONFIG_USE_HOST_CONTROL)
+  if (RcInOverrideMask & (1 << sel))
+  {
+    return RcInOverridePulseDurationUs[sel];
+  }
+#endif
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+  if (sel < NUM_DIVERSITY_CHANNELS)
+  {
+    return RcInData[sel + RcInDiversitySource * NUM_DIVERSITY_CHANNELS].pulse_duration_us;
+  }
+#endif
+
   return RcInData[sel].pulse_duration_us;
 }
 
+/**
+ * \brief register a function which is called whenever a complete input frame has been received
+ */
+void RcIn::setFrameCompleteCallback(rcInFrameCompleteFunc const func)
+{
+  RcInFrameCompleteCallback = func;
+}
+
+/**
+ * \brief returns the number of complete input frames received so far (wraps around), can
+ * be used to detect a new frame without a frame complete callback
+ */
+uint8_t RcIn::getFrameCount()
+{
+  return RcInFrameCount;
+}
+
+#if defined(CONFIG_USE_HOST_CONTROL)
+/**
+ * \brief replace the received pulse duration of an input by pulse_duration_us - the input
+ * is good until the override is cleared. Only the measured signals are used by the
+ * frame detection and the failsafe checks.
+ */
+void RcIn::setOverride(E_RC_IN_SELECT const sel, uint16_t const pulse_duration_us)
+{
+  RcInOverridePulseDurationUs[sel] = pulse_duration_us;
+  RcInOverrideMask |= (1 << sel);
+}
+
+/**
+ * \brief use the received pulse duration of an input again
+ */
+void RcIn::clearOverride(E_RC_IN_SELECT const sel)
+{
+  RcInOverrideMask &= ~(1 << sel);
+}
+#endif
+
+/**
+ * \brief set the range of pulse durations which are accepted as valid (default 1000 ... 2000 us)
+ */
+void RcIn::setPulseWidthLimits(uint16_t const min_pulse_width_us, uint16_t const max_pulse_width_us)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    RcInMinPulseWidthUs = min_pulse_width_us;
+    RcInMaxPulseWidthUs = max_pulse_width_us;
+  }
+}
+
+#if defined(CONFIG_USE_EVENT_LOG)
+/**
+ * \brief returns the number of pulses on the selected input channel which have been
+ * rejected because of their duration (wraps around)
+ */
+uint8_t RcIn::getRejectedPulseCount(E_RC_IN_SELECT const sel)
+{
+  return RcInRejectedPulseCount[sel];
+}
+#endif
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+/**
+ * \brief returns the selected receiver and the state of both receivers
+ */
+void RcIn::getDiversityInfo(T_RC_IN_DIVERSITY_INFO * info)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    info->selected = (E_RC_IN_SOURCE) (RcInDiversitySource);
+    info->is_good[RC_IN_SOURCE_A] = RcInData[IN1].is_good && RcInData[IN2].is_good;
+    info->is_good[RC_IN_SOURCE_B] = RcInData[IN3].is_good && RcInData[IN4].is_good;
+    info->quality[RC_IN_SOURCE_A] = RcInDiversityQuality[RC_IN_SOURCE_A];
+    info->quality[RC_IN_SOURCE_B] = RcInDiversityQuality[RC_IN_SOURCE_B];
+    info->num_switches = RcInDiversityNumSwitches;
+  }
+}
+#endif
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+/**
+ * \brief this function is called every time a valid pulse has been received
+ * on the selected input channel. A frame is complete as soon as every good
+ * input channel has delivered a new pulse - the registered frame complete
+ * callback is executed in that case.
+ */
+void RcInXCheckFrameComplete(E_RC_IN_SELECT const sel)
+{
+  RcInFrameFreshMask |= (1 << sel);
+
+  uint8_t good_mask = 0;
+  for (uint8_t i = 0; i < NUM_RC_IN_CHANNELS; i++)
+  {
+    if (RcInData[i].is_good)
+    {
+      good_mask |= (1 << i);
+    }
+  }
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+  /* The receivers are not synchronized, the frames of the selected one count */
+  good_mask &= (RcInDiversitySource == RC_IN_SOURCE_A) ? ((1 << IN1) | (1 << IN2)) : ((1 << IN3) | (1 << IN4));
+#endif
+
+  bool const is_frame_complete = (good_mask != 0) && ((RcInFrameFreshMask & good_mask) == good_mask);
+
+  if (is_frame_complete)
+  {
+    /* The frame is completed by the falling edge of the current pulse */
+
+    uint16_t const frame_period_in_timer_steps = RcInData[sel].timer_stop - RcInFrameCompleteTimer;
+    bool const is_frame_period_valid = RcInFrameCompleteTimerIsValid
+        && (frame_period_in_timer_steps <= MAX_FRAME_PERIOD_IN_TIMER_STEPS);
+    uint16_t const frame_period_us = is_frame_period_valid ? (frame_period_in_timer_steps * TIMERSTEP_DURATION_US) : 0;
+
+    RcInFrameCompleteTimer = RcInData[sel].timer_stop;
+    RcInFrameCompleteTimerIsValid = true;
+    RcInFrameFreshMask = 0;
+    RcInFrameCount++;
+
+    if (RcInFrameCompleteCallback != 0)
+    {
+      RcInFrameCompleteCallback(frame_period_us);
+    }
+  }
+}
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+/**
+ * \brief returns true if both channels of a receiver deliver valid pulses
+ */
+bool isRcInSourceGood(uint8_t const source)
+{
+  uint8_t const first = source * NUM_DIVERSITY_CHANNELS;
+
+  return RcInData[first].is_good && RcInData[first + 1].is_good;
+}
+
+/**
+ * \brief returns true if a channel of the receiver has not delivered a valid pulse
+ * within MAX_DIVERSITY_PULSE_AGE_IN_TIMER_STEPS
+ */
+bool isRcInSourceStale(uint8_t const source, uint16_t const now)
+{
+  uint8_t const first = source * NUM_DIVERSITY_CHANNELS;
+
+  return (uint16_t) (now - RcInDiversityValidPulseTimer[first]) > MAX_DIVERSITY_PULSE_AGE_IN_TIMER_STEPS
+      || (uint16_t) (now - RcInDiversityValidPulseTimer[first + 1]) > MAX_DIVERSITY_PULSE_AGE_IN_TIMER_STEPS;
+}
+
+/**
+ * \brief select the other receiver
+ */
+void RcInXSwitchSource()
+{
+  RcInDiversitySource = (RcInDiversitySource == RC_IN_SOURCE_A) ? RC_IN_SOURCE_B : RC_IN_SOURCE_A;
+  RcInDiversityNumSwitches++;
+
+  /* The next frame is completed by the new receiver */
+
+  RcInFrameFreshMask = 0;
+  RcInFrameCompleteTimerIsValid = false;
+}
+
+/**
+ * \brief this function is called for every valid pulse - the receiver of the pulse
+ * replaces the selected one if the selected one has stopped delivering pulses. The
+ * pulse itself is complete, the logical channel therefore never returns a stale or
+ * partial value.
+ */
+void RcInXDiversityCheckPulse(E_RC_IN_SELECT const sel)
+{
+  RcInDiversityValidPulseTimer[sel] = RcInData[sel].timer_stop;
+
+  uint8_t const source = sel / NUM_DIVERSITY_CHANNELS;
+
+  if (source == RcInDiversitySource || !isRcInSourceGood(source) || isRcInSourceStale(source, RcInData[sel].timer_stop))
+  {
+    return;
+  }
+
+  if (!isRcInSourceGood(RcInDiversitySource) || isRcInSourceStale(RcInDiversitySource, RcInData[sel].timer_stop))
+  {
+    RcInXSwitchSource();
+  }
+}
+
+/**
+ * \brief this function is called from the timer 3 overflow interrupt service routine
+ * before the inputs are checked - determine the quality of both receivers within the
+ * elapsed timer cycle
+ */
+void RcInXDiversityMeasureQuality()
+{
+  for (uint8_t source = RC_IN_SOURCE_A; source <= RC_IN_SOURCE_B; source++)
+  {
+    uint8_t const first = source * NUM_DIVERSITY_CHANNELS;
+    uint8_t const pulses_received = (RcInData[first].pulses_received < RcInData[first + 1].pulses_received)
+        ? RcInData[first].pulses_received : RcInData[first + 1].pulses_received;
+
+    RcInDiversityQuality[source] = (pulses_received > RcInDiversityRejectedPulses[source])
+        ? (pulses_received - RcInDiversityRejectedPulses[source]) : 0;
+    RcInDiversityRejectedPulses[source] = 0;
+  }
+}
+
+/**
+ * \brief this function is called from the timer 3 overflow interrupt service routine
+ * after the inputs have been checked - a lost receiver is replaced, otherwise the
+ * receiver with the clearly better quality is selected
+ */
+void RcInXDiversitySelect()
+{
+  uint8_t const selected = RcInDiversitySource;
+  uint8_t const other = (selected == RC_IN_SOURCE_A) ? RC_IN_SOURCE_B : RC_IN_SOURCE_A;
+
+  if (!isRcInSourceGood(other))
+  {
+    return;
+  }
+
+  if (!isRcInSourceGood(selected) || RcInDiversityQuality[other] >= RcInDiversityQuality[selected] + DIVERSITY_QUALITY_HYSTERESIS)
+  {
+    RcInXSwitchSource();
+  }
+}
+#endif
+
+#if defined(CONFIG_USE_FAST_BOOT)
+/**
+ * \brief this function is called for every valid pulse on an input channel
+ * which is not good yet. The input is good as soon as enough consecutive
+ * pulses have been received, the rest of the current timer cycle is then
+ * checked for a proportional number of pulses.
+ */
+void RcInXAcquire(E_RC_IN_SELECT const sel, uint16_t const last_timer_stop)
+{
+  uint16_t const pulse_period_in_timer_steps = RcInData[sel].timer_stop - last_timer_stop;
+
+  if (RcInAcquirePulses[sel] > 0 && pulse_period_in_timer_steps > MAX_ACQUIRE_PULSE_PERIOD_IN_TIMER_STEPS)
+  {
+    RcInAcquirePulses[sel] = 0;
+  }
+
+  RcInAcquirePulses[sel]++;
+
+  if (RcInAcquirePulses[sel] < CONFIG_FAST_BOOT_ACQUIRE_PULSES)
+  {
+    return;
+  }
+
+  uint32_t const remaining_timer_steps = 0x10000UL - RcInData[sel].timer_stop;
+
+  RcInMinPulsesPerTimerCycle[sel] = (remaining_timer_steps * MIN_PULSES_PER_TIMER_CYCLE) >> 16;
+  RcInData[sel].pulses_received = 0;
+  RcInData[sel].is_good = true;
+}
+#endif
+
 /************************************************************************/
 /* PUBLIC FUNCTIONS	                                                    */
 /************************************************************************/
@@ -185,7 +572,22 @@ void RcInXTimerOverflowISR(E_RC_IN_SELECT const sel)
    * as we expect. Otherwise we might be in a failsafe situation
    */
 
+#if defined(CONFIG_USE_FAST_BOOT)
+  bool const pulses_lost = RcInData[sel].pulses_received < RcInMinPulsesPerTimerCycle[sel];
+
+  RcInMinPulsesPerTimerCycle[sel] = MIN_PULSES_PER_TIMER_CYCLE;
+
+  /* A lost input has to be acquired again, an acquisition in progress
+   * continues across the end of the timer cycle
+   */
+
+  if (pulses_lost && RcInData[sel].is_good)
+  {
+    RcInAcquirePulses[sel] = 0;
+  }
+#else
   bool const pulses_lost = RcInData[sel].pulses_received < MIN_PULSES_PER_TIMER_CYCLE;
+#endif
 
   if (pulses_lost)
   {
@@ -197,6 +599,10 @@ void RcInXTimerOverflowISR(E_RC_IN_SELECT const sel)
     RcInData[sel].pulse_state = RISING;
     RcInData[sel].triggerAtRisingEdge();
     RcInData[sel].is_good = false;
+
+    /* The frame period can not be determined after loosing signals */
+
+    RcInFrameCompleteTimerIsValid = false;
   }
   else
   {
@@ -222,21 +628,59 @@ void RcInXIntXISR(E_RC_IN_SELECT const sel)
   }
   else if (RcInData[sel].pulse_state == FALLING)
   {
+#if defined(CONFIG_USE_FAST_BOOT)
+    uint16_t const last_timer_stop = RcInData[sel].timer_stop;
+#endif
     RcInData[sel].timer_stop = TCNT3;
     RcInData[sel].pulse_state = RISING;
     RcInData[sel].triggerAtRisingEdge();
     /* Calculate the duration of the pulse */
 
     uint16_t const pulse_duration_in_timer_steps = RcInData[sel].timer_stop - RcInData[sel].timer_start;
-    uint16_t const timerstep_duration_in_us      = 4;
-    uint16_t const pulse_duration_in_us          = pulse_duration_in_timer_steps * timerstep_duration_in_us;
+    uint16_t const pulse_duration_in_us          = pulse_duration_in_timer_steps * TIMERSTEP_DURATION_US;
 
     /* Only update when the value is within acceptable bounds */
-    if (pulse_duration_in_us >= MIN_PULSE_WIDTH_US && pulse_duration_in_us <= MAX_PULSE_WIDTH_US)
+    if (pulse_duration_in_us >= RcInMinPulseWidthUs && pulse_duration_in_us <= RcInMaxPulseWidthUs)
     {
       RcInData[sel].pulse_duration_us = pulse_duration_in_us;
       RcInData[sel].pulses_received++;
+
+#if defined(CONFIG_USE_FAST_BOOT)
+      if (!RcInData[sel].is_good)
+      {
+        RcInXAcquire(sel, last_timer_stop);
+      }
+#endif
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+      RcInXDiversityCheckPulse(sel);
+#endif
+
+#if defined(CONFIG_USE_LATENCY_INSTRUMENTATION)
+      Latency::markInputEdge(RcInData[sel].timer_stop);
+#endif
+
+#if defined(CONFIG_USE_IDLE_SLEEP)
+      Scheduler::signalEvent();
+#endif
+
+      RcInXCheckFrameComplete(sel);
+    }
+#if defined(CONFIG_USE_EVENT_LOG) || defined(CONFIG_USE_RC_IN_DIVERSITY)
+    else
+    {
+#if defined(CONFIG_USE_EVENT_LOG)
+      RcInRejectedPulseCount[sel]++;
+#endif
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+      uint8_t const source = sel / NUM_DIVERSITY_CHANNELS;
+      if (RcInDiversityRejectedPulses[source] < 0xFF)
+      {
+        RcInDiversityRejectedPulses[source]++;
+      }
+#endif
     }
+#endif
   }
 }
 
@@ -249,11 +693,29 @@ void RcInXIntXISR(E_RC_IN_SELECT const sel)
  */
 ISR(TIMER3_OVF_vect)
 {
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+  RcInXDiversityMeasureQuality();
+#endif
+
   RcInXTimerOverflowISR(IN1);
   RcInXTimerOverflowISR(IN2);
   RcInXTimerOverflowISR(IN3);
   RcInXTimerOverflowISR(IN4);
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+  RcInXDiversitySelect();
+#endif
+
+#if defined(CONFIG_USE_FAST_BOOT)
+  Boot::onTimerOverflow();
+#endif
+
+#if defined(CONFIG_USE_IDLE_SLEEP)
+  /* The good state of the inputs may have changed */
+  Scheduler::signalEvent();
+#endif
 }
+
 /** 
  * \brief INT0 (PD0 = IN4) interrupt service routine
  */
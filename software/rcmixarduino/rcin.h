@@ -32,6 +32,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "config.h"
+
 /************************************************************************/
 /* PUBLIC TYPES                                                         */
 /************************************************************************/
@@ -41,6 +43,36 @@ typedef enum
   IN1 = 0, IN2 = 1, IN3 = 2, IN4 = 3
 } E_RC_IN_SELECT;
 
+/* This function is called from interrupt context every time a complete input
+ * frame has been received, that is as soon as every good input channel has
+ * delivered a new pulse. frame_period_us is the time elapsed since the last
+ * completed frame or 0 if it is unknown (first frame, lost signals).
+ */
+
+typedef void (*rcInFrameCompleteFunc)(uint16_t const frame_period_us);
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+/* Diversity of two receivers with two channels each: receiver A is
+ * connected to IN1 and IN2, receiver B to IN3 and IN4. IN1 and IN2 are
+ * the logical channels, they deliver the pulses of the selected receiver
+ * and are good as long as one of the receivers is good. IN3 and IN4
+ * return the raw signals of receiver B.
+ */
+
+typedef enum
+{
+  RC_IN_SOURCE_A = 0, RC_IN_SOURCE_B = 1
+} E_RC_IN_SOURCE;
+
+typedef struct
+{
+  E_RC_IN_SOURCE selected;
+  bool           is_good[2];      /* Both channels of the receiver deliver valid pulses */
+  uint8_t        quality[2];      /* Valid minus rejected pulses within the last timer cycle (262 ms) */
+  uint16_t       num_switches;    /* Number of changes of the selected receiver (wraps around) */
+} T_RC_IN_DIVERSITY_INFO;
+#endif
+
 /************************************************************************/
 /* PUBLIC PROTOTYPES                                                    */
 /************************************************************************/
@@ -65,6 +97,51 @@ public:
    */
   static uint16_t getPulseDurationUs(E_RC_IN_SELECT const sel);
 
+  /**
+   * \brief register a function which is called whenever a complete input frame has been received
+   */
+  static void setFrameCompleteCallback(rcInFrameCompleteFunc const func);
+
+  /**
+   * \brief returns the number of complete input frames received so far (wraps around), can
+   * be used to detect a new frame without a frame complete callback
+   */
+  static uint8_t getFrameCount();
+
+  /**
+   * \brief set the range of pulse durations which are accepted as valid (default 1000 ... 2000 us)
+   */
+  static void setPulseWidthLimits(uint16_t const min_pulse_width_us, uint16_t const max_pulse_width_us);
+
+#if defined(CONFIG_USE_EVENT_LOG)
+  /**
+   * \brief returns the number of pulses on the selected input channel which have been
+   * rejected because of their duration (wraps around)
+   */
+  static uint8_t getRejectedPulseCount(E_RC_IN_SELECT const sel);
+#endif
+
+#if defined(CONFIG_USE_RC_IN_DIVERSITY)
+  /**
+   * \brief returns the selected receiver and the state of both receivers
+   */
+  static void getDiversityInfo(T_RC_IN_DIVERSITY_INFO * info);
+#endif
+
+#if defined(CONFIG_USE_HOST_CONTROL)
+  /**
+   * \brief replace the received pulse duration of an input by pulse_duration_us - the input
+   * is good until the override is cleared. Only the measured signals are used by the
+   * frame detection and the failsafe checks.
+   */
+  static void setOverride(E_RC_IN_SELECT const sel, uint16_t const pulse_duration_us);
+
+  /**
+   * \brief use the received pulse duration of an input again
+   */
+  static void clearOverride(E_RC_IN_SELECT const sel);
+#endif
+
 private:
 
   /**
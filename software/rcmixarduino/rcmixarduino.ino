@@ -37,35 +37,290 @@
 #include "rcin.h"
 #include "rcout.h"
 #include "control.h"
+#include "scheduler.h"
+#include "curve.h"
+#include "telemetry.h"
+#include "param.h"
+#include "command.h"
+#include "joystick.h"
+#include "hostlink.h"
+#include "control_host.h"
+#include "watchdog.h"
+#include "eventlog.h"
 
 #include "config.h"
 
 #if defined(CONFIG_USE_CONTROL_DEMO)
 #include "control_demo.h"
-#elif defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS)
+#endif
+#if defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS)
 #include "control_omnidrive_3_wheels.h"
 #endif
+#if defined(CONFIG_USE_CONTROL_MECANUM_4_WHEELS)
+#include "control_mecanum_4_wheels.h"
+#endif
+#if defined(CONFIG_USE_CONTROL_DIFFERENTIAL)
+#include "control_differential.h"
+#endif
+#if defined(CONFIG_USE_CONTROL_BYTECODE)
+#include "control_bytecode.h"
+#endif
+#if defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS_DSL)
+#include "control_omnidrive_3_wheels_dsl.h"
+#endif
 
 /************************************************************************/
 /* GLOBAL VARIABLES                                                     */
 /************************************************************************/
 
+/* With CONFIG_USE_HOST_CONTROL every mixer is wrapped by ControlHost which
+ * arbitrates between the rc inputs and the host computer
+ */
+
+#if defined(CONFIG_USE_HOST_CONTROL)
+#define CONTROL_MIXER(Mixer) ControlHost<Mixer>
+#else
+#define CONTROL_MIXER(Mixer) Mixer
+#endif
+
+#if defined(CONFIG_USE_CONTROL_PROFILES)
+
+/* The profile is selected by CONFIG_CONTROL_PROFILE_SWITCH_CHANNEL, the
+ * first profile at 1000 us, the last one at 2000 us
+ */
+
+static T_CONTROL_PROFILE const PROFILES[] =
+{
+#if defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS)
+  /* Precision mode */
+  { CONTROL_MIXER(ControlOmnidrive3Wheels)::isGoodFunc, CONTROL_MIXER(ControlOmnidrive3Wheels)::failsafeFunc,
+    CONTROL_MIXER(ControlOmnidrive3Wheels)::mixingFunc, CONTROL_MIXER(ControlOmnidrive3Wheels)::transitionToFailsafeFunc,
+    CONTROL_MIXER(ControlOmnidrive3Wheels)::transitionToMixingFunc, 50 },
+  /* Sport mode */
+  { CONTROL_MIXER(ControlOmnidrive3Wheels)::isGoodFunc, CONTROL_MIXER(ControlOmnidrive3Wheels)::failsafeFunc,
+    CONTROL_MIXER(ControlOmnidrive3Wheels)::mixingFunc, CONTROL_MIXER(ControlOmnidrive3Wheels)::transitionToFailsafeFunc,
+    CONTROL_MIXER(ControlOmnidrive3Wheels)::transitionToMixingFunc, 100 },
+#endif
+#if defined(CONFIG_USE_CONTROL_MECANUM_4_WHEELS)
+  { CONTROL_MIXER(ControlMecanum4Wheels)::isGoodFunc, CONTROL_MIXER(ControlMecanum4Wheels)::failsafeFunc,
+    CONTROL_MIXER(ControlMecanum4Wheels)::mixingFunc, CONTROL_MIXER(ControlMecanum4Wheels)::transitionToFailsafeFunc,
+    CONTROL_MIXER(ControlMecanum4Wheels)::transitionToMixingFunc, 100 },
+#endif
+#if defined(CONFIG_USE_CONTROL_DIFFERENTIAL)
+  { CONTROL_MIXER(ControlDifferential)::isGoodFunc, CONTROL_MIXER(ControlDifferential)::failsafeFunc,
+    CONTROL_MIXER(ControlDifferential)::mixingFunc, CONTROL_MIXER(ControlDifferential)::transitionToFailsafeFunc,
+    CONTROL_MIXER(ControlDifferential)::transitionToMixingFunc, 100 },
+#endif
+#if defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS_DSL)
+  { CONTROL_MIXER(ControlOmnidrive3WheelsDsl)::isGoodFunc, CONTROL_MIXER(ControlOmnidrive3WheelsDsl)::failsafeFunc,
+    CONTROL_MIXER(ControlOmnidrive3WheelsDsl)::mixingFunc, CONTROL_MIXER(ControlOmnidrive3WheelsDsl)::transitionToFailsafeFunc,
+    CONTROL_MIXER(ControlOmnidrive3WheelsDsl)::transitionToMixingFunc, 100 },
+#endif
+#if defined(CONFIG_USE_CONTROL_BYTECODE)
+  { CONTROL_MIXER(ControlBytecode)::isGoodFunc, CONTROL_MIXER(ControlBytecode)::failsafeFunc,
+    CONTROL_MIXER(ControlBytecode)::mixingFunc, CONTROL_MIXER(ControlBytecode)::transitionToFailsafeFunc,
+    CONTROL_MIXER(ControlBytecode)::transitionToMixingFunc, 100 },
+#endif
+#if defined(CONFIG_USE_CONTROL_DEMO)
+  { CONTROL_MIXER(ControlDemo)::isGoodFunc, CONTROL_MIXER(ControlDemo)::failsafeFunc,
+    CONTROL_MIXER(ControlDemo)::mixingFunc, CONTROL_MIXER(ControlDemo)::transitionToFailsafeFunc,
+    CONTROL_MIXER(ControlDemo)::transitionToMixingFunc, 100 },
+#endif
+};
+
+ProfileControl control(PROFILES, sizeof(PROFILES) / sizeof(PROFILES[0]), CONFIG_CONTROL_PROFILE_SWITCH_CHANNEL);
+
+#elif defined(CONFIG_USE_STATIC_CONTROL)
+
+/* The mixer is resolved at compile time - the whole mix path can be
+ * inlined into the main loop
+ */
+
+#if defined(CONFIG_USE_CONTROL_DEMO)
+StaticControl<CONTROL_MIXER(ControlDemo)> control;
+#elif defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS)
+StaticControl<CONTROL_MIXER(ControlOmnidrive3Wheels)> control;
+#elif defined(CONFIG_USE_CONTROL_MECANUM_4_WHEELS)
+StaticControl<CONTROL_MIXER(ControlMecanum4Wheels)> control;
+#elif defined(CONFIG_USE_CONTROL_DIFFERENTIAL)
+StaticControl<CONTROL_MIXER(ControlDifferential)> control;
+#elif defined(CONFIG_USE_CONTROL_BYTECODE)
+StaticControl<CONTROL_MIXER(ControlBytecode)> control;
+#elif defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS_DSL)
+StaticControl<CONTROL_MIXER(ControlOmnidrive3WheelsDsl)> control;
+#endif
+
+#else
+
 Control control(
 #if defined(CONFIG_USE_CONTROL_DEMO)
-  &ControlDemo::isGoodFunc, 
-  &ControlDemo::failsafeFunc, 
-  &ControlDemo::mixingFunc, 
-  &ControlDemo::transitionToFailsafeFunc, 
-  &ControlDemo::transitionToMixingFunc
+  &CONTROL_MIXER(ControlDemo)::isGoodFunc, 
+  &CONTROL_MIXER(ControlDemo)::failsafeFunc, 
+  &CONTROL_MIXER(ControlDemo)::mixingFunc, 
+  &CONTROL_MIXER(ControlDemo)::transitionToFailsafeFunc, 
+  &CONTROL_MIXER(ControlDemo)::transitionToMixingFunc
 #elif defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS)
-  ControlOmnidrive3Wheels::isGoodFunc, 
-  ControlOmnidrive3Wheels::failsafeFunc, 
-  ControlOmnidrive3Wheels::mixingFunc, 
-  ControlOmnidrive3Wheels::transitionToFailsafeFunc, 
-  ControlOmnidrive3Wheels::transitionToMixingFunc
+  CONTROL_MIXER(ControlOmnidrive3Wheels)::isGoodFunc, 
+  CONTROL_MIXER(ControlOmnidrive3Wheels)::failsafeFunc, 
+  CONTROL_MIXER(ControlOmnidrive3Wheels)::mixingFunc, 
+  CONTROL_MIXER(ControlOmnidrive3Wheels)::transitionToFailsafeFunc, 
+  CONTROL_MIXER(ControlOmnidrive3Wheels)::transitionToMixingFunc
+#elif defined(CONFIG_USE_CONTROL_MECANUM_4_WHEELS)
+  CONTROL_MIXER(ControlMecanum4Wheels)::isGoodFunc, 
+  CONTROL_MIXER(ControlMecanum4Wheels)::failsafeFunc, 
+  CONTROL_MIXER(ControlMecanum4Wheels)::mixingFunc, 
+  CONTROL_MIXER(ControlMecanum4Wheels)::transitionToFailsafeFunc, 
+  CONTROL_MIXER(ControlMecanum4Wheels)::transitionToMixingFunc
+#elif defined(CONFIG_USE_CONTROL_DIFFERENTIAL)
+  CONTROL_MIXER(ControlDifferential)::isGoodFunc, 
+  CONTROL_MIXER(ControlDifferential)::failsafeFunc, 
+  CONTROL_MIXER(ControlDifferential)::mixingFunc, 
+  CONTROL_MIXER(ControlDifferential)::transitionToFailsafeFunc, 
+  CONTROL_MIXER(ControlDifferential)::transitionToMixingFunc
+#elif defined(CONFIG_USE_CONTROL_BYTECODE)
+  CONTROL_MIXER(ControlBytecode)::isGoodFunc, 
+  CONTROL_MIXER(ControlBytecode)::failsafeFunc, 
+  CONTROL_MIXER(ControlBytecode)::mixingFunc, 
+  CONTROL_MIXER(ControlBytecode)::transitionToFailsafeFunc, 
+  CONTROL_MIXER(ControlBytecode)::transitionToMixingFunc
+#elif defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS_DSL)
+  CONTROL_MIXER(ControlOmnidrive3WheelsDsl)::isGoodFunc, 
+  CONTROL_MIXER(ControlOmnidrive3WheelsDsl)::failsafeFunc, 
+  CONTROL_MIXER(ControlOmnidrive3WheelsDsl)::mixingFunc, 
+  CONTROL_MIXER(ControlOmnidrive3WheelsDsl)::transitionToFailsafeFunc, 
+  CONTROL_MIXER(ControlOmnidrive3WheelsDsl)::transitionToMixingFunc
 #endif
   );
 
+#endif
+
+/************************************************************************/
+/* FUNCTIONS                                                            */
+/************************************************************************/
+
+#if defined(CONFIG_USE_PARAM)
+/**
+ * \brief apply the active values of the parameter store to the modules
+ */
+void applyParameters()
+{
+#if defined(CONFIG_USE_CURVE)
+  for (uint8_t sel = IN1; sel <= IN3; sel++)
+  {
+    Curve::setDeadzone((E_RC_IN_SELECT) (sel), Param::get(PARAM_DEADZONE_US));
+    Curve::setCenter((E_RC_IN_SELECT) (sel), Param::get(PARAM_CENTER_US));
+  }
+#endif
+
+  RcIn::setPulseWidthLimits(Param::get(PARAM_MIN_PULSE_WIDTH_US), Param::get(PARAM_MAX_PULSE_WIDTH_US));
+  RcOut::setFramePeriodUs(Param::get(PARAM_FRAME_PERIOD_US));
+
+#if defined(CONFIG_USE_JOYSTICK)
+  for (uint8_t sel = IN1; sel <= IN4; sel++)
+  {
+    Joystick::setCalibration((E_RC_IN_SELECT) (sel), Param::get(PARAM_MIN_PULSE_WIDTH_US), Param::get(PARAM_CENTER_US),
+        Param::get(PARAM_MAX_PULSE_WIDTH_US));
+  }
+#endif
+
+#if defined(CONFIG_USE_HOST_CONTROL)
+  HostLink::setTimeoutMs(Param::get(PARAM_HOST_TIMEOUT_MS));
+  HostLink::setFallback((E_HOST_FALLBACK) (Param::get(PARAM_HOST_FALLBACK)));
+#endif
+
+#if defined(CONFIG_USE_CONTROL_PROFILES)
+  uint16_t const profile = Param::get(PARAM_PROFILE);
+  control.setFixedProfile((profile == 0) ? ProfileControl::PROFILE_BY_SWITCH : (uint8_t) (profile - 1));
+#endif
+}
+#endif
+
+/************************************************************************/
+/* TASKS                                                                */
+/************************************************************************/
+
+#if defined(CONFIG_USE_SCHEDULER)
+
+/**
+ * \brief mixing - executed in every pass of the scheduler (highest priority)
+ */
+void mixTask()
+{
+#if defined(CONFIG_USE_PARAM)
+  /* Changed parameters become active at the start of an output frame */
+  if (Param::update())
+  {
+    applyParameters();
+  }
+#endif
+
+  control.execute();
+
+#if defined(CONFIG_USE_TELEMETRY)
+  Telemetry::record(control.isMixing());
+#endif
+}
+
+#if defined(CONFIG_USE_JOYSTICK)
+/**
+ * \brief joystick - executed in every pass of the scheduler right after mixing
+ */
+void joystickTask()
+{
+  Joystick::update();
+}
+#endif
+
+/**
+ * \brief led - executed with 10 Hz
+ */
+void ledTask()
+{
+  Led::update();
+}
+
+#if defined(CONFIG_USE_TELEMETRY)
+/**
+ * \brief telemetry - executed every 5 ms (lowest priority)
+ */
+void telemetryTask()
+{
+  Telemetry::transmit();
+}
+#endif
+
+#if defined(CONFIG_USE_EVENT_LOG)
+/**
+ * \brief event log - executed every 10 ms
+ */
+void eventLogTask()
+{
+  EventLog::process(control.isMixing());
+}
+#endif
+
+#if defined(CONFIG_USE_COMMAND)
+/**
+ * \brief commands - executed every 1 ms (host control at up to 1 kHz)
+ */
+void commandTask()
+{
+  Command::process();
+
+#if defined(CONFIG_USE_PARAM)
+  /* Background write of the parameters to the EEPROM */
+  Param::process();
+#endif
+
+#if defined(CONFIG_USE_CONTROL_BYTECODE)
+  /* Background write of an uploaded mixing program to the EEPROM */
+  ControlBytecode::process();
+#endif
+}
+#endif
+
+#endif
+
 /************************************************************************/
 /* ARDUINO FUNCTIONS                                                    */
 /************************************************************************/
@@ -74,12 +329,154 @@ void setup()
 {
   Led::begin();
   RcIn::begin();
+
+  /* Failsafe policy of the outputs (default: cut the pulses immediately) */
+
+#if defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS)
+  /* The ESCs of the omnidrive react more predictable to a commanded
+   * neutral than to missing pulses
+   */
+  RcOut::setFailsafePolicy(OUT1, 0, OUTx_FAILSAFE_PRESET, 1500);
+  RcOut::setFailsafePolicy(OUT2, 0, OUTx_FAILSAFE_PRESET, 1500);
+  RcOut::setFailsafePolicy(OUT3, 0, OUTx_FAILSAFE_PRESET, 1500);
+#endif
+
+#if defined(CONFIG_USE_CONTROL_MECANUM_4_WHEELS)
+  RcOut::setFailsafePolicy(OUT1, 0, OUTx_FAILSAFE_PRESET, 1500);
+  RcOut::setFailsafePolicy(OUT2, 0, OUTx_FAILSAFE_PRESET, 1500);
+  RcOut::setFailsafePolicy(OUT3, 0, OUTx_FAILSAFE_PRESET, 1500);
+  RcOut::setFailsafePolicy(OUT4, 0, OUTx_FAILSAFE_PRESET, 1500);
+#endif
+
+#if defined(CONFIG_USE_CONTROL_DIFFERENTIAL)
+  RcOut::setFailsafePolicy(OUT1, 0, OUTx_FAILSAFE_PRESET, 1500);
+  RcOut::setFailsafePolicy(OUT2, 0, OUTx_FAILSAFE_PRESET, 1500);
+#endif
+
+#if defined(CONFIG_USE_FAST_BOOT)
+  /* The outputs are in failsafe until the mixer takes over so that they
+   * emit their failsafe preset from the first frame on
+   */
+
+  for (uint8_t sel = OUT1; sel <= OUT6; sel++)
+  {
+    RcOut::setRcOutState((E_RC_OUT_SELECT) (sel), OUTx_FAILSAFE);
+  }
+#endif
+
+#if defined(CONFIG_USE_WATCHDOG)
+  /* After a watchdog reset the outputs continue with their last pulses */
+  Watchdog::begin();
+#endif
+
+  /* The outputs are started as soon as their failsafe policy is known */
+
   RcOut::begin();
+
+#if defined(CONFIG_USE_CONTROL_BYTECODE)
+  /* An invalid program keeps the mixer in failsafe */
+  ControlBytecode::load();
+#endif
+
+  /* Slew rate limit of the outputs (default: no limit) */
+
+#if defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS)
+  /* Ramp the drive motors from neutral to full speed within 0.4 s
+   * (500 us / 25 us per frame = 20 frames) to avoid current spikes
+   */
+  RcOut::setSlewRateLimit(OUT1, 25);
+  RcOut::setSlewRateLimit(OUT2, 25);
+  RcOut::setSlewRateLimit(OUT3, 25);
+#endif
+
+#if defined(CONFIG_USE_CURVE)
+  Curve::begin();
+
+#if defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS)
+  /* A smooth deadzone avoids the jump of the motors from neutral to
+   * DEADZONE_US when the stick leaves the center position
+   */
+  Curve::setDeadzone(IN1, ControlOmnidrive3Wheels::DEADZONE_US);
+  Curve::setDeadzone(IN2, ControlOmnidrive3Wheels::DEADZONE_US);
+  Curve::setDeadzone(IN3, ControlOmnidrive3Wheels::DEADZONE_US);
+#endif
+
+#if defined(CONFIG_USE_CONTROL_MECANUM_4_WHEELS)
+  Curve::setDeadzone(IN1, ControlMecanum4Wheels::DEADZONE_US);
+  Curve::setDeadzone(IN2, ControlMecanum4Wheels::DEADZONE_US);
+  Curve::setDeadzone(IN3, ControlMecanum4Wheels::DEADZONE_US);
+#endif
+
+#if defined(CONFIG_USE_CONTROL_DIFFERENTIAL)
+  Curve::setDeadzone(IN1, ControlDifferential::DEADZONE_US);
+  Curve::setDeadzone(IN2, ControlDifferential::DEADZONE_US);
+#endif
+#endif
+
+#if defined(CONFIG_USE_JOYSTICK)
+  Joystick::begin();
+#endif
+
+#if defined(CONFIG_USE_HOST_CONTROL)
+  HostLink::begin();
+#endif
+
+#if defined(CONFIG_USE_PARAM)
+  /* The parameters override the defaults configured above */
+  Param::begin();
+  applyParameters();
+#endif
+
+#if defined(CONFIG_USE_EVENT_LOG)
+  EventLog::begin();
+#endif
+
+#if defined(CONFIG_USE_TELEMETRY)
+  Telemetry::begin();
+#endif
+
+#if defined(CONFIG_USE_COMMAND)
+  Command::begin();
+#endif
+
+#if defined(CONFIG_USE_SCHEDULER)
+  Scheduler::begin();
+  Scheduler::addTask(mixTask, SCHEDULER_EVERY_PASS);
+#if defined(CONFIG_USE_JOYSTICK)
+  Scheduler::addTask(joystickTask, SCHEDULER_EVERY_PASS);
+#endif
+  Scheduler::addTask(ledTask, 100);
+#if defined(CONFIG_USE_TELEMETRY)
+  Scheduler::addTask(telemetryTask, 5);
+#endif
+#if defined(CONFIG_USE_COMMAND)
+  Scheduler::addTask(commandTask, 1);
+#endif
+#if defined(CONFIG_USE_EVENT_LOG)
+  Scheduler::addTask(eventLogTask, 10);
+#endif
+#endif
+
+#if defined(CONFIG_USE_RCOUT_PHASE_LOCK)
+  RcIn::setFrameCompleteCallback(RcOut::onInputFrameComplete);
+  RcOut::enablePhaseLock(CONFIG_RCOUT_PHASE_LOCK_LEAD_US);
+#endif
 }
 
 void loop()
 {
+#if defined(CONFIG_USE_SCHEDULER)
+  Scheduler::run();
+#else
+#if defined(CONFIG_USE_PARAM)
+  if (Param::update())
+  {
+    applyParameters();
+  }
+#endif
+
   control.execute();
+#endif
 }
 
 /************************************************************************/
@@ -92,6 +489,10 @@ void loop()
  */
 ISR(BADISR_vect)
 {
+#if defined(CONFIG_USE_WATCHDOG)
+	Watchdog::markBadInterrupt();
+#endif
+
 	for(;;)
 	{
 		_delay_ms(50);
@@ -33,7 +33,18 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 
+#include <util/atomic.h>
+
 #include "hal.h"
+#include "config.h"
+
+#if defined(CONFIG_USE_LATENCY_INSTRUMENTATION)
+#include "latency.h"
+#endif
+
+#if defined(CONFIG_USE_FAST_BOOT)
+#include "boot.h"
+#endif
 
 /************************************************************************/
 /* PRIVATE TYPEDEFS													    */
@@ -43,13 +54,6 @@
 
 typedef void (*initRcOutFunc)(void);
 
-/* Defines two function pointers which can be used so set (to HIGH) or
- * clear (to LOW) an RcOut pwm output
- */
-
-typedef void (*setRcOutFunc)(void);
-typedef void (*clearRcOutFunc)(void);
-
 /* This structure contains the complete information which is required to
  * control an rc output via this module 
  */
@@ -62,15 +66,90 @@ typedef struct
 
   E_RC_OUT_STATE state; /* The current state of the rc output, whether it is turned on or off */
   uint16_t pulse_duration_us; /* The pulse duration of the rc output pulse (duration of the output pin being 'high') */
+  uint16_t pulse_duration_timer_steps; /* The pulse duration after applying the output transform in timer steps (0.5 us) */
+  uint16_t slew_rate_limit_timer_steps; /* Maximum change of the pulse duration per frame, 0 = no limit */
+
+  /* Output transform - applied once when the pulse duration is set, the
+   * pulse duration is always clamped to the endpoints
+   */
+
+  bool     is_reversed;             /* Mirror the pulse duration around the center value */
+  int16_t  subtrim_us;              /* Offset which is added to the pulse duration */
+  uint16_t min_pulse_duration_us;   /* Lower endpoint */
+  uint16_t max_pulse_duration_us;   /* Upper endpoint */
 
-  /* I/O functions for accessing the concrete GPIO output pin */
+  /* Failsafe policy - applied while the state is OUTx_FAILSAFE */
 
-  initRcOutFunc   initRcOut;  /* This function pointer points to a function which initializes the gpio output functionality of a rc output */
-  setRcOutFunc    setRcOut;   /* This function pointer points to the function which sets the rc output to 'high' */
-  clearRcOutFunc  clearRcOut; /* This function pointer points to the function which clear the rc output to 'low' */
+  E_RC_OUT_FAILSAFE_ACTION failsafe_action;                     /* Action taken after the hold time has expired */
+  uint16_t                 failsafe_pulse_duration_timer_steps; /* Pulse duration for OUTx_FAILSAFE_PRESET */
+  uint16_t                 failsafe_hold_ms;                    /* Hold time as configured */
+  uint16_t                 failsafe_hold_frames;                /* Number of frames for which the last pulse duration is held (hold time / frame period) */
+
+  /* Frame fields - evaluated once for every output frame when the frame
+   * is prepared
+   */
+
+  bool     frame_is_on;                       /* Whether a pulse is generated within the frame */
+  uint16_t frame_pulse_duration_timer_steps;  /* Pulse duration within the frame */
+  uint16_t failsafe_hold_frames_remaining;    /* Frames remaining until the failsafe action is taken */
+
+  /* Bumpless transfer - the difference between the pulse duration output
+   * before the transfer and the new pulse duration is reduced to zero
+   * over a number of frames
+   */
+
+  int16_t  transfer_offset_timer_steps;       /* Offset added to the pulse duration */
+  int16_t  transfer_step_timer_steps;         /* Reduction of the offset per frame */
+  uint8_t  transfer_frames_remaining;         /* Frames remaining until the transfer is complete */
+
+  /* I/O for accessing the concrete GPIO output pin */
+
+  initRcOutFunc     initRcOut;  /* This function pointer points to a function which initializes the gpio output functionality of a rc output */
+  volatile uint8_t * port;      /* The PORT register of the rc output */
+  uint8_t            bm;        /* The bit mask of the rc output within its PORT register */
 
 } T_RC_OUT_DATA;
 
+/* A bit mask with one bit per rc output (bit 0 = OUT1) */
+
+typedef uint8_t T_RC_OUT_MASK;
+
+/* The rc outputs are distributed over PORTB, PORTC and PORTD (see hal.h).
+ * All edges of one port within one event are written with a single store.
+ */
+
+typedef struct
+{
+  uint8_t portb;
+  uint8_t portc;
+  uint8_t portd;
+} T_RC_OUT_PORT_MASK;
+
+/* An output edge event - all outputs in clear_mask are cleared when
+ * Timer 1 reaches compare_value
+ */
+
+typedef struct
+{
+  uint16_t           compare_value;
+  T_RC_OUT_PORT_MASK clear_mask;
+} T_RC_OUT_EVENT;
+
+/* This structure contains the complete schedule of one output frame.
+ * All outputs in set_mask are set at the start of the frame, the falling
+ * edges follow sorted by time with coincident edges merged into a single
+ * event.
+ */
+
+typedef struct
+{
+  uint16_t           start_value;     /* Timer/Counter value at the start of the frame */
+  T_RC_OUT_MASK      set_mask;        /* Outputs which are set at the start of the frame */
+  T_RC_OUT_PORT_MASK set_port_mask;   /* set_mask converted to the output ports */
+  uint8_t            num_events;      /* Number of valid entries in event */
+  T_RC_OUT_EVENT     event[8];        /* Falling edges sorted by compare_value, at most one per output */
+} T_RC_OUT_FRAME;
+
 /************************************************************************/
 /* PRIVATE CONTANTS													    */
 /************************************************************************/
@@ -84,6 +163,42 @@ static uint8_t const NUM_RC_OUT_CHANNELS = 6;
  */
 
 static uint16_t const TIMER_RELOAD_VALUE = 0x63BF;
+static uint16_t const TIMER_STEPS_PER_FRAME = 0xFFFF - TIMER_RELOAD_VALUE;
+
+/* Limits of the frame period (see RcOut::setFramePeriodUs), the shortest
+ * frame has to hold the longest pulse plus the preparation of the next frame
+ */
+
+static uint16_t const MIN_FRAME_PERIOD_US = 5000;
+static uint16_t const MAX_FRAME_PERIOD_US = 30000;
+
+static uint16_t const CENTER_PULSE_DURATION_US = 1500;
+static uint16_t const MIN_ENDPOINT_US          = 500;
+static uint16_t const MAX_ENDPOINT_US          = 2500;
+
+/* The next frame is prepared shortly before the end of the current frame
+ * so that it contains the latest values written by the mixer. Output edges
+ * which are less than MIN_COMPARE_DISTANCE apart are handled within a single
+ * execution of the compare match interrupt service routine.
+ */
+
+static uint16_t const PREPARE_FRAME_COMPARE_VALUE          = 0xFFFF - 256 * 2;
+static uint16_t const MIN_COMPARE_DISTANCE_IN_TIMER_STEPS  = 16 * 2;
+
+#if defined(CONFIG_USE_FAST_BOOT)
+/* The timer is started shortly before the preparation of a frame so that
+ * the first frame starts about 300 us after RcOut::begin
+ */
+
+static uint16_t const FAST_BOOT_START_VALUE                = PREPARE_FRAME_COMPARE_VALUE - 16 * 2;
+#endif
+
+/* Phase-lock: The length of the output frame is adjusted by at most
+ * +/- 2 ms (18 ms - 22 ms frame period) in order to start the output frame
+ * a constant time after the completion of the input frame.
+ */
+
+static uint16_t const MAX_PHASE_LOCK_CORRECTION_IN_TIMER_STEPS = 2000 * 2;
 
 /************************************************************************/
 /* PRIVATE DATA														    */
@@ -91,43 +206,304 @@ static uint16_t const TIMER_RELOAD_VALUE = 0x63BF;
 
 static volatile T_RC_OUT_DATA RcOutData[NUM_RC_OUT_CHANNELS] =
 {
-{ OUTx_OFF, 1500, initOut1, setOut1, clearOut1 }, /* OUT1 */
-{ OUTx_OFF, 1500, initOut2, setOut2, clearOut2 }, /* OUT2 */
-{ OUTx_OFF, 1500, initOut3, setOut3, clearOut3 }, /* OUT3 */
-{ OUTx_OFF, 1500, initOut4, setOut4, clearOut4 }, /* OUT4 */
-{ OUTx_OFF, 1500, initOut5, setOut5, clearOut5 }, /* OUT5 */
-{ OUTx_OFF, 1500, initOut6, setOut6, clearOut6 } /* OUT6 */
+{ OUTx_OFF, 1500, 3000, 0, false, 0, 1000, 2000, OUTx_FAILSAFE_CUT, 3000, 0, 0, false, 3000, 0, 0, 0, 0,
+  initOut1, &OUT1_PORT, OUT1_bm }, /* OUT1 */
+{ OUTx_OFF, 1500, 3000, 0, false, 0, 1000, 2000, OUTx_FAILSAFE_CUT, 3000, 0, 0, false, 3000, 0, 0, 0, 0,
+  initOut2, &OUT2_PORT, OUT2_bm }, /* OUT2 */
+{ OUTx_OFF, 1500, 3000, 0, false, 0, 1000, 2000, OUTx_FAILSAFE_CUT, 3000, 0, 0, false, 3000, 0, 0, 0, 0,
+  initOut3, &OUT3_PORT, OUT3_bm }, /* OUT3 */
+{ OUTx_OFF, 1500, 3000, 0, false, 0, 1000, 2000, OUTx_FAILSAFE_CUT, 3000, 0, 0, false, 3000, 0, 0, 0, 0,
+  initOut4, &OUT4_PORT, OUT4_bm }, /* OUT4 */
+{ OUTx_OFF, 1500, 3000, 0, false, 0, 1000, 2000, OUTx_FAILSAFE_CUT, 3000, 0, 0, false, 3000, 0, 0, 0, 0,
+  initOut5, &OUT5_PORT, OUT5_bm }, /* OUT5 */
+{ OUTx_OFF, 1500, 3000, 0, false, 0, 1000, 2000, OUTx_FAILSAFE_CUT, 3000, 0, 0, false, 3000, 0, 0, 0, 0,
+  initOut6, &OUT6_PORT, OUT6_bm } /* OUT6 */
 };
 
-static volatile bool OutputCompareMatchAclearOut1 = true;
-static volatile bool OutputCompareMatchBclearOut2 = true;
-static volatile bool OutputCompareMatchCclearOut3 = true;
+/* Double buffered frame schedule - RcOutFrame[RcOutActiveFrame] is walked
+ * by the interrupt service routines while the other one is prepared. Both
+ * are only accessed from within interrupt service routines.
+ */
+
+static T_RC_OUT_FRAME RcOutFrame[2] =
+{
+{ TIMER_RELOAD_VALUE, 0, { 0, 0, 0 }, 0, { } },
+{ TIMER_RELOAD_VALUE, 0, { 0, 0, 0 }, 0, { } }
+};
+
+static volatile uint8_t RcOutActiveFrame     = 0;
+static volatile bool    RcOutNextFrameIsReady = false;
+static volatile uint8_t RcOutEventIndex       = 0;
+
+static volatile uint16_t FrameReloadValue                  = TIMER_RELOAD_VALUE;
+static volatile bool     PhaseLockIsEnabled                = false;
+static volatile uint16_t PhaseLockLeadInTimerSteps         = 0;
+static volatile uint16_t PhaseLockInputFramePeriodEstimate = TIMER_STEPS_PER_FRAME;
+
+static volatile uint16_t FramePeriodInTimerSteps           = TIMER_STEPS_PER_FRAME;
+static volatile uint8_t  FrameCount                        = 0;
 
 /************************************************************************/
 /* PRIVATE FUNCTIONS                                                    */
 /************************************************************************/
 
-/** 
- * \brief set an rc output if the state is on, clear it otherwise
+/**
+ * \brief apply reverse, subtrim and endpoints of an rc output to a pulse
+ * duration and return the result in timer steps (0.5 us)
+ */
+uint16_t transformRcOutPulseDuration(E_RC_OUT_SELECT const sel, uint16_t const pulse_duration_us)
+{
+  int16_t offset_us = (int16_t) (pulse_duration_us) - (int16_t) (CENTER_PULSE_DURATION_US);
+
+  if (RcOutData[sel].is_reversed)
+  {
+    offset_us = -offset_us;
+  }
+
+  int16_t transformed_pulse_duration_us = (int16_t) (CENTER_PULSE_DURATION_US) + offset_us + RcOutData[sel].subtrim_us;
+
+  if (transformed_pulse_duration_us < (int16_t) (RcOutData[sel].min_pulse_duration_us))
+  {
+    transformed_pulse_duration_us = RcOutData[sel].min_pulse_duration_us;
+  }
+  if (transformed_pulse_duration_us > (int16_t) (RcOutData[sel].max_pulse_duration_us))
+  {
+    transformed_pulse_duration_us = RcOutData[sel].max_pulse_duration_us;
+  }
+
+  return (uint16_t) (transformed_pulse_duration_us) * 2;
+}
+
+/**
+ * \brief recalculate the transformed pulse duration of an rc output
+ */
+void updateRcOutPulseDuration(E_RC_OUT_SELECT const sel)
+{
+  uint16_t const pulse_duration_timer_steps = transformRcOutPulseDuration(sel, RcOutData[sel].pulse_duration_us);
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    RcOutData[sel].pulse_duration_timer_steps = pulse_duration_timer_steps;
+  }
+}
+
+/**
+ * \brief convert a failsafe hold time into a number of output frames of the
+ * nominal frame period (rounded up)
  */
-void setRcOutIfStateIsOn(E_RC_OUT_SELECT const sel)
+uint16_t calcFailsafeHoldFrames(uint16_t const hold_ms, uint16_t const frame_period_timer_steps)
 {
-  if (RcOutData[sel].state == OUTx_ON)
+  uint32_t const hold_timer_steps = (uint32_t) (hold_ms) * 2000;
+
+  return (uint16_t) ((hold_timer_steps + frame_period_timer_steps - 1) / frame_period_timer_steps);
+}
+
+/**
+ * \brief approach the pulse duration of an rc output to the desired value
+ * while changing it by at most slew_rate_limit_timer_steps per frame
+ */
+uint16_t limitRcOutSlewRate(E_RC_OUT_SELECT const sel, uint16_t const pulse_duration_timer_steps)
+{
+  uint16_t const slew_rate_limit = RcOutData[sel].slew_rate_limit_timer_steps;
+  uint16_t const frame_pulse_duration = RcOutData[sel].frame_pulse_duration_timer_steps;
+
+  if (slew_rate_limit == 0)
   {
-    RcOutData[sel].setRcOut();
+    return pulse_duration_timer_steps;
+  }
+  else if (pulse_duration_timer_steps > frame_pulse_duration + slew_rate_limit)
+  {
+    return frame_pulse_duration + slew_rate_limit;
+  }
+  else if (pulse_duration_timer_steps + slew_rate_limit < frame_pulse_duration)
+  {
+    return frame_pulse_duration - slew_rate_limit;
   }
   else
   {
-    RcOutData[sel].clearRcOut();
+    return pulse_duration_timer_steps;
   }
 }
 
-/** 
- * \brief clear an rc output
+/**
+ * \brief add the offset of a bumpless transfer in progress to the pulse duration of an
+ * rc output and advance the transfer by one frame
+ */
+uint16_t transferRcOutPulseDuration(E_RC_OUT_SELECT const sel)
+{
+  uint16_t const pulse_duration_timer_steps = RcOutData[sel].pulse_duration_timer_steps;
+
+  if (RcOutData[sel].transfer_frames_remaining == 0)
+  {
+    return pulse_duration_timer_steps;
+  }
+
+  RcOutData[sel].transfer_frames_remaining--;
+
+  if (RcOutData[sel].transfer_frames_remaining == 0)
+  {
+    RcOutData[sel].transfer_offset_timer_steps = 0;
+  }
+  else
+  {
+    RcOutData[sel].transfer_offset_timer_steps -= RcOutData[sel].transfer_step_timer_steps;
+  }
+
+  return (uint16_t) ((int16_t) (pulse_duration_timer_steps) + RcOutData[sel].transfer_offset_timer_steps);
+}
+
+/**
+ * \brief evaluate state and failsafe policy of an rc output for a new
+ * output frame and determine the pulse of this frame
+ */
+void updateRcOutFrame(E_RC_OUT_SELECT const sel)
+{
+  switch (RcOutData[sel].state)
+  {
+  case OUTx_ON:
+  {
+    RcOutData[sel].frame_is_on = true;
+    RcOutData[sel].frame_pulse_duration_timer_steps = limitRcOutSlewRate(sel, transferRcOutPulseDuration(sel));
+    RcOutData[sel].failsafe_hold_frames_remaining = RcOutData[sel].failsafe_hold_frames;
+  }
+    break;
+
+  case OUTx_FAILSAFE:
+  {
+    if (RcOutData[sel].failsafe_hold_frames_remaining > 0)
+    {
+      /* Hold the pulse of the last frame */
+
+      RcOutData[sel].failsafe_hold_frames_remaining--;
+    }
+    else if (RcOutData[sel].failsafe_action == OUTx_FAILSAFE_PRESET)
+    {
+      RcOutData[sel].frame_is_on = true;
+      RcOutData[sel].frame_pulse_duration_timer_steps = RcOutData[sel].failsafe_pulse_duration_timer_steps;
+    }
+    else
+    {
+      RcOutData[sel].frame_is_on = false;
+    }
+  }
+    break;
+
+  case OUTx_OFF:
+  default:
+  {
+    RcOutData[sel].frame_is_on = false;
+    RcOutData[sel].failsafe_hold_frames_remaining = RcOutData[sel].failsafe_hold_frames;
+  }
+    break;
+  }
+}
+
+/**
+ * \brief add an rc output to the mask of its port
+ */
+void addRcOutToPortMask(T_RC_OUT_PORT_MASK & port_mask, E_RC_OUT_SELECT const sel)
+{
+  volatile uint8_t * const port = RcOutData[sel].port;
+  uint8_t const bm = RcOutData[sel].bm;
+
+  if (port == &PORTB)
+  {
+    port_mask.portb |= bm;
+  }
+  else if (port == &PORTC)
+  {
+    port_mask.portc |= bm;
+  }
+  else if (port == &PORTD)
+  {
+    port_mask.portd |= bm;
+  }
+}
+
+/**
+ * \brief evaluate all rc outputs and build the sorted edge schedule of the
+ * next frame. Coincident falling edges are merged into a single event.
  */
-void clearRcOut(E_RC_OUT_SELECT const sel)
+void prepareRcOutFrame()
 {
-  RcOutData[sel].clearRcOut();
+  T_RC_OUT_FRAME & frame = RcOutFrame[RcOutActiveFrame ^ 1];
+
+  uint16_t const start_value = FrameReloadValue;
+
+  T_RC_OUT_MASK set_mask = 0;
+  T_RC_OUT_PORT_MASK set_port_mask = { 0, 0, 0 };
+  uint8_t num_events = 0;
+
+  for (uint8_t i = 0; i < NUM_RC_OUT_CHANNELS; i++)
+  {
+    E_RC_OUT_SELECT const sel = (E_RC_OUT_SELECT) (i);
+
+    updateRcOutFrame(sel);
+
+    if (!RcOutData[sel].frame_is_on)
+    {
+      continue;
+    }
+
+    T_RC_OUT_MASK const sel_bm = (1 << sel);
+    uint16_t const compare_value = start_value + RcOutData[sel].frame_pulse_duration_timer_steps;
+
+    set_mask |= sel_bm;
+    addRcOutToPortMask(set_port_mask, sel);
+
+    /* Insert the falling edge into the sorted list of events */
+
+    uint8_t pos = 0;
+    while (pos < num_events && frame.event[pos].compare_value < compare_value)
+    {
+      pos++;
+    }
+
+    if (pos < num_events && frame.event[pos].compare_value == compare_value)
+    {
+      addRcOutToPortMask(frame.event[pos].clear_mask, sel);
+    }
+    else
+    {
+      for (uint8_t e = num_events; e > pos; e--)
+      {
+        frame.event[e] = frame.event[e - 1];
+      }
+      frame.event[pos].compare_value = compare_value;
+      frame.event[pos].clear_mask.portb = 0;
+      frame.event[pos].clear_mask.portc = 0;
+      frame.event[pos].clear_mask.portd = 0;
+      addRcOutToPortMask(frame.event[pos].clear_mask, sel);
+      num_events++;
+    }
+  }
+
+  frame.start_value = start_value;
+  frame.set_mask = set_mask;
+  frame.set_port_mask = set_port_mask;
+  frame.num_events = num_events;
+
+  RcOutNextFrameIsReady = true;
+}
+
+/**
+ * \brief set all rc outputs contained in port_mask - one store per port
+ */
+static inline void setRcOutPorts(T_RC_OUT_PORT_MASK const & port_mask)
+{
+  PORTB |= port_mask.portb;
+  PORTC |= port_mask.portc;
+  PORTD |= port_mask.portd;
+}
+
+/**
+ * \brief clear all rc outputs contained in port_mask - one store per port
+ */
+static inline void clearRcOutPorts(T_RC_OUT_PORT_MASK const & port_mask)
+{
+  PORTB &= ~port_mask.portb;
+  PORTC &= ~port_mask.portc;
+  PORTD &= ~port_mask.portd;
 }
 
 /************************************************************************/
@@ -144,7 +520,7 @@ void RcOut::begin()
   for (uint8_t i = 0; i < NUM_RC_OUT_CHANNELS; i++)
   {
     RcOutData[i].initRcOut();
-    RcOutData[i].clearRcOut();
+    *RcOutData[i].port &= ~RcOutData[i].bm;
   }
 
   /* Operate in normal timer mode, Top = 0xFFFF */
@@ -162,13 +538,20 @@ void RcOut::begin()
    * reload value.
    */
 
+#if defined(CONFIG_USE_FAST_BOOT)
+  TCNT1 = FAST_BOOT_START_VALUE;
+#else
   TCNT1 = TIMER_RELOAD_VALUE;
+#endif
 
-  /* Enable all 3 output compare interrupts as well as the timer
-   * overflow interrupt
+  /* Enable the output compare A interrupt which walks through the
+   * edges of a frame as well as the timer overflow interrupt which
+   * starts a new frame
    */
 
-  TIMSK1 = (1 << OCIE1C) | (1 << OCIE1B) | (1 << OCIE1A) | (1 << TOIE1);
+  OCR1A = PREPARE_FRAME_COMPARE_VALUE;
+
+  TIMSK1 = (1 << OCIE1A) | (1 << TOIE1);
 
   /* Set prescaler to 8 - now the timer is active */
 
@@ -176,166 +559,459 @@ void RcOut::begin()
 }
 
 /** 
- * \brief turn an output either on or off - off outputs have constant LOW level (0 V)
+ * \brief turn an output either on or off - off outputs have constant LOW level (0 V),
+ * outputs in failsafe behave according to their failsafe policy
  */
 void RcOut::setRcOutState(E_RC_OUT_SELECT const sel, E_RC_OUT_STATE const state)
 {
   RcOutData[sel].state = state;
 }
 
+/**
+ * \brief configure the behaviour of an output in state OUTx_FAILSAFE - the last pulse
+ * duration is held for hold_ms, afterwards the failsafe action is taken. The new state
+ * is evaluated at the start of each output frame.
+ */
+void RcOut::setFailsafePolicy(E_RC_OUT_SELECT const sel, uint16_t const hold_ms,
+    E_RC_OUT_FAILSAFE_ACTION const action, uint16_t const preset_pulse_duration_us)
+{
+  /* The preset is not subject to reverse and subtrim but it is clamped
+   * to the endpoints of the output
+   */
+
+  uint16_t failsafe_pulse_duration_us = preset_pulse_duration_us;
+  if (failsafe_pulse_duration_us < RcOutData[sel].min_pulse_duration_us)
+  {
+    failsafe_pulse_duration_us = RcOutData[sel].min_pulse_duration_us;
+  }
+  if (failsafe_pulse_duration_us > RcOutData[sel].max_pulse_duration_us)
+  {
+    failsafe_pulse_duration_us = RcOutData[sel].max_pulse_duration_us;
+  }
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    uint16_t const hold_frames = calcFailsafeHoldFrames(hold_ms, FramePeriodInTimerSteps);
+
+    RcOutData[sel].failsafe_action = action;
+    RcOutData[sel].failsafe_pulse_duration_timer_steps = failsafe_pulse_duration_us * 2;
+    RcOutData[sel].failsafe_hold_ms = hold_ms;
+    RcOutData[sel].failsafe_hold_frames = hold_frames;
+
+    if (RcOutData[sel].state != OUTx_FAILSAFE)
+    {
+      RcOutData[sel].failsafe_hold_frames_remaining = hold_frames;
+    }
+  }
+}
+
+/**
+ * \brief set the pulse duration which an output in state OUTx_FAILSAFE holds until its
+ * hold time has expired (default: no pulses), e.g. the pulse duration output before
+ * a reset. 0 = no pulses, has to be called before RcOut::begin.
+ */
+void RcOut::setFailsafeHoldPulseDurationUs(E_RC_OUT_SELECT const sel, uint16_t const pulse_duration_us)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    RcOutData[sel].frame_is_on = (pulse_duration_us != 0);
+    RcOutData[sel].frame_pulse_duration_timer_steps = pulse_duration_us * 2;
+  }
+}
+
 /** 
  * \brief set the pulse duration of a desired rc mixer output
  */
 void RcOut::setPwmPulseDurationUs(E_RC_OUT_SELECT const sel, uint16_t const pulse_duration_us)
 {
   RcOutData[sel].pulse_duration_us = pulse_duration_us;
-}
 
-/************************************************************************/
-/* INTERRUPT SERVICE HANDLERS                                           */
-/************************************************************************/
+  updateRcOutPulseDuration(sel);
+}
 
 /** 
- * \brief Interrupt Service Routine for Timer 1 - this function is 
- * executed every 20 ms
+ * \brief returns the pulse duration set last for a desired rc mixer output
  */
-ISR(TIMER1_OVF_vect)
+uint16_t RcOut::getPwmPulseDurationUs(E_RC_OUT_SELECT const sel)
 {
-  /* Reload the Timer/Counter register with the correct reload value */
+  return RcOutData[sel].pulse_duration_us;
+}
 
-  TCNT1 = TIMER_RELOAD_VALUE;
+/**
+ * \brief returns the pulse duration output in the current frame (after reverse, subtrim,
+ * endpoints, slew rate limit and failsafe), 0 if the output does not generate pulses
+ */
+uint16_t RcOut::getOutputPulseDurationUs(E_RC_OUT_SELECT const sel)
+{
+  uint16_t pulse_duration_timer_steps = 0;
 
-  /* We have 6 PWM outputs but only 2 output compare registers -
-   * how do we generate then 6 PWM signals? Solution is quite
-   * simple:
-   * - OUT1-3 signals are set in the timer 0 overflow isr every 20 ms
-   * - Output compare registers A-C are preloaded with a value which represents
-   *   the pwm pulse duration
-   * - OUT1-3 signals are cleared in the output compare match
-   *   interrupt service routine
-   * - In the output compare match interrupt service routines set the
-   *   output compare match registers to trigger pulse_duration_us
-   *   of the individual output channel OUT4 to OUT6 before the
-   *   timer overflow interrupt service occurs.
-   * - In the second iteration of output compare match interrupts
-   *   set the Outputs OUT4 to OUT6. Those are cleared upon occurence
-   *   of the timer overflow interrupt.
-   * - go back to first entry in this list ;)
-   */
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    if (RcOutData[sel].frame_is_on)
+    {
+      pulse_duration_timer_steps = RcOutData[sel].frame_pulse_duration_timer_steps;
+    }
+  }
+
+  return pulse_duration_timer_steps / 2;
+}
 
-  /* Set OUT1 to OUT3 */
+/**
+ * \brief mirror the pulse duration of an output around the center value (1500 us)
+ */
+void RcOut::setReverse(E_RC_OUT_SELECT const sel, bool const is_reversed)
+{
+  RcOutData[sel].is_reversed = is_reversed;
 
-  setRcOutIfStateIsOn(OUT1);
-  setRcOutIfStateIsOn(OUT2);
-  setRcOutIfStateIsOn(OUT3);
+  updateRcOutPulseDuration(sel);
+}
 
-  /* Clear OUT4 to OUT6 */
+/**
+ * \brief add a constant offset to the pulse duration of an output
+ */
+void RcOut::setSubtrim(E_RC_OUT_SELECT const sel, int16_t const subtrim_us)
+{
+  RcOutData[sel].subtrim_us = subtrim_us;
 
-  clearRcOut(OUT4);
-  clearRcOut(OUT5);
-  clearRcOut(OUT6);
+  updateRcOutPulseDuration(sel);
+}
 
-  /* Setup output compare registers to be triggered when outputs
-   * OUT1 to OUT3 need to be turned off. Attention: We need to
-   * multiply the value provided in the variable pulse_duration_us
-   * by a factor of 2 since a single timer step is only 0.5 us
-   * long.
+/**
+ * \brief limit the pulse duration of an output to [min_pulse_duration_us, max_pulse_duration_us],
+ * both are clamped to [500 us, 2500 us] and swapped if min_pulse_duration_us > max_pulse_duration_us
+ */
+void RcOut::setEndpoints(E_RC_OUT_SELECT const sel, uint16_t const min_pulse_duration_us, uint16_t const max_pulse_duration_us)
+{
+  /* All pulses need to be finished before the next frame is prepared, the
+   * shortest pulse has to end well after the frame start so that its
+   * compare match is not missed
    */
 
-  OCR1A = TIMER_RELOAD_VALUE + RcOutData[OUT1].pulse_duration_us * 2;
-  OCR1B = TIMER_RELOAD_VALUE + RcOutData[OUT2].pulse_duration_us * 2;
-  OCR1C = TIMER_RELOAD_VALUE + RcOutData[OUT3].pulse_duration_us * 2;
+  uint16_t lower_us = (min_pulse_duration_us < max_pulse_duration_us) ? min_pulse_duration_us : max_pulse_duration_us;
+  uint16_t upper_us = (min_pulse_duration_us < max_pulse_duration_us) ? max_pulse_duration_us : min_pulse_duration_us;
 
-  /* Setup the status flags so we know that we need to clear
-   * OUT1 to OUT3 in the output compare match interrupts
-   */
+  lower_us = (lower_us < MIN_ENDPOINT_US) ? MIN_ENDPOINT_US : ((lower_us > MAX_ENDPOINT_US) ? MAX_ENDPOINT_US : lower_us);
+  upper_us = (upper_us < MIN_ENDPOINT_US) ? MIN_ENDPOINT_US : ((upper_us > MAX_ENDPOINT_US) ? MAX_ENDPOINT_US : upper_us);
 
-  OutputCompareMatchAclearOut1 = true;
-  OutputCompareMatchBclearOut2 = true;
-  OutputCompareMatchCclearOut3 = true;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    RcOutData[sel].min_pulse_duration_us = lower_us;
+    RcOutData[sel].max_pulse_duration_us = upper_us;
+  }
+
+  updateRcOutPulseDuration(sel);
 }
 
-/** 
- * \brief Interrupt service routine for compare match a interrupt
+/**
+ * \brief limit the change of the pulse duration of an output to max_change_us per
+ * output frame, a value of 0 disables the limiter (full responsiveness)
  */
-ISR(TIMER1_COMPA_vect)
+void RcOut::setSlewRateLimit(E_RC_OUT_SELECT const sel, uint16_t const max_change_us)
 {
-  if (OutputCompareMatchAclearOut1)
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
   {
-    /* Clear OUT1 */
+    RcOutData[sel].slew_rate_limit_timer_steps = max_change_us * 2;
+  }
+}
 
-    clearRcOut(OUT1);
+/**
+ * \brief move all outputs which are turned on from the pulse duration currently output
+ * to the pulse duration set last within num_frames output frames instead of jumping.
+ * Has to be called after the new pulse durations have been set.
+ */
+void RcOut::startBumplessTransfer(uint8_t const num_frames)
+{
+  if (num_frames == 0)
+  {
+    return;
+  }
 
-    OutputCompareMatchAclearOut1 = false;
+  for (uint8_t sel = 0; sel < NUM_RC_OUT_CHANNELS; sel++)
+  {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      if (RcOutData[sel].state == OUTx_ON && RcOutData[sel].frame_is_on)
+      {
+        int16_t const offset = (int16_t) (RcOutData[sel].frame_pulse_duration_timer_steps)
+            - (int16_t) (RcOutData[sel].pulse_duration_timer_steps);
+
+        RcOutData[sel].transfer_offset_timer_steps = offset;
+        RcOutData[sel].transfer_step_timer_steps = offset / num_frames;
+        RcOutData[sel].transfer_frames_remaining = num_frames;
+      }
+    }
+  }
+}
 
-    /* Setup output compare register to be triggered pulse_duration_us
-     * before the timer overflow interrupt. Attention: We also need to
-     * multiply the value provided in pulse_duration_us by 2 to take
-     * account for a timer step duration of 0.5 us.
-     */
+/**
+ * \brief phase-lock the output frame to the input frame - the output pulses
+ * start lead_us after the completion of an input frame. Since the frame is
+ * prepared 256 us before it starts the lead has to cover the duration of
+ * the mixing function plus 256 us.
+ */
+void RcOut::enablePhaseLock(uint16_t const lead_us)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    PhaseLockLeadInTimerSteps = lead_us * 2;
+    PhaseLockInputFramePeriodEstimate = FramePeriodInTimerSteps;
+    PhaseLockIsEnabled = true;
+  }
+}
 
-    OCR1A = 0xFFFF - RcOutData[OUT4].pulse_duration_us * 2;
+/**
+ * \brief let the output frame run freely with its nominal period (see setFramePeriodUs)
+ */
+void RcOut::disablePhaseLock()
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    PhaseLockIsEnabled = false;
+    FrameReloadValue = (uint16_t) (0xFFFF - FramePeriodInTimerSteps);
   }
-  else
+}
+
+/**
+ * \brief set the nominal period of the output frame (5000 ... 30000 us, default 20000 us),
+ * the new period is used from the next frame on. The failsafe hold time of all outputs
+ * is converted to frames of the new period.
+ */
+void RcOut::setFramePeriodUs(uint16_t const frame_period_us)
+{
+  uint16_t limited_frame_period_us = frame_period_us;
+  if (limited_frame_period_us < MIN_FRAME_PERIOD_US)
+  {
+    limited_frame_period_us = MIN_FRAME_PERIOD_US;
+  }
+  if (limited_frame_period_us > MAX_FRAME_PERIOD_US)
   {
-    /* Set OUT4 */
+    limited_frame_period_us = MAX_FRAME_PERIOD_US;
+  }
 
-    setRcOutIfStateIsOn(OUT4);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    FramePeriodInTimerSteps = limited_frame_period_us * 2;
+
+    if (PhaseLockIsEnabled)
+    {
+      PhaseLockInputFramePeriodEstimate = FramePeriodInTimerSteps;
+    }
+    else
+    {
+      FrameReloadValue = (uint16_t) (0xFFFF - FramePeriodInTimerSteps);
+    }
+
+    for (uint8_t sel = 0; sel < NUM_RC_OUT_CHANNELS; sel++)
+    {
+      uint16_t const hold_frames = calcFailsafeHoldFrames(RcOutData[sel].failsafe_hold_ms, FramePeriodInTimerSteps);
+
+      RcOutData[sel].failsafe_hold_frames = hold_frames;
+
+      if (RcOutData[sel].state != OUTx_FAILSAFE)
+      {
+        RcOutData[sel].failsafe_hold_frames_remaining = hold_frames;
+      }
+    }
   }
 }
 
-/* Output compare match interrupt service routines B and C follow
- * the pattern established with A. Therefor I won't them document
- * them so carefully as A. You should by now have an idea how this
- * works ;)
+/**
+ * \brief returns the number of output frames started so far (wraps around), can be used
+ * to detect a frame boundary
  */
+uint8_t RcOut::getFrameCount()
+{
+  return FrameCount;
+}
 
-/** 
- * \brief Interrupt service routine for compare match b interrupt
+/**
+ * \brief has to be called upon completion of an input frame (see RcIn::setFrameCompleteCallback)
  */
-ISR(TIMER1_COMPB_vect)
+void RcOut::onInputFrameComplete(uint16_t const frame_period_us)
 {
-  if (OutputCompareMatchBclearOut2)
+  if (!PhaseLockIsEnabled)
   {
-    /* Clear OUT2 */
-
-    clearRcOut(OUT2);
+    return;
+  }
 
-    OutputCompareMatchBclearOut2 = false;
+  /* Track the period of the input frame so that the output frame period
+   * follows it once we are locked. Attention: One timer step is 0.5 us.
+   */
 
-    /* Setup output compare register */
+  int32_t period_estimate = PhaseLockInputFramePeriodEstimate;
 
-    OCR1B = 0xFFFF - RcOutData[OUT5].pulse_duration_us * 2;
+  if (frame_period_us != 0)
+  {
+    int32_t const frame_period_in_timer_steps = (int32_t) (frame_period_us) * 2;
+    period_estimate += (frame_period_in_timer_steps - period_estimate) / 8;
+    PhaseLockInputFramePeriodEstimate = (uint16_t) (period_estimate);
   }
-  else
+
+  /* All outputs start their pulses at the timer overflow. Therefore
+   * the timer overflow should occur lead after the completion of the
+   * input frame.
+   */
+
+  int32_t const timer_steps_until_frame_start = 0xFFFF - TCNT1;
+  int32_t const desired_timer_steps_until_frame_start = PhaseLockLeadInTimerSteps;
+
+  int32_t phase_error = timer_steps_until_frame_start - desired_timer_steps_until_frame_start;
+  if (phase_error > period_estimate / 2)
   {
-    /* Set OUT5 */
+    phase_error -= period_estimate;
+  }
+
+  /* Correct half of the phase error within the next frame */
+
+  int32_t frame_length = period_estimate - phase_error / 2;
+
+  int32_t const nominal_frame_length = FramePeriodInTimerSteps;
 
-    setRcOutIfStateIsOn(OUT5);
+  if (frame_length < nominal_frame_length - MAX_PHASE_LOCK_CORRECTION_IN_TIMER_STEPS)
+  {
+    frame_length = nominal_frame_length - MAX_PHASE_LOCK_CORRECTION_IN_TIMER_STEPS;
+  }
+  if (frame_length > nominal_frame_length + MAX_PHASE_LOCK_CORRECTION_IN_TIMER_STEPS)
+  {
+    frame_length = nominal_frame_length + MAX_PHASE_LOCK_CORRECTION_IN_TIMER_STEPS;
   }
+
+  FrameReloadValue = (uint16_t) (0xFFFF - frame_length);
 }
 
+/************************************************************************/
+/* INTERRUPT SERVICE HANDLERS                                           */
+/************************************************************************/
+
 /** 
- * \brief Interrupt service routine for compare match c interrupt
+ * \brief Interrupt Service Routine for Timer 1 - this function is 
+ * executed every 20 ms
  */
-ISR(TIMER1_COMPC_vect)
+ISR(TIMER1_OVF_vect)
 {
-  if (OutputCompareMatchCclearOut3)
+#if defined(CONFIG_USE_LATENCY_INSTRUMENTATION)
+  /* The timer counts from 0 after the overflow */
+  uint16_t const entry_delay_timer_steps = TCNT1;
+#endif
+
+  /* Switch to the prepared frame. If the preparation did not finish in
+   * time the last frame is repeated.
+   */
+
+  if (RcOutNextFrameIsReady)
   {
-    /* Clear OUT3 */
+    RcOutActiveFrame ^= 1;
+    RcOutNextFrameIsReady = false;
+  }
 
-    clearRcOut(OUT3);
+  T_RC_OUT_FRAME const & frame = RcOutFrame[RcOutActiveFrame];
 
-    OutputCompareMatchCclearOut3 = false;
+  /* Reload the Timer/Counter register with the reload value of this
+   * frame (which is modified by the phase-lock in order to adjust the
+   * frame period).
+   */
+
+  TCNT1 = frame.start_value;
+
+  FrameCount++;
+
+  /* We have 6 PWM outputs but only one output compare register is
+   * used to generate them:
+   * - All outputs which are on are set at the start of the frame,
+   *   one store per output port
+   * - The falling edges of all outputs have been sorted by time when
+   *   the frame was prepared, outputs with the same pulse duration
+   *   share a single event
+   * - Output compare register A is loaded with the time of the next
+   *   event, the compare match interrupt clears the outputs of that
+   *   event and loads the time of the following event
+   * - After the last event the compare match interrupt is triggered
+   *   once more shortly before the end of the frame in order to
+   *   prepare the next frame
+   */
 
-    /* Setup output compare register */
+  setRcOutPorts(frame.set_port_mask);
 
-    OCR1C = 0xFFFF - RcOutData[OUT6].pulse_duration_us * 2;
+  RcOutEventIndex = 0;
+  OCR1A = (frame.num_events > 0) ? frame.event[0].compare_value : PREPARE_FRAME_COMPARE_VALUE;
+
+#if defined(CONFIG_USE_LATENCY_INSTRUMENTATION)
+  Latency::markOutputEdges(frame.set_mask);
+  Latency::markOutputIsrEntry(entry_delay_timer_steps);
+#endif
+
+#if defined(CONFIG_USE_FAST_BOOT)
+  if (frame.set_mask != 0)
+  {
+    Boot::markFirstPulse();
   }
-  else
+#endif
+}
+
+/** 
+ * \brief Interrupt service routine for compare match a interrupt
+ */
+ISR(TIMER1_COMPA_vect)
+{
+#if defined(CONFIG_USE_LATENCY_INSTRUMENTATION)
+  uint16_t const entry_timer_value = TCNT1;
+#endif
+
+  T_RC_OUT_FRAME const & frame = RcOutFrame[RcOutActiveFrame];
+
+  uint8_t event_index = RcOutEventIndex;
+
+  if (event_index >= frame.num_events)
   {
-    /* Set OUT6 */
+    /* All pulses of this frame are finished - prepare the next frame
+     * with interrupts enabled so that the measurement of the input
+     * pulses is not delayed.
+     */
+
+    sei();
 
-    setRcOutIfStateIsOn(OUT6);
+    prepareRcOutFrame();
+
+    return;
   }
+
+#if defined(CONFIG_USE_LATENCY_INSTRUMENTATION)
+  uint16_t const entry_delay_timer_steps = entry_timer_value - frame.event[event_index].compare_value;
+#endif
+
+  for (;;)
+  {
+    clearRcOutPorts(frame.event[event_index].clear_mask);
+
+    event_index++;
+
+    if (event_index >= frame.num_events)
+    {
+      OCR1A = PREPARE_FRAME_COMPARE_VALUE;
+      break;
+    }
+
+    /* Edges which are too close for another interrupt are handled
+     * right here by waiting for them.
+     */
+
+    uint16_t const next_compare_value = frame.event[event_index].compare_value;
+
+    if ((int16_t) (next_compare_value - TCNT1) > (int16_t) (MIN_COMPARE_DISTANCE_IN_TIMER_STEPS))
+    {
+      OCR1A = next_compare_value;
+      break;
+    }
+
+    while ((int16_t) (next_compare_value - TCNT1) > 0)
+    {
+    }
+  }
+
+  RcOutEventIndex = event_index;
+
+#if defined(CONFIG_USE_LATENCY_INSTRUMENTATION)
+  /* Recorded after the edges have been output in order not to delay them */
+  Latency::markOutputIsrEntry(entry_delay_timer_steps);
+#endif
 }
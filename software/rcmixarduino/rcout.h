@@ -30,6 +30,7 @@
 /************************************************************************/
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /************************************************************************/
 /* PUBLIC TYPES                                                         */
@@ -42,9 +43,19 @@ typedef enum
 
 typedef enum
 {
-  OUTx_ON, OUTx_OFF
+  OUTx_ON, OUTx_OFF, OUTx_FAILSAFE
 } E_RC_OUT_STATE;
 
+/* Action taken by an output in state OUTx_FAILSAFE after the last pulse
+ * duration has been held for the configured time
+ */
+
+typedef enum
+{
+  OUTx_FAILSAFE_CUT,   /* No more pulses, constant LOW level (0 V) */
+  OUTx_FAILSAFE_PRESET /* Pulses with a preset pulse duration */
+} E_RC_OUT_FAILSAFE_ACTION;
+
 /************************************************************************/
 /* PUBLIC PROTOTYPES                                                    */
 /************************************************************************/
@@ -60,15 +71,102 @@ public:
   static void begin();
 
   /**
-   * \brief turn an output either on or off - off outputs have constant LOW level (0 V)
+   * \brief turn an output either on or off - off outputs have constant LOW level (0 V),
+   * outputs in failsafe behave according to their failsafe policy
    */
   static void setRcOutState(E_RC_OUT_SELECT const sel, E_RC_OUT_STATE const state);
 
+  /**
+   * \brief configure the behaviour of an output in state OUTx_FAILSAFE - the last pulse
+   * duration is held for hold_ms, afterwards the failsafe action is taken. The new state
+   * is evaluated at the start of each output frame.
+   */
+  static void setFailsafePolicy(E_RC_OUT_SELECT const sel, uint16_t const hold_ms,
+      E_RC_OUT_FAILSAFE_ACTION const action, uint16_t const preset_pulse_duration_us);
+
+  /**
+   * \brief set the pulse duration which an output in state OUTx_FAILSAFE holds until its
+   * hold time has expired (default: no pulses), e.g. the pulse duration output before
+   * a reset. 0 = no pulses, has to be called before RcOut::begin.
+   */
+  static void setFailsafeHoldPulseDurationUs(E_RC_OUT_SELECT const sel, uint16_t const pulse_duration_us);
+
   /**
    * \brief set the pulse duration of a desired rc mixer output
    */
   static void setPwmPulseDurationUs(E_RC_OUT_SELECT const sel, uint16_t const pulse_duration_us);
 
+  /**
+   * \brief returns the pulse duration set last for a desired rc mixer output
+   */
+  static uint16_t getPwmPulseDurationUs(E_RC_OUT_SELECT const sel);
+
+  /**
+   * \brief returns the pulse duration output in the current frame (after reverse, subtrim,
+   * endpoints, slew rate limit and failsafe), 0 if the output does not generate pulses
+   */
+  static uint16_t getOutputPulseDurationUs(E_RC_OUT_SELECT const sel);
+
+  /**
+   * \brief mirror the pulse duration of an output around the center value (1500 us)
+   */
+  static void setReverse(E_RC_OUT_SELECT const sel, bool const is_reversed);
+
+  /**
+   * \brief add a constant offset to the pulse duration of an output
+   */
+  static void setSubtrim(E_RC_OUT_SELECT const sel, int16_t const subtrim_us);
+
+  /**
+   * \brief limit the pulse duration of an output to [min_pulse_duration_us, max_pulse_duration_us],
+   * both are clamped to [500 us, 2500 us] and swapped if min_pulse_duration_us > max_pulse_duration_us
+   */
+  static void setEndpoints(E_RC_OUT_SELECT const sel, uint16_t const min_pulse_duration_us, uint16_t const max_pulse_duration_us);
+
+  /**
+   * \brief limit the change of the pulse duration of an output to max_change_us per
+   * output frame, a value of 0 disables the limiter (full responsiveness)
+   */
+  static void setSlewRateLimit(E_RC_OUT_SELECT const sel, uint16_t const max_change_us);
+
+  /**
+   * \brief move all outputs which are turned on from the pulse duration currently output
+   * to the pulse duration set last within num_frames output frames instead of jumping.
+   * Has to be called after the new pulse durations have been set.
+   */
+  static void startBumplessTransfer(uint8_t const num_frames);
+
+  /**
+   * \brief phase-lock the output frame to the input frame - the output pulses
+   * start lead_us after the completion of an input frame. Since the frame is
+   * prepared 256 us before it starts the lead has to cover the duration of
+   * the mixing function plus 256 us.
+   */
+  static void enablePhaseLock(uint16_t const lead_us);
+
+  /**
+   * \brief let the output frame run freely with its nominal period (see setFramePeriodUs)
+   */
+  static void disablePhaseLock();
+
+  /**
+   * \brief set the nominal period of the output frame (5000 ... 30000 us, default 20000 us),
+   * the new period is used from the next frame on. The failsafe hold time of all outputs
+   * is converted to frames of the new period.
+   */
+  static void setFramePeriodUs(uint16_t const frame_period_us);
+
+  /**
+   * \brief returns the number of output frames started so far (wraps around), can be used
+   * to detect a frame boundary
+   */
+  static uint8_t getFrameCount();
+
+  /**
+   * \brief has to be called upon completion of an input frame (see RcIn::setFrameCompleteCallback)
+   */
+  static void onInputFrameComplete(uint16_t const frame_period_us);
+
 private:
 
   /**
@@ -0,0 +1,355 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "scheduler.h"
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include <avr/sleep.h>
+
+#include <util/atomic.h>
+
+#ifdef CONFIG_USE_SCHEDULER
+
+/************************************************************************/
+/* PRIVATE TYPEDEFS                                                     */
+/************************************************************************/
+
+typedef struct
+{
+  schedulerTaskFunc      func;
+  uint16_t               period_ms;
+  uint16_t               next_release_tick;
+  T_SCHEDULER_TASK_STATS stats;
+} T_SCHEDULER_TASK;
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+static uint8_t const MAX_NUM_TASKS = 8;
+
+/* Timer 3 is running freely with a step of 4 us (see RcIn::begin), output
+ * compare A is advanced by 250 timer steps on every match which results
+ * in a tick of 1 ms without disturbing the input measurement
+ */
+
+static uint16_t const TIMERSTEP_DURATION_US = 4;
+static uint16_t const TIMER_STEPS_PER_TICK  = 1000 / TIMERSTEP_DURATION_US;
+
+/* The active duty cycle is calculated over this window */
+
+static uint16_t const DUTY_CYCLE_WINDOW_MS  = 1000;
+
+/************************************************************************/
+/* PRIVATE DATA                                                         */
+/************************************************************************/
+
+static T_SCHEDULER_TASK SchedulerTask[MAX_NUM_TASKS];
+static uint8_t          SchedulerNumTasks = 0;
+
+static volatile uint16_t SchedulerTick = 0;
+
+#if defined(CONFIG_USE_IDLE_SLEEP)
+static volatile bool     SchedulerEventIsPending = true;
+static uint32_t          SchedulerSleepTimerSteps = 0;
+static uint16_t          SchedulerDutyCycleWindowStartTick = 0;
+static uint16_t          SchedulerActiveDutyCyclePermille = 1000;
+#endif
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+/**
+ * \brief execute a task and account for its execution time
+ */
+void executeTask(T_SCHEDULER_TASK & task)
+{
+  uint16_t const start = TCNT3;
+
+  task.func();
+
+  uint16_t const exec_time_timer_steps = TCNT3 - start;
+  uint16_t const exec_time_us = (exec_time_timer_steps > 0xFFFF / TIMERSTEP_DURATION_US) ?
+      0xFFFF : (exec_time_timer_steps * TIMERSTEP_DURATION_US);
+
+  task.stats.num_runs++;
+  task.stats.last_exec_time_us = exec_time_us;
+  if (exec_time_us > task.stats.max_exec_time_us)
+  {
+    task.stats.max_exec_time_us = exec_time_us;
+  }
+
+  /* A periodic task which runs longer than its period overruns */
+
+  if (task.period_ms != SCHEDULER_EVERY_PASS
+      && (uint32_t) (exec_time_timer_steps) >= (uint32_t) (task.period_ms) * TIMER_STEPS_PER_TICK)
+  {
+    task.stats.num_overruns++;
+  }
+}
+
+#if defined(CONFIG_USE_IDLE_SLEEP)
+
+/**
+ * \brief returns true if a periodic task is due (has to be called with interrupts disabled)
+ */
+bool isPeriodicTaskDue()
+{
+  for (uint8_t i = 0; i < SchedulerNumTasks; i++)
+  {
+    if (SchedulerTask[i].period_ms != SCHEDULER_EVERY_PASS
+        && (int16_t) (SchedulerTick - SchedulerTask[i].next_release_tick) >= 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * \brief put the cpu into idle sleep until an event is pending or a periodic task is due
+ */
+void idle()
+{
+  set_sleep_mode(SLEEP_MODE_IDLE);
+
+  cli();
+
+  while (!SchedulerEventIsPending && !isPeriodicTaskDue())
+  {
+    uint16_t const start = TCNT3;
+
+    /* The instruction following sei is always executed before a pending
+     * interrupt is serviced - an interrupt occurring after the check can
+     * therefore not be missed, it wakes the cpu up immediately
+     */
+
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+    cli();
+
+    /* The isr which woke the cpu is accounted as sleep time */
+
+    SchedulerSleepTimerSteps += (uint16_t) (TCNT3 - start);
+  }
+
+  sei();
+
+  /* Calculate the active duty cycle at the end of every window */
+
+  uint16_t const now = Scheduler::getTick();
+  uint16_t const window_ms = now - SchedulerDutyCycleWindowStartTick;
+
+  if (window_ms >= DUTY_CYCLE_WINDOW_MS)
+  {
+    uint32_t const sleep_us = SchedulerSleepTimerSteps * TIMERSTEP_DURATION_US;
+    uint32_t const sleep_permille = sleep_us / window_ms;
+
+    SchedulerActiveDutyCyclePermille = (sleep_permille >= 1000) ? 0 : (1000 - sleep_permille);
+    SchedulerSleepTimerSteps = 0;
+    SchedulerDutyCycleWindowStartTick = now;
+  }
+}
+
+#endif
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+/**
+ * \brief initialize the scheduler and start the 1 ms tick (requires RcIn::begin to be called before)
+ */
+void Scheduler::begin()
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    OCR3A = TCNT3 + TIMER_STEPS_PER_TICK;
+
+    /* Clear a pending compare match and enable the compare match
+     * interrupt in addition to the overflow interrupt used by RcIn
+     */
+
+    TIFR3 = (1 << OCF3A);
+    TIMSK3 |= (1 << OCIE3A);
+  }
+}
+
+/**
+ * \brief register a task which is executed every period_ms, tasks are prioritized in
+ * the order of registration. Returns false if no more tasks can be registered.
+ */
+bool Scheduler::addTask(schedulerTaskFunc const func, uint16_t const period_ms)
+{
+  if (SchedulerNumTasks >= MAX_NUM_TASKS)
+  {
+    return false;
+  }
+
+  T_SCHEDULER_TASK & task = SchedulerTask[SchedulerNumTasks];
+
+  task.func = func;
+  task.period_ms = period_ms;
+  task.next_release_tick = getTick() + period_ms;
+  task.stats.num_runs = 0;
+  task.stats.num_overruns = 0;
+  task.stats.last_exec_time_us = 0;
+  task.stats.max_exec_time_us = 0;
+
+  SchedulerNumTasks++;
+
+  return true;
+}
+
+/**
+ * \brief executes all tasks registered with SCHEDULER_EVERY_PASS and at most one
+ * of the due periodic tasks (the one with the highest priority) - has to be
+ * called from the main loop
+ */
+void Scheduler::run()
+{
+  uint16_t const now = getTick();
+  bool is_periodic_task_executed = false;
+
+#if defined(CONFIG_USE_IDLE_SLEEP)
+  /* Events signalled from now on are handled in the next pass */
+  SchedulerEventIsPending = false;
+#endif
+
+  for (uint8_t i = 0; i < SchedulerNumTasks; i++)
+  {
+    T_SCHEDULER_TASK & task = SchedulerTask[i];
+
+    if (task.period_ms == SCHEDULER_EVERY_PASS)
+    {
+      executeTask(task);
+    }
+    else if (!is_periodic_task_executed && (int16_t) (now - task.next_release_tick) >= 0)
+    {
+      /* A task which is released later than its next release has missed
+       * at least one period - count it as overrun and resynchronize
+       */
+
+      if ((int16_t) (now - task.next_release_tick) >= (int16_t) (task.period_ms))
+      {
+        task.stats.num_overruns++;
+        task.next_release_tick = now + task.period_ms;
+      }
+      else
+      {
+        task.next_release_tick += task.period_ms;
+      }
+
+      executeTask(task);
+
+      /* Only one periodic task per pass keeps the latency of the tasks
+       * executed in every pass (mixing) bounded
+       */
+
+      is_periodic_task_executed = true;
+    }
+  }
+
+#if defined(CONFIG_USE_IDLE_SLEEP)
+  idle();
+#endif
+}
+
+/**
+ * \brief returns the number of ms since Scheduler::begin (wraps around after 65.5 s)
+ */
+uint16_t Scheduler::getTick()
+{
+  uint16_t tick = 0;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    tick = SchedulerTick;
+  }
+
+  return tick;
+}
+
+/**
+ * \brief returns the execution statistics of the task with the given index
+ * (= order of registration), false if there is no such task
+ */
+bool Scheduler::getTaskStats(uint8_t const index, T_SCHEDULER_TASK_STATS * stats)
+{
+  if (index >= SchedulerNumTasks)
+  {
+    return false;
+  }
+
+  *stats = SchedulerTask[index].stats;
+
+  return true;
+}
+
+#if defined(CONFIG_USE_IDLE_SLEEP)
+
+/**
+ * \brief signal an event (e.g. a new input pulse) which requires the tasks
+ * executed in every pass to run - may be called from an isr
+ */
+void Scheduler::signalEvent()
+{
+  SchedulerEventIsPending = true;
+}
+
+/**
+ * \brief returns the share of time the cpu was not sleeping during the
+ * last second in 1/1000
+ */
+uint16_t Scheduler::getActiveDutyCyclePermille()
+{
+  return SchedulerActiveDutyCyclePermille;
+}
+
+#endif
+
+/************************************************************************/
+/* INTERRUPT SERVICE HANDLERS                                           */
+/************************************************************************/
+
+/**
+ * \brief timer 3 compare match a interrupt service routine - 1 ms tick
+ */
+ISR(TIMER3_COMPA_vect)
+{
+  OCR3A += TIMER_STEPS_PER_TICK;
+  SchedulerTick++;
+}
+
+#endif
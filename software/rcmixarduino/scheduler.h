@@ -0,0 +1,120 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+#ifdef CONFIG_USE_SCHEDULER
+
+/************************************************************************/
+/* PUBLIC TYPES                                                         */
+/************************************************************************/
+
+typedef void (*schedulerTaskFunc)(void);
+
+/* A task with this period is executed in every pass of the scheduler */
+
+static uint16_t const SCHEDULER_EVERY_PASS = 0;
+
+typedef struct
+{
+  uint16_t num_runs;            /* Number of executions */
+  uint16_t num_overruns;        /* Number of missed releases or executions longer than the period */
+  uint16_t last_exec_time_us;   /* Execution time of the last execution */
+  uint16_t max_exec_time_us;    /* Longest execution time observed */
+} T_SCHEDULER_TASK_STATS;
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+class Scheduler
+{
+
+public:
+
+  /**
+   * \brief initialize the scheduler and start the 1 ms tick (requires RcIn::begin to be called before)
+   */
+  static void begin();
+
+  /**
+   * \brief register a task which is executed every period_ms, tasks are prioritized in
+   * the order of registration. Returns false if no more tasks can be registered.
+   */
+  static bool addTask(schedulerTaskFunc const func, uint16_t const period_ms);
+
+  /**
+   * \brief executes all tasks registered with SCHEDULER_EVERY_PASS and at most one
+   * of the due periodic tasks (the one with the highest priority) - has to be
+   * called from the main loop. With CONFIG_USE_IDLE_SLEEP the cpu is put to
+   * sleep afterwards until an event is signalled or a periodic task is due.
+   */
+  static void run();
+
+  /**
+   * \brief returns the number of ms since Scheduler::begin (wraps around after 65.5 s)
+   */
+  static uint16_t getTick();
+
+  /**
+   * \brief returns the execution statistics of the task with the given index
+   * (= order of registration), false if there is no such task
+   */
+  static bool getTaskStats(uint8_t const index, T_SCHEDULER_TASK_STATS * stats);
+
+#if defined(CONFIG_USE_IDLE_SLEEP)
+  /**
+   * \brief signal an event (e.g. a new input pulse) which requires the tasks
+   * executed in every pass to run - may be called from an isr
+   */
+  static void signalEvent();
+
+  /**
+   * \brief returns the share of time the cpu was not sleeping during the
+   * last second in 1/1000
+   */
+  static uint16_t getActiveDutyCyclePermille();
+#endif
+
+private:
+
+  /**
+   * \brief no public constructing
+   */
+  Scheduler() { }
+};
+
+#endif
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,264 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "telemetry.h"
+
+#ifdef CONFIG_USE_TELEMETRY
+
+#include <Arduino.h>
+
+#include "cobs.h"
+#include "rcin.h"
+#include "rcout.h"
+#include "scheduler.h"
+
+/************************************************************************/
+/* PRIVATE TYPEDEFS                                                     */
+/************************************************************************/
+
+typedef struct
+{
+  uint8_t  seq;
+  uint8_t  flags;
+  uint16_t tick_ms;
+  uint16_t in_us[4];
+  uint16_t out_us[6];
+  uint16_t mix_exec_time_us;
+  uint16_t active_duty_permille;
+} T_TELEMETRY_RECORD;
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+static uint8_t const NUM_RC_IN_CHANNELS = 4;
+static uint8_t const NUM_RC_OUT_CHANNELS = 6;
+
+/* The mix task is registered first (see rcmixarduino.ino) */
+
+static uint8_t const MIX_TASK_INDEX = 0;
+
+static uint8_t const FLAG_IS_MIXING = (1 << 7);
+
+/* Records which can be buffered until they are sent (power of 2) */
+
+static uint8_t const RING_BUFFER_SIZE = 4;
+
+/* type + seq + flags + tick + 4 inputs + 6 outputs + exec time + duty + checksum */
+
+static uint8_t const PAYLOAD_SIZE = 1 + 1 + 1 + 2 + 4 * 2 + 6 * 2 + 2 + 2 + 1;
+
+/* COBS adds one byte per 254 bytes plus the delimiter */
+
+static uint8_t const FRAME_SIZE = PAYLOAD_SIZE + 2;
+
+/************************************************************************/
+/* PRIVATE DATA                                                         */
+/************************************************************************/
+
+/* Written from the mix path (record) and read from a task (transmit),
+ * both are executed from the main loop - no locking is necessary
+ */
+
+static T_TELEMETRY_RECORD TelemetryRing[RING_BUFFER_SIZE];
+static uint8_t            TelemetryRingHead = 0;
+static uint8_t            TelemetryRingTail = 0;
+
+static uint8_t            TelemetryLastFrameCount = 0;
+
+static uint8_t            TelemetryFrame[FRAME_SIZE];
+static uint8_t            TelemetryFrameSize = 0;
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+/**
+ * \brief append a 16 bit value in little endian byte order
+ */
+uint8_t * putTelemetryWord(uint8_t * ptr, uint16_t const value)
+{
+  *ptr++ = (uint8_t) (value);
+  *ptr++ = (uint8_t) (value >> 8);
+  return ptr;
+}
+
+/**
+ * \brief serialize a record and encode it into TelemetryFrame
+ */
+void prepareTelemetryFrame(T_TELEMETRY_RECORD const & record)
+{
+  uint8_t payload[PAYLOAD_SIZE];
+  uint8_t * ptr = payload;
+
+  *ptr++ = TELEMETRY_RECORD_TYPE_FRAME;
+  *ptr++ = record.seq;
+  *ptr++ = record.flags;
+  ptr = putTelemetryWord(ptr, record.tick_ms);
+  for (uint8_t i = 0; i < NUM_RC_IN_CHANNELS; i++)
+  {
+    ptr = putTelemetryWord(ptr, record.in_us[i]);
+  }
+  for (uint8_t i = 0; i < NUM_RC_OUT_CHANNELS; i++)
+  {
+    ptr = putTelemetryWord(ptr, record.out_us[i]);
+  }
+  ptr = putTelemetryWord(ptr, record.mix_exec_time_us);
+  ptr = putTelemetryWord(ptr, record.active_duty_permille);
+
+  uint8_t sum = 0;
+  for (uint8_t * p = payload; p < ptr; p++)
+  {
+    sum += *p;
+  }
+  *ptr++ = (uint8_t) (-sum);
+
+  TelemetryFrameSize = Cobs::encode(payload, PAYLOAD_SIZE, TelemetryFrame);
+}
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+/**
+ * \brief initialize the Telemetry module (USB CDC)
+ */
+void Telemetry::begin()
+{
+  /* The baud rate has no meaning for USB CDC */
+  Serial.begin(115200);
+}
+
+/**
+ * \brief capture a record of the current frame - has to be called from the mix
+ * path after control.execute(), records every output frame once and never
+ * blocks (records are dropped if the buffer is full)
+ */
+void Telemetry::record(bool const is_mixing)
+{
+  /* One record per output frame, the frame period is configurable (see
+   * RcOut::setFramePeriodUs). The output frame counter is used as sequence
+   * counter - the host detects dropped records and frames which were not
+   * recorded as gap.
+   */
+
+  uint8_t const frame_count = RcOut::getFrameCount();
+
+  if (frame_count == TelemetryLastFrameCount)
+  {
+    return;
+  }
+
+  TelemetryLastFrameCount = frame_count;
+
+  uint16_t const now = Scheduler::getTick();
+  uint8_t const seq = frame_count;
+  uint8_t const next_head = (TelemetryRingHead + 1) & (RING_BUFFER_SIZE - 1);
+
+  if (next_head == TelemetryRingTail)
+  {
+    return;
+  }
+
+  T_TELEMETRY_RECORD & record = TelemetryRing[TelemetryRingHead];
+
+  record.seq = seq;
+  record.flags = is_mixing ? FLAG_IS_MIXING : 0;
+  record.tick_ms = now;
+
+  for (uint8_t i = 0; i < NUM_RC_IN_CHANNELS; i++)
+  {
+    record.in_us[i] = RcIn::getPulseDurationUs((E_RC_IN_SELECT) (i));
+    if (RcIn::isGood((E_RC_IN_SELECT) (i)))
+    {
+      record.flags |= (1 << i);
+    }
+  }
+
+  for (uint8_t i = 0; i < NUM_RC_OUT_CHANNELS; i++)
+  {
+    record.out_us[i] = RcOut::getOutputPulseDurationUs((E_RC_OUT_SELECT) (i));
+  }
+
+  T_SCHEDULER_TASK_STATS stats;
+  record.mix_exec_time_us = Scheduler::getTaskStats(MIX_TASK_INDEX, &stats) ? stats.last_exec_time_us : 0;
+
+#if defined(CONFIG_USE_IDLE_SLEEP)
+  record.active_duty_permille = Scheduler::getActiveDutyCyclePermille();
+#else
+  record.active_duty_permille = 1000;
+#endif
+
+  TelemetryRingHead = next_head;
+}
+
+/**
+ * \brief encode and send buffered records as far as the USB buffer allows - has
+ * to be called periodically from a low priority task
+ */
+void Telemetry::transmit()
+{
+  /* Discard everything while no terminal is connected, Serial.write
+   * would block until a timeout otherwise
+   */
+
+  if (!Serial.dtr())
+  {
+    TelemetryRingTail = TelemetryRingHead;
+    TelemetryFrameSize = 0;
+    return;
+  }
+
+  while (true)
+  {
+    if (TelemetryFrameSize == 0)
+    {
+      if (TelemetryRingTail == TelemetryRingHead)
+      {
+        return;
+      }
+
+      prepareTelemetryFrame(TelemetryRing[TelemetryRingTail]);
+      TelemetryRingTail = (TelemetryRingTail + 1) & (RING_BUFFER_SIZE - 1);
+    }
+
+    /* Only write whole frames and only if they fit into the USB
+     * buffer - never wait for the host
+     */
+
+    if (Serial.availableForWrite() < TelemetryFrameSize)
+    {
+      return;
+    }
+
+    Serial.write(TelemetryFrame, TelemetryFrameSize);
+    TelemetryFrameSize = 0;
+  }
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+#ifdef CONFIG_USE_TELEMETRY
+
+/************************************************************************/
+/* PUBLIC TYPES                                                         */
+/************************************************************************/
+
+/* Every record is sent as one COBS encoded frame terminated by 0x00,
+ * all values are little endian:
+ *
+ *   [type 0x01] [seq] [flags] [tick_ms:2] [IN1..IN4 us:2 each]
+ *   [OUT1..OUT6 us:2 each] [mix_exec_time_us:2] [active_duty_permille:2]
+ *   [checksum]
+ *
+ *   flags    bit 0..3 = IN1..IN4 good, bit 7 = control is mixing
+ *   OUTx us  pulse duration output in the current frame (after reverse,
+ *            subtrim, endpoints, slew rate limit and failsafe), 0 = no pulses
+ *   checksum chosen so that the sum of all bytes of the record is 0
+ *
+ * One record is sent per output frame, seq is the output frame counter
+ * (see RcOut::getFrameCount). A gap in seq means that records were
+ * dropped because the host did not read fast enough. software/tools/telemetry.py decodes the stream.
+ */
+
+static uint8_t const TELEMETRY_RECORD_TYPE_FRAME = 0x01;
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+class Telemetry
+{
+
+public:
+
+  /**
+   * \brief initialize the Telemetry module (USB CDC)
+   */
+  static void begin();
+
+  /**
+   * \brief capture a record of the current frame - has to be called from the mix
+   * path after control.execute(), records every output frame once and never
+   * blocks (records are dropped if the buffer is full)
+   */
+  static void record(bool const is_mixing);
+
+  /**
+   * \brief encode and send buffered records as far as the USB buffer allows - has
+   * to be called periodically from a low priority task
+   */
+  static void transmit();
+
+private:
+
+  /**
+   * \brief no public constructing
+   */
+  Telemetry() { }
+};
+
+#endif
+
+#endif /* TELEMETRY_H_ */
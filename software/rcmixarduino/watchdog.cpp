@@ -0,0 +1,344 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include "watchdog.h"
+
+#include <avr/io.h>
+#include <avr/wdt.h>
+#include <avr/interrupt.h>
+
+#include <util/atomic.h>
+
+#ifdef CONFIG_USE_WATCHDOG
+
+#include "rcout.h"
+
+/************************************************************************/
+/* PRIVATE CONTANTS                                                     */
+/************************************************************************/
+
+static uint8_t const NUM_RC_OUT_CHANNELS = 6;
+
+static uint8_t const WATCHDOG_RECORD_MAGIC = 0x57;
+
+static uint8_t const WATCHDOG_FLAG_MIXING        = 0x01; /* The control was in the mixing state */
+static uint8_t const WATCHDOG_FLAG_EXPIRED       = 0x02; /* The watchdog interrupt has been executed */
+static uint8_t const WATCHDOG_FLAG_BAD_INTERRUPT = 0x04; /* BADISR_vect has been executed */
+
+/* The watchdog interrupt is executed after the timeout in order to record
+ * the cause, the reset follows after a second timeout. Without the
+ * scheduler the control blocks for 100 ms while blinking in failsafe.
+ */
+
+#if defined(CONFIG_USE_SCHEDULER)
+static uint8_t const WATCHDOG_PRESCALER = (1 << WDP1);  /* 64 ms */
+#else
+static uint8_t const WATCHDOG_PRESCALER = (1 << WDP2);  /* 256 ms */
+#endif
+
+/* The Arduino core resets into the bootloader for an upload by enabling
+ * the watchdog with a timeout of 120 ms - the watchdog is not fed while
+ * it is configured with another timeout than ours
+ */
+
+static uint8_t const WATCHDOG_PRESCALER_MASK = (1 << WDP3) | (1 << WDP2) | (1 << WDP1) | (1 << WDP0);
+
+/************************************************************************/
+/* PRIVATE TYPEDEFS                                                     */
+/************************************************************************/
+
+/* This record is located in the .noinit section and therefore survives a
+ * reset as long as the ram content is not lost (power-on)
+ */
+
+typedef struct
+{
+  uint8_t  magic;
+  uint8_t  flags;
+  uint16_t pulse_duration_us[NUM_RC_OUT_CHANNELS];  /* Pulse duration output last, 0 = no pulses */
+  uint16_t reset_count[NUM_RESET_CAUSES];
+  uint8_t  checksum;                                /* Chosen so that the sum of all bytes of the record is 0 */
+} T_WATCHDOG_RECORD;
+
+/************************************************************************/
+/* PRIVATE DATA                                                         */
+/************************************************************************/
+
+static volatile T_WATCHDOG_RECORD WatchdogRecord __attribute__((section(".noinit")));
+
+/* MCUSR is captured before the .bss section is cleared */
+
+static uint8_t WatchdogResetFlags __attribute__((section(".noinit")));
+
+static uint8_t       WatchdogFrameCount = 0;
+static E_RESET_CAUSE WatchdogLastCause  = RESET_CAUSE_POWER_ON;
+static bool          WatchdogWasMixing  = false;
+
+/************************************************************************/
+/* PRIVATE FUNCTIONS                                                    */
+/************************************************************************/
+
+/**
+ * \brief executed by the startup code before the variables are initialized - save the
+ * reset flags and stop the watchdog which keeps running after a watchdog reset
+ */
+void captureWatchdogResetFlags() __attribute__((naked, used, section(".init3")));
+void captureWatchdogResetFlags()
+{
+  WatchdogResetFlags = MCUSR;
+  MCUSR = 0;
+  wdt_disable();
+}
+
+/**
+ * \brief returns the sum of all bytes of the record
+ */
+uint8_t sumWatchdogRecord()
+{
+  volatile uint8_t const * ptr = (volatile uint8_t const *) (&WatchdogRecord);
+  uint8_t sum = 0;
+
+  for (uint8_t i = 0; i < sizeof(T_WATCHDOG_RECORD); i++)
+  {
+    sum += ptr[i];
+  }
+
+  return sum;
+}
+
+/**
+ * \brief update the checksum after the record has been changed
+ */
+void sealWatchdogRecord()
+{
+  WatchdogRecord.checksum = 0;
+  WatchdogRecord.checksum = -sumWatchdogRecord();
+}
+
+/**
+ * \brief start the watchdog in interrupt and system reset mode
+ */
+void enableWatchdog()
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    wdt_reset();
+    WDTCSR = (1 << WDCE) | (1 << WDE);
+    WDTCSR = (1 << WDIE) | (1 << WDE) | WATCHDOG_PRESCALER;
+  }
+}
+
+/************************************************************************/
+/* PUBLIC FUNCTIONS                                                     */
+/************************************************************************/
+
+/**
+ * \brief evaluate the cause of the last reset, restore the outputs after a watchdog
+ * reset and start the watchdog - has to be called after the failsafe policies have
+ * been configured and before RcOut::begin
+ */
+void Watchdog::begin()
+{
+  bool const is_record_valid = (WatchdogRecord.magic == WATCHDOG_RECORD_MAGIC) && (sumWatchdogRecord() == 0);
+  uint8_t const flags = is_record_valid ? WatchdogRecord.flags : 0;
+
+  /* The flags of the record take precedence since the bootloader clears
+   * the reset flags before the sketch is started
+   */
+
+  E_RESET_CAUSE cause = RESET_CAUSE_UNKNOWN;
+
+  if (flags & WATCHDOG_FLAG_BAD_INTERRUPT)
+  {
+    cause = RESET_CAUSE_BAD_INTERRUPT;
+  }
+  else if ((flags & WATCHDOG_FLAG_EXPIRED) || (WatchdogResetFlags & (1 << WDRF)))
+  {
+    cause = RESET_CAUSE_WATCHDOG;
+  }
+  else if ((WatchdogResetFlags & (1 << PORF)) || !is_record_valid)
+  {
+    cause = RESET_CAUSE_POWER_ON;
+  }
+  else if (WatchdogResetFlags & (1 << BORF))
+  {
+    cause = RESET_CAUSE_BROWN_OUT;
+  }
+  else if (WatchdogResetFlags & ((1 << EXTRF) | (1 << JTRF)))
+  {
+    cause = RESET_CAUSE_EXTERNAL;
+  }
+
+  if (!is_record_valid)
+  {
+    for (uint8_t i = 0; i < NUM_RESET_CAUSES; i++)
+    {
+      WatchdogRecord.reset_count[i] = 0;
+    }
+  }
+
+  if (WatchdogRecord.reset_count[cause] < 0xFFFF)
+  {
+    WatchdogRecord.reset_count[cause]++;
+  }
+
+  WatchdogLastCause = cause;
+  WatchdogWasMixing = (flags & WATCHDOG_FLAG_MIXING) != 0;
+
+  /* Continue with the pulses output last as if the control had entered
+   * failsafe at the time it stopped (hold and failsafe action according
+   * to the failsafe policy)
+   */
+
+  bool const is_restored = is_record_valid
+      && (cause == RESET_CAUSE_WATCHDOG || cause == RESET_CAUSE_BAD_INTERRUPT);
+
+  for (uint8_t sel = OUT1; sel <= OUT6; sel++)
+  {
+    if (is_restored)
+    {
+      RcOut::setRcOutState((E_RC_OUT_SELECT) (sel), OUTx_FAILSAFE);
+      RcOut::setFailsafeHoldPulseDurationUs((E_RC_OUT_SELECT) (sel), WatchdogRecord.pulse_duration_us[sel]);
+    }
+    else
+    {
+      WatchdogRecord.pulse_duration_us[sel] = 0;
+    }
+  }
+
+  WatchdogRecord.magic = WATCHDOG_RECORD_MAGIC;
+  WatchdogRecord.flags = 0;
+  sealWatchdogRecord();
+
+  WatchdogFrameCount = RcOut::getFrameCount();
+
+  enableWatchdog();
+}
+
+/**
+ * \brief feed the watchdog, called after every pass of the control
+ */
+void Watchdog::feed(bool const is_mixing)
+{
+  /* The watchdog is fed once per output frame, a stopped output isr
+   * results in a reset as well
+   */
+
+  uint8_t const frame_count = RcOut::getFrameCount();
+
+  if (frame_count == WatchdogFrameCount)
+  {
+    return;
+  }
+
+  WatchdogFrameCount = frame_count;
+
+  uint8_t const wdtcsr = WDTCSR;
+
+  if (!(wdtcsr & (1 << WDE)))
+  {
+    /* Disabled by the Arduino core after a cancelled upload */
+    enableWatchdog();
+  }
+  else if ((wdtcsr & WATCHDOG_PRESCALER_MASK) != WATCHDOG_PRESCALER)
+  {
+    /* A reset into the bootloader is pending */
+    return;
+  }
+  else if (!(wdtcsr & (1 << WDIE)))
+  {
+    /* The control has been stalled for longer than the timeout but
+     * recovered before the reset - rearm the interrupt
+     */
+    enableWatchdog();
+  }
+  else
+  {
+    wdt_reset();
+  }
+
+  uint16_t pulse_duration_us[NUM_RC_OUT_CHANNELS];
+
+  for (uint8_t sel = OUT1; sel <= OUT6; sel++)
+  {
+    pulse_duration_us[sel] = RcOut::getOutputPulseDurationUs((E_RC_OUT_SELECT) (sel));
+  }
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    for (uint8_t sel = OUT1; sel <= OUT6; sel++)
+    {
+      WatchdogRecord.pulse_duration_us[sel] = pulse_duration_us[sel];
+    }
+    WatchdogRecord.flags = is_mixing ? WATCHDOG_FLAG_MIXING : 0;
+    sealWatchdogRecord();
+  }
+}
+
+/**
+ * \brief called from BADISR_vect before it stops, the following watchdog reset
+ * is counted as RESET_CAUSE_BAD_INTERRUPT
+ */
+void Watchdog::markBadInterrupt()
+{
+  WatchdogRecord.flags |= WATCHDOG_FLAG_BAD_INTERRUPT;
+  sealWatchdogRecord();
+}
+
+/**
+ * \brief returns the cause of the last reset and the reset counters
+ */
+void Watchdog::getResetInfo(T_WATCHDOG_RESET_INFO * info)
+{
+  info->cause = WatchdogLastCause;
+  info->was_mixing = WatchdogWasMixing;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    for (uint8_t i = 0; i < NUM_RESET_CAUSES; i++)
+    {
+      info->count[i] = WatchdogRecord.reset_count[i];
+    }
+  }
+}
+
+/************************************************************************/
+/* INTERRUPT SERVICE HANDLERS                                           */
+/************************************************************************/
+
+/**
+ * \brief watchdog interrupt service routine - executed when the watchdog has not
+ * been fed within the timeout, the reset follows after another timeout
+ */
+ISR(WDT_vect)
+{
+  WatchdogRecord.flags |= WATCHDOG_FLAG_EXPIRED;
+  sealWatchdogRecord();
+}
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+/************************************************************************/
+/* INCLUDES                                                             */
+/************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+#ifdef CONFIG_USE_WATCHDOG
+
+/************************************************************************/
+/* PUBLIC TYPES                                                         */
+/************************************************************************/
+
+typedef enum
+{
+  RESET_CAUSE_POWER_ON      = 0,
+  RESET_CAUSE_EXTERNAL      = 1, /* Reset pin or JTAG */
+  RESET_CAUSE_BROWN_OUT     = 2,
+  RESET_CAUSE_WATCHDOG      = 3, /* The control has not been executed within the timeout */
+  RESET_CAUSE_BAD_INTERRUPT = 4, /* Watchdog reset after an interrupt without handler (BADISR_vect) */
+  RESET_CAUSE_UNKNOWN       = 5  /* Warm reset, the reset flags have been cleared by the bootloader */
+} E_RESET_CAUSE;
+
+static uint8_t const NUM_RESET_CAUSES = 6;
+
+typedef struct
+{
+  E_RESET_CAUSE cause;                        /* Cause of the last reset */
+  bool          was_mixing;                   /* Mode of the control before the last reset */
+  uint16_t      count[NUM_RESET_CAUSES];      /* Number of resets per cause since the last loss of the ram content */
+} T_WATCHDOG_RESET_INFO;
+
+/************************************************************************/
+/* PUBLIC PROTOTYPES                                                    */
+/************************************************************************/
+
+/* The hardware watchdog is fed by every pass of the control as long as
+ * the output isr keeps starting new frames. A record in the .noinit
+ * section survives the reset: it holds the mode of the control, the
+ * pulse durations output last and the reset counters. After a watchdog
+ * reset the outputs continue with their last pulse durations in failsafe
+ * (held according to their failsafe policy) right from the first frame.
+ */
+
+class Watchdog
+{
+
+public:
+
+  /**
+   * \brief evaluate the cause of the last reset, restore the outputs after a watchdog
+   * reset and start the watchdog - has to be called after the failsafe policies have
+   * been configured and before RcOut::begin
+   */
+  static void begin();
+
+  /**
+   * \brief feed the watchdog, called after every pass of the control
+   */
+  static void feed(bool const is_mixing);
+
+  /**
+   * \brief called from BADISR_vect before it stops, the following watchdog reset
+   * is counted as RESET_CAUSE_BAD_INTERRUPT
+   */
+  static void markBadInterrupt();
+
+  /**
+   * \brief returns the cause of the last reset and the reset counters
+   */
+  static void getResetInfo(T_WATCHDOG_RESET_INFO * info);
+
+private:
+
+  /**
+   * \brief no public constructing
+   */
+  Watchdog() { }
+};
+
+#endif
+
+#endif /* WATCHDOG_H_ */
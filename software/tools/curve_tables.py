@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+#
+# MIT License
+#
+# Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+"""
+Generates and verifies the expo lookup tables of the curve engine
+(software/rcmixarduino/curve_tables.h).
+
+  curve_tables.py generate   - write curve_tables.h
+  curve_tables.py verify     - check that curve_tables.h is up to date and that
+                               the interpolated tables stay within the allowed
+                               error of the exact expo function
+"""
+
+import argparse
+import os
+import sys
+
+# These values have to match the constants in curve.cpp
+
+DOMAIN_US = 512                # Input and output range is -512 .. +512 us around the center
+NUM_POINTS = 17                # Points of the half (positive) expo curve
+SEGMENT_US = DOMAIN_US // (NUM_POINTS - 1)
+EXPO_STEP_PERCENT = 10         # One table row per 10 % of expo
+NUM_EXPO_ROWS = 100 // EXPO_STEP_PERCENT + 1
+
+MAX_ERROR_US = 4               # Allowed deviation of interpolation vs exact function
+
+TABLE_FILE = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                          '..', 'rcmixarduino', 'curve_tables.h')
+
+LICENSE = '''/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+'''
+
+
+def expo(x_us, expo_percent):
+    """ Exact expo function y = (1 - e) * x + e * x^3 for normalized x """
+    e = expo_percent / 100.0
+    x = x_us / DOMAIN_US
+    return DOMAIN_US * ((1.0 - e) * x + e * x * x * x)
+
+
+def build_table():
+    return [[int(round(expo(i * SEGMENT_US, row * EXPO_STEP_PERCENT))) for i in range(NUM_POINTS)]
+            for row in range(NUM_EXPO_ROWS)]
+
+
+def lookup(table, row, x_us):
+    """ Bit exact model of the table lookup in curve.cpp (for 0 <= x_us <= DOMAIN_US) """
+    if x_us >= DOMAIN_US:
+        return table[row][NUM_POINTS - 1]
+    index = x_us // SEGMENT_US
+    frac = x_us % SEGMENT_US
+    y0 = table[row][index]
+    y1 = table[row][index + 1]
+    return y0 + ((y1 - y0) * frac) // SEGMENT_US
+
+
+def render(table):
+    lines = [LICENSE,
+             '/* Generated by software/tools/curve_tables.py - do not edit */',
+             '',
+             '#ifndef CURVE_TABLES_H_',
+             '#define CURVE_TABLES_H_',
+             '',
+             '#include <stdint.h>',
+             '',
+             '#include <avr/pgmspace.h>',
+             '',
+             '/* y = (1 - e) * x + e * x^3 for 0 <= x <= %d us in steps of %d us,' % (DOMAIN_US, SEGMENT_US),
+             ' * one row per %d %% of expo (e = 0 %% ... 100 %%)' % EXPO_STEP_PERCENT,
+             ' */',
+             '',
+             'static uint16_t const CURVE_EXPO_TABLE[%d][%d] PROGMEM =' % (NUM_EXPO_ROWS, NUM_POINTS),
+             '{']
+    for row, values in enumerate(table):
+        sep = ',' if row < len(table) - 1 else ''
+        lines.append('  {' + ', '.join('%3d' % v for v in values) + '}' + sep
+                     + ' /* %3d %% */' % (row * EXPO_STEP_PERCENT))
+    lines += ['};', '', '#endif /* CURVE_TABLES_H_ */', '']
+    return '\n'.join(lines)
+
+
+def verify(table):
+    ok = True
+
+    if not os.path.exists(TABLE_FILE) or open(TABLE_FILE).read() != render(table):
+        print('curve_tables.h is missing or out of date - run "curve_tables.py generate"')
+        ok = False
+
+    for row in range(NUM_EXPO_ROWS):
+        max_error = 0.0
+        previous = -1
+        for x in range(DOMAIN_US + 1):
+            y = lookup(table, row, x)
+            max_error = max(max_error, abs(y - expo(x, row * EXPO_STEP_PERCENT)))
+            if y < previous:
+                print('row %d: not monotonic at x = %d us' % (row, x))
+                ok = False
+            previous = y
+        if table[row][0] != 0 or table[row][-1] != DOMAIN_US:
+            print('row %d: does not pass through 0 and %d us' % (row, DOMAIN_US))
+            ok = False
+        if max_error > MAX_ERROR_US:
+            print('row %d: max interpolation error %.2f us > %d us' % (row, max_error, MAX_ERROR_US))
+            ok = False
+        print('expo %3d %%: max interpolation error %.2f us' % (row * EXPO_STEP_PERCENT, max_error))
+
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('command', choices=['generate', 'verify'])
+    args = parser.parse_args()
+
+    table = build_table()
+
+    if args.command == 'generate':
+        with open(TABLE_FILE, 'w') as f:
+            f.write(render(table))
+        return 0
+
+    return 0 if verify(table) else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+#
+# MIT License
+#
+# Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+"""
+Drives the rc mixer from the PC over USB CDC and measures the round trip
+time of the host link (software/rcmixarduino/hostlink.h, command.h).
+
+  hostctl.py /dev/ttyACM0 outputs 1500 1500 1600    - set OUT1..OUT3 at 200 Hz for 5 s
+  hostctl.py /dev/ttyACM0 inputs 1500 1700 --rate 500 --duration 10
+                                                    - override IN1, IN2 at 500 Hz for 10 s
+  hostctl.py /dev/ttyACM0 release                   - hand the control back to the rc inputs
+
+Every request waits for its response, the round trip time is measured
+from sending the request until its response (same seq) is received. The
+control is released when the tool terminates. The firmware has to be
+built with CONFIG_USE_HOST_CONTROL.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+from rcmixcfg import Device, param_index
+
+COMMAND_HOST_INPUTS = 0x20
+COMMAND_HOST_OUTPUTS = 0x21
+COMMAND_HOST_RELEASE = 0x22
+
+# Has to match E_HOST_LINK_STATE in hostlink.h
+
+LINK_STATES = ['idle', 'inputs', 'outputs', 'lost']
+
+NUM_INPUTS = 4
+NUM_OUTPUTS = 6
+
+
+def host_request(device, command, seq, args=b''):
+    """ Sends a host request and returns the link state of its response """
+    data = device.request(command, bytes([seq]) + args)
+    if len(data) != 2 or data[0] != seq:
+        raise RuntimeError('command 0x%02x: unexpected response' % command)
+    return data[1]
+
+
+def percentile(values, fraction):
+    return values[min(len(values) - 1, int(len(values) * fraction))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('port', help='serial port (e.g. /dev/ttyACM0)')
+    parser.add_argument('command', choices=['outputs', 'inputs', 'release'])
+    parser.add_argument('values', nargs='*', type=int, help='pulse durations in us, starting at OUT1 / IN1')
+    parser.add_argument('--rate', type=float, default=200.0, help='requests per second (default 200)')
+    parser.add_argument('--duration', type=float, default=5.0, help='seconds (default 5)')
+    args = parser.parse_args()
+
+    num_channels = NUM_OUTPUTS if args.command == 'outputs' else NUM_INPUTS
+    if len(args.values) > num_channels:
+        parser.error('at most %d values' % num_channels)
+
+    device = Device(args.port)
+
+    if args.command == 'release':
+        try:
+            print(LINK_STATES[host_request(device, COMMAND_HOST_RELEASE, 0)])
+        except RuntimeError as error:
+            print(error, file=sys.stderr)
+            return 1
+        return 0
+
+    timeout_ms = device.get(param_index('host_timeout_ms'))[0]
+    if 1000.0 / args.rate >= timeout_ms:
+        print('warning: the rate is below the link timeout of %d ms' % timeout_ms, file=sys.stderr)
+
+    command = COMMAND_HOST_OUTPUTS if args.command == 'outputs' else COMMAND_HOST_INPUTS
+    mask = (1 << len(args.values)) - 1
+    values = args.values + [0] * (num_channels - len(args.values))
+    request_args = bytes([mask]) + struct.pack('<%dH' % num_channels, *values)
+
+    period_s = 1.0 / args.rate
+    round_trips_ms = []
+    num_errors = 0
+    seq = 0
+    state = None
+
+    try:
+        start = time.time()
+        next_time = start
+        while time.time() - start < args.duration:
+            sent = time.perf_counter()
+            try:
+                state = host_request(device, command, seq, request_args)
+                round_trips_ms.append((time.perf_counter() - sent) * 1000.0)
+            except RuntimeError as error:
+                print(error, file=sys.stderr)
+                num_errors += 1
+            seq = (seq + 1) & 0xFF
+            next_time += period_s
+            delay = next_time - time.time()
+            if delay > 0:
+                time.sleep(delay)
+            else:
+                next_time = time.time()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        try:
+            host_request(device, COMMAND_HOST_RELEASE, seq)
+        except RuntimeError as error:
+            print(error, file=sys.stderr)
+
+    if round_trips_ms:
+        round_trips_ms.sort()
+        print('%d requests, %d errors, link %s' % (len(round_trips_ms) + num_errors, num_errors,
+                                                  LINK_STATES[state] if state is not None else '-'))
+        print('round trip min %.2f ms  avg %.2f ms  p99 %.2f ms  max %.2f ms' % (
+            round_trips_ms[0], sum(round_trips_ms) / len(round_trips_ms),
+            percentile(round_trips_ms, 0.99), round_trips_ms[-1]))
+    else:
+        print('no response', file=sys.stderr)
+        return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,304 @@
+#!/usr/bin/env python3
+#
+# MIT License
+#
+# Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+"""
+Assembler for the mixing programs executed by ControlBytecode
+(software/rcmixarduino/control_bytecode.h).
+
+  mixasm.py program.mix                    - verify, print listing and estimated worst case cycles
+  mixasm.py program.mix --hex eeprom.hex   - write an Intel HEX file for the EEPROM
+                                             (avrdude ... -U eeprom:w:eeprom.hex:i)
+  mixasm.py program.mix --run 1500 1700    - execute the program with the given
+                                             input pulse durations (IN1, IN2, ...)
+
+rcmixcfg.py ... upload program.mix uploads a program over USB instead,
+the device verifies it before it is written to the EEPROM.
+
+Syntax (one instruction per line, ';' starts a comment):
+
+  label:
+    in 1        push pulse duration of IN1 - 1500
+    out 2       pop and set OUT2 to 1500 + value
+    push -200   push an immediate value ('0.5q' = 0.5 as 8.8 fixed point = 128)
+    add sub mulq neg abs min max lt dup swap drop halt
+    jz label    pop and jump forward to label if zero
+    jmp label   jump forward to label
+"""
+
+import argparse
+import sys
+
+# These values have to match control_bytecode.h / control_bytecode.cpp
+
+EEPROM_PROGRAM_ADDRESS = 0x300
+PROGRAM_MAGIC = 0xB7
+MAX_PROGRAM_SIZE = 128
+STACK_SIZE = 8
+MAX_PROGRAM_CYCLES = 16000
+MAX_PENDING_JUMPS = 8
+NUM_INPUTS = 4
+NUM_OUTPUTS = 6
+
+# name: (opcode, size, pops, pushes, cycles)
+
+INSTRUCTIONS = {
+    'halt': (0x00, 1, 0, 0, 10),
+    'in':   (0x01, 2, 0, 1, 80),
+    'out':  (0x02, 2, 1, 0, 300),
+    'push': (0x03, 3, 0, 1, 30),
+    'add':  (0x04, 1, 2, 1, 40),
+    'sub':  (0x05, 1, 2, 1, 40),
+    'mulq': (0x06, 1, 2, 1, 80),
+    'neg':  (0x07, 1, 1, 1, 25),
+    'abs':  (0x08, 1, 1, 1, 25),
+    'min':  (0x09, 1, 2, 1, 35),
+    'max':  (0x0A, 1, 2, 1, 35),
+    'lt':   (0x0B, 1, 2, 1, 35),
+    'dup':  (0x0C, 1, 1, 2, 25),
+    'swap': (0x0D, 1, 2, 2, 30),
+    'drop': (0x0E, 1, 1, 0, 20),
+    'jz':   (0x0F, 2, 1, 0, 30),
+    'jmp':  (0x10, 2, 0, 0, 20),
+}
+
+BY_OPCODE = {v[0]: (k,) + v[1:] for k, v in INSTRUCTIONS.items()}
+
+
+class AsmError(Exception):
+    pass
+
+
+def parse_value(text):
+    if text.endswith('q'):
+        return int(round(float(text[:-1]) * 256))
+    return int(text, 0)
+
+
+def assemble(source):
+    """ Two pass assembly, returns the code as bytes """
+    lines = []
+    labels = {}
+    address = 0
+
+    for number, line in enumerate(source.splitlines(), 1):
+        line = line.split(';')[0].strip()
+        while ':' in line:
+            label, line = line.split(':', 1)
+            labels[label.strip()] = address
+            line = line.strip()
+        if not line:
+            continue
+        words = line.split()
+        name = words[0].lower()
+        if name not in INSTRUCTIONS:
+            raise AsmError('line %d: unknown instruction "%s"' % (number, name))
+        lines.append((number, address, name, words[1:]))
+        address += INSTRUCTIONS[name][1]
+
+    code = bytearray()
+    for number, address, name, args in lines:
+        opcode, size = INSTRUCTIONS[name][:2]
+        if len(args) != size - (2 if name == 'push' else 1):
+            raise AsmError('line %d: wrong number of operands' % number)
+        code.append(opcode)
+        if name in ('in', 'out'):
+            channel = int(args[0])
+            if channel < 1:
+                raise AsmError('line %d: channels start at 1' % number)
+            code.append(channel - 1)
+        elif name == 'push':
+            value = parse_value(args[0])
+            if not -32768 <= value <= 32767:
+                raise AsmError('line %d: value out of range' % number)
+            code += (value & 0xFFFF).to_bytes(2, 'little')
+        elif name in ('jz', 'jmp'):
+            if args[0] not in labels:
+                raise AsmError('line %d: unknown label "%s"' % (number, args[0]))
+            offset = labels[args[0]] - (address + size)
+            if offset < 0:
+                raise AsmError('line %d: only forward jumps are possible' % number)
+            if offset > 255:
+                raise AsmError('line %d: jump too far' % number)
+            code.append(offset)
+
+    return bytes(code)
+
+
+def verify(code):
+    """ Model of ControlBytecode::verify, returns (in_mask, out_mask, worst_case_cycles) """
+    if len(code) > MAX_PROGRAM_SIZE:
+        raise AsmError('program too large (%d > %d bytes)' % (len(code), MAX_PROGRAM_SIZE))
+
+    pending = {}
+    depth = 0
+    reachable = True
+    cycles = 0
+    in_mask = 0
+    out_mask = 0
+    pc = 0
+
+    while pc < len(code):
+        if pc in pending:
+            if reachable and pending[pc] != depth:
+                raise AsmError('%d: inconsistent stack depth at jump target' % pc)
+            depth = pending.pop(pc)
+            reachable = True
+        if not reachable:
+            raise AsmError('%d: unreachable code' % pc)
+        if code[pc] not in BY_OPCODE:
+            raise AsmError('%d: unknown opcode 0x%02X' % (pc, code[pc]))
+        name, size, pops, pushes, cost = BY_OPCODE[code[pc]]
+        if pc + size > len(code):
+            raise AsmError('%d: instruction exceeds the program' % pc)
+        if name == 'in':
+            if code[pc + 1] >= NUM_INPUTS:
+                raise AsmError('%d: no such input' % pc)
+            in_mask |= 1 << code[pc + 1]
+        if name == 'out':
+            if code[pc + 1] >= NUM_OUTPUTS:
+                raise AsmError('%d: no such output' % pc)
+            out_mask |= 1 << code[pc + 1]
+        if depth < pops or depth - pops + pushes > STACK_SIZE:
+            raise AsmError('%d: stack under- or overflow' % pc)
+        depth = depth - pops + pushes
+        if name in ('jz', 'jmp'):
+            target = pc + size + code[pc + 1]
+            if target > len(code):
+                raise AsmError('%d: jump beyond the program' % pc)
+            if target < len(code):
+                if target in pending and pending[target] != depth:
+                    raise AsmError('%d: inconsistent stack depth at jump target' % pc)
+                if target not in pending and len(pending) >= MAX_PENDING_JUMPS:
+                    raise AsmError('%d: too many pending jumps' % pc)
+                pending[target] = depth
+        if name in ('jmp', 'halt'):
+            reachable = False
+        cycles += cost
+        pc += size
+
+    if pending:
+        raise AsmError('jump into the middle of an instruction')
+    if cycles > MAX_PROGRAM_CYCLES:
+        raise AsmError('estimated %d cycles exceed the budget of %d cycles' % (cycles, MAX_PROGRAM_CYCLES))
+
+    return in_mask, out_mask, cycles
+
+
+def saturate(value):
+    return max(-32768, min(32767, value))
+
+
+def run(code, inputs):
+    """ Model of ControlBytecode::mixingFunc, returns the pulse durations written to the outputs """
+    stack = []
+    outputs = {}
+    pc = 0
+    while pc < len(code):
+        name, size = BY_OPCODE[code[pc]][:2]
+        if name == 'in':
+            stack.append(inputs[code[pc + 1]] - 1500)
+        elif name == 'out':
+            outputs[code[pc + 1] + 1] = 1500 + max(-1000, min(1000, stack.pop()))
+        elif name == 'push':
+            stack.append(int.from_bytes(code[pc + 1:pc + 3], 'little', signed=True))
+        elif name in ('add', 'sub', 'mulq', 'min', 'max', 'lt'):
+            b = stack.pop()
+            a = stack.pop()
+            stack.append({'add': lambda: saturate(a + b),
+                          'sub': lambda: saturate(a - b),
+                          'mulq': lambda: saturate((a * b) >> 8),
+                          'min': lambda: min(a, b),
+                          'max': lambda: max(a, b),
+                          'lt': lambda: int(a < b)}[name]())
+        elif name == 'neg':
+            stack.append(saturate(-stack.pop()))
+        elif name == 'abs':
+            stack.append(saturate(abs(stack.pop())))
+        elif name == 'dup':
+            stack.append(stack[-1])
+        elif name == 'swap':
+            stack[-1], stack[-2] = stack[-2], stack[-1]
+        elif name == 'drop':
+            stack.pop()
+        elif name == 'jz':
+            if stack.pop() == 0:
+                pc += code[pc + 1]
+        elif name == 'jmp':
+            pc += code[pc + 1]
+        elif name == 'halt':
+            break
+        pc += size
+    return outputs
+
+
+def image(code):
+    return bytes([PROGRAM_MAGIC, len(code), sum(code) & 0xFF]) + code
+
+
+def intel_hex(data, address):
+    records = []
+    for offset in range(0, len(data), 16):
+        chunk = data[offset:offset + 16]
+        addr = address + offset
+        record = bytes([len(chunk), addr >> 8, addr & 0xFF, 0]) + chunk
+        records.append(':' + record.hex().upper() + '%02X' % (-sum(record) & 0xFF))
+    records.append(':00000001FF')
+    return '\n'.join(records) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('program')
+    parser.add_argument('--hex', help='write the EEPROM image as Intel HEX file')
+    parser.add_argument('--run', nargs='+', type=int, metavar='US', help='input pulse durations')
+    args = parser.parse_args()
+
+    try:
+        code = assemble(open(args.program).read())
+        in_mask, out_mask, cycles = verify(code)
+    except AsmError as e:
+        print('%s: %s' % (args.program, e), file=sys.stderr)
+        return 1
+
+    print('%d bytes, inputs %s, outputs %s' % (
+        len(code),
+        ' '.join('IN%d' % (i + 1) for i in range(NUM_INPUTS) if in_mask & (1 << i)),
+        ' '.join('OUT%d' % (i + 1) for i in range(NUM_OUTPUTS) if out_mask & (1 << i))))
+    print('estimated worst case %d cycles = %.1f us at 16 MHz' % (cycles, cycles / 16.0))
+
+    if args.hex:
+        with open(args.hex, 'w') as f:
+            f.write(intel_hex(image(code), EEPROM_PROGRAM_ADDRESS))
+
+    if args.run:
+        inputs = (args.run + [1500] * NUM_INPUTS)[:NUM_INPUTS]
+        for channel, value in sorted(run(code, inputs).items()):
+            print('OUT%d = %d us' % (channel, value))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
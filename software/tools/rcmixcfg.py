@@ -0,0 +1,325 @@
+#!/usr/bin/env python3
+#
+# MIT License
+#
+# Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+"""
+Reads and changes the parameters of the rc mixer over USB CDC
+(software/rcmixarduino/command.h, param.h).
+
+  rcmixcfg.py /dev/ttyACM0 list               - print all parameters
+  rcmixcfg.py /dev/ttyACM0 get deadzone_us    - print one parameter
+  rcmixcfg.py /dev/ttyACM0 set deadzone_us 30 - change a parameter (active at the next frame)
+  rcmixcfg.py /dev/ttyACM0 save               - write all parameters to the EEPROM
+  rcmixcfg.py /dev/ttyACM0 defaults           - set all parameters to their default value
+  rcmixcfg.py /dev/ttyACM0 boot               - print the time to the first output pulse and to mixing
+  rcmixcfg.py /dev/ttyACM0 latency            - print the latency statistics and the output isr jitter
+  rcmixcfg.py /dev/ttyACM0 latency reset      - discard the latency statistics
+  rcmixcfg.py /dev/ttyACM0 reset              - print the cause of the last reset and the reset counters
+  rcmixcfg.py /dev/ttyACM0 events             - print the event log (oldest first)
+  rcmixcfg.py /dev/ttyACM0 diversity          - print the state of both receivers (receiver diversity)
+  rcmixcfg.py /dev/ttyACM0 upload prog.mix    - assemble, verify and store a mixing program (loaded at the next reset)
+  rcmixcfg.py /dev/ttyACM0 program            - print the loaded mixing program
+
+Changes are lost at the next reset unless they are saved. deadzone_us
+and center_us can only be set in a firmware with input curves
+(CONFIG_USE_CURVE), otherwise the mixers use their own values. Telemetry
+frames on the same port are skipped.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import termios
+import time
+import tty
+
+import mixasm
+from telemetry import cobs_decode, frames
+
+RESPONSE_TYPE = 0x02
+
+COMMAND_PARAM_INFO = 0x10
+COMMAND_PARAM_GET = 0x11
+COMMAND_PARAM_SET = 0x12
+COMMAND_PARAM_SAVE = 0x13
+COMMAND_PARAM_DEFAULTS = 0x14
+COMMAND_BOOT_INFO = 0x30
+COMMAND_LATENCY_GET = 0x31
+COMMAND_LATENCY_ISR = 0x32
+COMMAND_LATENCY_RESET = 0x33
+COMMAND_RESET_INFO = 0x34
+COMMAND_EVENT_LOG_READ = 0x35
+COMMAND_DIVERSITY_INFO = 0x36
+COMMAND_BYTECODE_WRITE = 0x40
+COMMAND_BYTECODE_STORE = 0x41
+COMMAND_BYTECODE_INFO = 0x42
+
+STATUS_BUSY = 6
+
+STATUS = ['ok', 'frame error', 'unknown command', 'invalid length', 'invalid id', 'out of range', 'busy']
+
+# Has to match E_PARAM_SELECT in param.h
+
+PARAMS = ['deadzone_us', 'center_us', 'min_pulse_width_us', 'max_pulse_width_us', 'frame_period_us', 'profile',
+          'host_timeout_ms', 'host_fallback']
+
+# Has to match E_LATENCY_PATH in latency.h
+
+LATENCY_PATHS = ['in_to_mix'] + ['in_to_out%d' % i for i in range(1, 7)]
+
+# Has to match E_RESET_CAUSE in watchdog.h
+
+RESET_CAUSES = ['power-on', 'external', 'brown-out', 'watchdog', 'bad interrupt', 'unknown']
+
+# Has to match E_EVENT_TYPE in eventlog.h
+
+EVENT_TYPES = ['boot', 'input lost', 'input good', 'pulses rejected', 'failsafe entered', 'failsafe exited',
+               'events dropped']
+
+# Has to match E_BYTECODE_RESULT in control_bytecode.h
+
+BYTECODE_RESULTS = ['ok', 'invalid header', 'unknown opcode', 'invalid operand', 'invalid jump', 'stack error',
+                    'unreachable code', 'too many cycles', 'busy']
+
+# Code bytes per BYTECODE_WRITE request (MAX_BYTECODE_CHUNK_SIZE in command.cpp)
+
+BYTECODE_CHUNK_SIZE = 32
+
+TIMEOUT_S = 1.0
+
+
+def cobs_encode(data):
+    frame = bytearray()
+    block = bytearray()
+    for byte in data:
+        if byte == 0:
+            frame.append(len(block) + 1)
+            frame += block
+            block = bytearray()
+        else:
+            block.append(byte)
+            if len(block) == 0xFE:
+                frame.append(0xFF)
+                frame += block
+                block = bytearray()
+    frame.append(len(block) + 1)
+    frame += block
+    frame.append(0)
+    return bytes(frame)
+
+
+def checksum(data):
+    return (-sum(data)) & 0xFF
+
+
+class BusyError(RuntimeError):
+    pass
+
+
+class Device(object):
+
+    def __init__(self, path):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        tty.setraw(self.fd)
+        attributes = termios.tcgetattr(self.fd)
+        attributes[6][termios.VMIN] = 0
+        attributes[6][termios.VTIME] = 1
+        termios.tcsetattr(self.fd, termios.TCSANOW, attributes)
+        self.stream = os.fdopen(self.fd, 'r+b', buffering=0)
+        termios.tcflush(self.fd, termios.TCIFLUSH)
+
+    def request(self, command, args=b''):
+        """ Sends a request and returns the data of its response """
+        payload = bytes([command]) + args
+        self.stream.write(cobs_encode(payload + bytes([checksum(payload)])))
+        self.deadline = time.time() + TIMEOUT_S
+        for frame in frames(self):
+            if time.time() > self.deadline:
+                break
+            try:
+                response = cobs_decode(frame)
+            except ValueError:
+                continue
+            if len(response) < 4 or response[0] != RESPONSE_TYPE or sum(response) & 0xFF != 0:
+                continue
+            if response[2] == STATUS_BUSY:
+                raise BusyError('command 0x%02x: busy' % response[1])
+            if response[2] != 0:
+                raise RuntimeError('command 0x%02x: %s' % (response[1], STATUS[response[2]]
+                                   if response[2] < len(STATUS) else response[2]))
+            return response[3:-1]
+        raise RuntimeError('command 0x%02x: no response' % command)
+
+    def read(self, size):
+        """ Stream interface for frames(), which stops at the first empty read """
+        data = self.stream.read(size)
+        while not data and time.time() < self.deadline:
+            data = self.stream.read(size)
+        return data
+
+    def get(self, index):
+        data = self.request(COMMAND_PARAM_GET, bytes([index]))
+        return struct.unpack('<B4H', data)[1:]
+
+    def event(self, index):
+        """ Returns the number of entries of the event log and the entry at index (None if the log is empty) """
+        while True:
+            try:
+                data = self.request(COMMAND_EVENT_LOG_READ, bytes([index]))
+                break
+            except BusyError:
+                # The EEPROM is written, repeat the request
+                time.sleep(0.005)
+        if len(data) == 1:
+            return data[0], None
+        fields = struct.unpack('<4BI', data)
+        return fields[0], fields[1:]
+
+
+def describe_event(event_type, channel, value):
+    name = EVENT_TYPES[event_type] if event_type < len(EVENT_TYPES) else 'event %d' % event_type
+    if event_type == 0:
+        return '%s (%s)' % (name, RESET_CAUSES[value] if value < len(RESET_CAUSES) else 'cause unknown')
+    if event_type in (1, 2):
+        return '%s IN%d' % (name, channel + 1)
+    if event_type == 3:
+        return '%s IN%d: %d' % (name, channel + 1, value)
+    if event_type == 6:
+        return '%s: %d' % (name, value)
+    return name
+
+
+def describe_program(in_mask, out_mask, cycles):
+    return 'inputs %s, outputs %s, estimated %d cycles' % (
+        ' '.join('IN%d' % (i + 1) for i in range(4) if in_mask & (1 << i)) or '-',
+        ' '.join('OUT%d' % (i + 1) for i in range(6) if out_mask & (1 << i)) or '-', cycles)
+
+
+def upload(device, code):
+    """ Writes a mixing program to the device, which verifies it before it is stored in the EEPROM """
+    for offset in range(0, len(code), BYTECODE_CHUNK_SIZE):
+        device.request(COMMAND_BYTECODE_WRITE, bytes([offset]) + code[offset:offset + BYTECODE_CHUNK_SIZE])
+    result, in_mask, out_mask, cycles = struct.unpack('<3BH', device.request(COMMAND_BYTECODE_STORE, bytes([len(code)])))
+    if result != 0:
+        raise RuntimeError('program rejected: %s' % (BYTECODE_RESULTS[result] if result < len(BYTECODE_RESULTS) else result))
+    print('stored %d bytes, %s' % (len(code), describe_program(in_mask, out_mask, cycles)))
+    # Wait for the background write, a reset before its end leaves no valid program
+    while struct.unpack('<3BHB', device.request(COMMAND_BYTECODE_INFO))[-1]:
+        time.sleep(0.05)
+    print('active after the next reset')
+
+
+def param_index(name):
+    if name not in PARAMS:
+        raise SystemExit('unknown parameter %s, known: %s' % (name, ', '.join(PARAMS)))
+    return PARAMS.index(name)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('port', help='serial port (e.g. /dev/ttyACM0)')
+    parser.add_argument('command', choices=['list', 'get', 'set', 'save', 'defaults', 'boot', 'latency', 'reset', 'events',
+                                            'diversity', 'upload', 'program'])
+    parser.add_argument('name', nargs='?')
+    parser.add_argument('value', nargs='?', type=int)
+    args = parser.parse_args()
+
+    device = Device(args.port)
+
+    try:
+        if args.command == 'list':
+            version, num_params, is_saving = struct.unpack('<BBB', device.request(COMMAND_PARAM_INFO))
+            print('layout version %d, %d parameters%s' % (version, num_params, ', saving' if is_saving else ''))
+            for index in range(num_params):
+                value, min_value, max_value, default = device.get(index)
+                name = PARAMS[index] if index < len(PARAMS) else 'param_%d' % index
+                print('%-20s %5d  (%d ... %d, default %d)' % (name, value, min_value, max_value, default))
+        elif args.command == 'get':
+            print(device.get(param_index(args.name))[0])
+        elif args.command == 'set':
+            if args.value is None:
+                parser.error('set requires a name and a value')
+            device.request(COMMAND_PARAM_SET, struct.pack('<BH', param_index(args.name), args.value))
+        elif args.command == 'save':
+            device.request(COMMAND_PARAM_SAVE)
+        elif args.command == 'defaults':
+            device.request(COMMAND_PARAM_DEFAULTS)
+        elif args.command == 'boot':
+            for name, time_us in zip(['first pulse', 'mixing'], struct.unpack('<II', device.request(COMMAND_BOOT_INFO))):
+                print('%-12s %s' % (name, '%.3f ms' % (time_us / 1000.0) if time_us else '-'))
+        elif args.command == 'latency':
+            if args.name == 'reset':
+                device.request(COMMAND_LATENCY_RESET)
+                return 0
+            for index, name in enumerate(LATENCY_PATHS):
+                fields = struct.unpack('<B5H', device.request(COMMAND_LATENCY_GET, bytes([index])))
+                print('%-12s %5d samples  min %5d us  avg %5d us  max %5d us  p99 %5d us' % ((name,) + fields[1:]))
+            num_samples, min_ns, avg_ns, max_ns = struct.unpack('<4H', device.request(COMMAND_LATENCY_ISR))
+            print('%-12s %5d samples  min %5.1f us  avg %5.1f us  max %5.1f us  jitter %5.1f us' % (
+                'output isr', num_samples, min_ns / 1000.0, avg_ns / 1000.0, max_ns / 1000.0, (max_ns - min_ns) / 1000.0))
+        elif args.command == 'reset':
+            fields = struct.unpack('<BB%dH' % len(RESET_CAUSES), device.request(COMMAND_RESET_INFO))
+            print('last reset: %s (%s before)' % (RESET_CAUSES[fields[0]], 'mixing' if fields[1] else 'failsafe'))
+            for name, count in zip(RESET_CAUSES, fields[2:]):
+                print('%-14s %5d' % (name, count))
+        elif args.command == 'events':
+            num_entries, entry = device.event(0)
+            for index in range(num_entries):
+                if index > 0:
+                    entry = device.event(index)[1]
+                event_type, channel, value, time_ms = entry
+                print('%3d %10.2f s  %s' % (index, time_ms / 1000.0, describe_event(event_type, channel, value)))
+        elif args.command == 'diversity':
+            selected, good_a, quality_a, good_b, quality_b, num_switches = struct.unpack(
+                '<5BH', device.request(COMMAND_DIVERSITY_INFO))
+            for name, good, quality in [('A', good_a, quality_a), ('B', good_b, quality_b)]:
+                print('receiver %s%s  %-4s quality %2d' % (name, '*' if 'AB'[selected] == name else ' ',
+                                                            'good' if good else 'lost', quality))
+            print('%d switches' % num_switches)
+        elif args.command == 'upload':
+            if args.name is None:
+                parser.error('upload requires a program file')
+            try:
+                code = mixasm.assemble(open(args.name).read())
+                mixasm.verify(code)
+            except mixasm.AsmError as error:
+                print('%s: %s' % (args.name, error), file=sys.stderr)
+                return 1
+            upload(device, code)
+        elif args.command == 'program':
+            is_loaded, in_mask, out_mask, cycles, is_storing = struct.unpack(
+                '<3BHB', device.request(COMMAND_BYTECODE_INFO))
+            print(describe_program(in_mask, out_mask, cycles) if is_loaded else 'no valid program loaded')
+            if is_storing:
+                print('a new program is written to the EEPROM')
+    except RuntimeError as error:
+        print(error, file=sys.stderr)
+        return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+#
+# MIT License
+#
+# Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+"""
+Decoder for the USB CDC telemetry stream of the rc mixer
+(software/rcmixarduino/telemetry.h).
+
+  telemetry.py /dev/ttyACM0          - print every record
+  telemetry.py /dev/ttyACM0 --csv    - print every record as CSV
+  telemetry.py dump.bin              - decode a recorded stream
+
+The serial port is switched to raw mode, no additional python packages
+are required.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import termios
+import tty
+
+RECORD_TYPE_FRAME = 0x01
+
+# type, seq, flags, tick, IN1..IN4, OUT1..OUT6, mix exec time, duty, checksum
+
+RECORD_FORMAT = '<BBBH4H6HHHB'
+RECORD_SIZE = struct.calcsize(RECORD_FORMAT)
+
+FLAG_IS_MIXING = 0x80
+
+
+def cobs_decode(frame):
+    data = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame):
+            raise ValueError('invalid COBS frame')
+        data += frame[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(frame):
+            data.append(0)
+    return bytes(data)
+
+
+def frames(stream):
+    """ Yields the COBS frames of a stream (without the 0x00 delimiter) """
+    buffer = bytearray()
+    while True:
+        chunk = stream.read(64)
+        if not chunk:
+            return
+        buffer += chunk
+        while 0 in buffer:
+            end = buffer.index(0)
+            if end > 0:
+                yield bytes(buffer[:end])
+            del buffer[:end + 1]
+
+
+def open_stream(path):
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    if os.isatty(fd):
+        tty.setraw(fd)
+        attributes = termios.tcgetattr(fd)
+        attributes[6][termios.VMIN] = 1
+        attributes[6][termios.VTIME] = 0
+        termios.tcsetattr(fd, termios.TCSANOW, attributes)
+    return os.fdopen(fd, 'rb', buffering=0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('port', help='serial port (e.g. /dev/ttyACM0) or file')
+    parser.add_argument('--csv', action='store_true', help='print records as CSV')
+    args = parser.parse_args()
+
+    if args.csv:
+        print('seq,tick_ms,mixing,' + ','.join('in%d_good,in%d_us' % (i, i) for i in range(1, 5)) + ','
+              + ','.join('out%d_us' % i for i in range(1, 7)) + ',mix_exec_time_us,active_duty_permille')
+
+    expected_seq = None
+    num_records = 0
+    num_lost = 0
+    num_errors = 0
+
+    try:
+        for frame in frames(open_stream(args.port)):
+            try:
+                record = cobs_decode(frame)
+            except ValueError:
+                num_errors += 1
+                continue
+            if len(record) != RECORD_SIZE or sum(record) & 0xFF != 0 or record[0] != RECORD_TYPE_FRAME:
+                num_errors += 1
+                continue
+
+            fields = struct.unpack(RECORD_FORMAT, record)
+            seq, flags, tick = fields[1], fields[2], fields[3]
+            inputs = fields[4:8]
+            outputs = fields[8:14]
+            mix_exec_time_us, duty = fields[14], fields[15]
+
+            if expected_seq is not None and seq != expected_seq:
+                num_lost += (seq - expected_seq) & 0xFF
+            expected_seq = (seq + 1) & 0xFF
+            num_records += 1
+
+            good = [bool(flags & (1 << i)) for i in range(4)]
+            mixing = bool(flags & FLAG_IS_MIXING)
+
+            if args.csv:
+                print('%d,%d,%d,' % (seq, tick, mixing)
+                      + ','.join('%d,%d' % (g, v) for g, v in zip(good, inputs)) + ','
+                      + ','.join('%d' % v for v in outputs) + ',%d,%d' % (mix_exec_time_us, duty))
+            else:
+                print('#%3d %5d ms %-8s IN %s  OUT %s  mix %4d us  active %5.1f %%' % (
+                    seq, tick, 'MIXING' if mixing else 'FAILSAFE',
+                    ' '.join('%4d%s' % (v, ' ' if g else '!') for g, v in zip(good, inputs)),
+                    ' '.join('%4d' % v for v in outputs),
+                    mix_exec_time_us, duty / 10.0))
+    except KeyboardInterrupt:
+        pass
+
+    print('%d records, %d lost, %d invalid' % (num_records, num_lost, num_errors), file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
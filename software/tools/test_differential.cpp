@@ -0,0 +1,206 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Host test of ControlDifferential over the full input grid (900 ... 2100 us
+ * on IN1 and IN2), built against the firmware sources:
+ *
+ *   g++ -std=gnu++11 -DCONFIG_USE_CONTROL_DIFFERENTIAL -I../rcmixarduino \
+ *       test_differential.cpp ../rcmixarduino/control_differential.cpp -o test_differential
+ *   ./test_differential
+ *
+ * Checked for every pair of inputs:
+ *
+ *   - both tracks stay within their speed limit
+ *   - mirrored steering results in swapped tracks
+ *   - the tracks counter-rotate at neutral throttle
+ *   - the tracks run equally with the steering in neutral
+ *   - the tracks change continuously with the throttle, in particular when
+ *     the throttle leaves neutral during a pivot turn
+ *
+ * Exits with 0 if all checks pass.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "control_differential.h"
+#include "rcin.h"
+#include "rcout.h"
+
+#if defined(CONFIG_USE_CURVE)
+#include "curve.h"
+#endif
+
+/************************************************************************/
+/* STUBS                                                                */
+/************************************************************************/
+
+static uint16_t InputPulseDurationUs[4];
+static uint16_t OutputPulseDurationUs[6];
+
+bool RcIn::isGood(E_RC_IN_SELECT const)
+{
+  return true;
+}
+
+uint16_t RcIn::getPulseDurationUs(E_RC_IN_SELECT const sel)
+{
+  return InputPulseDurationUs[sel];
+}
+
+#if defined(CONFIG_USE_CURVE)
+/* Without curves configured the curve engine passes the inputs through */
+
+uint16_t Curve::getPulseDurationUs(E_RC_IN_SELECT const sel)
+{
+  return InputPulseDurationUs[sel];
+}
+#endif
+
+void RcOut::setPwmPulseDurationUs(E_RC_OUT_SELECT const sel, uint16_t const pulse_duration_us)
+{
+  OutputPulseDurationUs[sel] = pulse_duration_us;
+}
+
+void RcOut::setRcOutState(E_RC_OUT_SELECT const, E_RC_OUT_STATE const)
+{
+}
+
+/************************************************************************/
+/* TEST                                                                 */
+/************************************************************************/
+
+static int const MIN_INPUT_US = 900;
+static int const MAX_INPUT_US = 2100;
+
+#if defined(CONFIG_USE_CURVE)
+static int const DEADZONE_US = 0;
+#else
+static int const DEADZONE_US = ControlDifferential::DEADZONE_US;
+#endif
+
+/* A change of the throttle by d changes a track by at most d plus the
+ * change of the steering gain, 500 * (256 - PIVOT_TURN_GAIN) / 256 over
+ * PIVOT_BLEND_THROTTLE, plus rounding
+ */
+
+static double const MAX_TRACK_CHANGE_PER_THROTTLE_US = 1.0
+    + 500.0 * (256 - ControlDifferential::PIVOT_TURN_GAIN) / 256.0 / ControlDifferential::PIVOT_BLEND_THROTTLE;
+static int const MAX_ROUNDING_US = 2;
+
+static unsigned long NumFailures = 0;
+
+/**
+ * \brief throttle or steering as seen by the mixer (see ControlDifferential::getStickPosition)
+ */
+static int getStickPosition(int const pulse_duration_us)
+{
+  int const position = pulse_duration_us - 1500;
+
+  if (abs(position) <= DEADZONE_US)
+  {
+    return 0;
+  }
+
+  return (position > 500) ? 500 : ((position < -500) ? -500 : position);
+}
+
+/**
+ * \brief execute the mixer, returns the speed of the left and the right track
+ */
+static void mix(int const throttle_us, int const steering_us, int & left, int & right)
+{
+  InputPulseDurationUs[IN1] = throttle_us;
+  InputPulseDurationUs[IN2] = steering_us;
+
+  ControlDifferential::mixingFunc();
+
+  left = (int) (OutputPulseDurationUs[OUT1]) - 1500;
+  right = (int) (OutputPulseDurationUs[OUT2]) - 1500;
+}
+
+static void fail(char const * check, int const throttle_us, int const steering_us, int const left, int const right)
+{
+  if (NumFailures++ < 10)
+  {
+    printf("FAIL %s: IN1 = %d us, IN2 = %d us -> left %d, right %d\n", check, throttle_us, steering_us, left, right);
+  }
+}
+
+int main()
+{
+  unsigned long num_cases = 0;
+
+  for (int throttle_us = MIN_INPUT_US; throttle_us <= MAX_INPUT_US; throttle_us++)
+  {
+    for (int steering_us = MIN_INPUT_US; steering_us <= MAX_INPUT_US; steering_us++)
+    {
+      int left, right;
+      mix(throttle_us, steering_us, left, right);
+      num_cases++;
+
+      if (abs(left) > ControlDifferential::MAX_LEFT_TRACK_SPEED || abs(right) > ControlDifferential::MAX_RIGHT_TRACK_SPEED)
+      {
+        fail("speed limit", throttle_us, steering_us, left, right);
+      }
+
+      int mirrored_left, mirrored_right;
+      mix(throttle_us, 3000 - steering_us, mirrored_left, mirrored_right);
+
+      if (ControlDifferential::MAX_LEFT_TRACK_SPEED == ControlDifferential::MAX_RIGHT_TRACK_SPEED
+          && (mirrored_left != right || mirrored_right != left))
+      {
+        fail("mirrored steering", throttle_us, steering_us, left, right);
+      }
+
+      if (getStickPosition(throttle_us) == 0 && left != -right)
+      {
+        fail("counter-rotation at neutral throttle", throttle_us, steering_us, left, right);
+      }
+
+      if (getStickPosition(steering_us) == 0 && left != right)
+      {
+        fail("equal tracks at neutral steering", throttle_us, steering_us, left, right);
+      }
+
+      if (throttle_us < MAX_INPUT_US)
+      {
+        int next_left, next_right;
+        mix(throttle_us + 1, steering_us, next_left, next_right);
+
+        double const throttle_change = abs(getStickPosition(throttle_us + 1) - getStickPosition(throttle_us));
+        double const max_change = throttle_change * MAX_TRACK_CHANGE_PER_THROTTLE_US + MAX_ROUNDING_US;
+
+        if (abs(next_left - left) > max_change || abs(next_right - right) > max_change)
+        {
+          fail("continuity over the throttle", throttle_us, steering_us, next_left - left, next_right - right);
+        }
+      }
+    }
+  }
+
+  printf("%lu cases, %lu failures\n", num_cases, NumFailures);
+
+  return (NumFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2016 LXRobotics GmbH / Alexander Entinger, MSc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/* Host test of ControlOmnidrive3WheelsDsl against ControlOmnidrive3Wheels
+ * (without curves, with ControlOmnidrive3Wheels configured in config.h),
+ * built against the firmware sources:
+ *
+ *   g++ -std=gnu++11 -DCONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS_DSL -I../rcmixarduino test_omnidrive_dsl.cpp \
+ *       ../rcmixarduino/control_omnidrive_3_wheels.cpp \
+ *       ../rcmixarduino/control_omnidrive_3_wheels_dsl.cpp -o test_omnidrive_dsl
+ *   ./test_omnidrive_dsl
+ *
+ * Checked for every pair of IN1 and IN2 (800 ... 2200 us) with IN3 in
+ * neutral and deflected, and for every IN3 with IN1 and IN2 around the
+ * deadzone:
+ *
+ *   - both mixers move, rotate or stop for the same inputs (exact match
+ *     while rotating or stopped)
+ *   - while moving the outputs differ by at most MAX_DEVIATION_US, the
+ *     DSL uses 8.8 fixed point gains instead of float
+ *
+ * Exits with 0 if all checks pass.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "control_omnidrive_3_wheels.h"
+#include "control_omnidrive_3_wheels_dsl.h"
+#include "rcin.h"
+#include "rcout.h"
+
+#if !defined(CONFIG_USE_CONTROL_OMNIDRIVE_3_WHEELS) || defined(CONFIG_USE_CURVE)
+#error "the DSL mixer is compared with ControlOmnidrive3Wheels without curves"
+#endif
+
+/************************************************************************/
+/* STUBS                                                                */
+/************************************************************************/
+
+static uint16_t InputPulseDurationUs[4];
+static uint16_t OutputPulseDurationUs[6];
+
+bool RcIn::isGood(E_RC_IN_SELECT const)
+{
+  return true;
+}
+
+uint16_t RcIn::getPulseDurationUs(E_RC_IN_SELECT const sel)
+{
+  return InputPulseDurationUs[sel];
+}
+
+void RcOut::setPwmPulseDurationUs(E_RC_OUT_SELECT const sel, uint16_t const pulse_duration_us)
+{
+  OutputPulseDurationUs[sel] = pulse_duration_us;
+}
+
+void RcOut::setRcOutState(E_RC_OUT_SELECT const, E_RC_OUT_STATE const)
+{
+}
+
+/************************************************************************/
+/* TEST                                                                 */
+/************************************************************************/
+
+static int const MIN_INPUT_US = 800;
+static int const MAX_INPUT_US = 2200;
+
+/* The gains 2/3, 1/3 and 1/sqrt(3) are off by at most 1/512 in 8.8 fixed
+ * point (0.7 us per term at 700 us), plus the rounding of both mixers
+ */
+
+static int const MAX_DEVIATION_US = 4;
+
+static int const DEADZONE_US = ControlOmnidrive3Wheels::DEADZONE_US;
+
+static unsigned long NumCases = 0;
+static unsigned long NumFailures = 0;
+static int MaxDeviationUs = 0;
+
+static void fail(char const * check, int const out, int const native_us, int const dsl_us)
+{
+  if (NumFailures++ < 10)
+  {
+    printf("FAIL %s: IN1 = %u us, IN2 = %u us, IN3 = %u us -> OUT%d native %d us, dsl %d us\n", check,
+        InputPulseDurationUs[IN1], InputPulseDurationUs[IN2], InputPulseDurationUs[IN3], out, native_us, dsl_us);
+  }
+}
+
+/**
+ * \brief execute both mixers for the given inputs and compare their outputs
+ */
+static void check(int const fwd_bwd_us, int const left_right_us, int const rotate_us)
+{
+  InputPulseDurationUs[IN1] = fwd_bwd_us;
+  InputPulseDurationUs[IN2] = left_right_us;
+  InputPulseDurationUs[IN3] = rotate_us;
+
+  ControlOmnidrive3Wheels::mixingFunc();
+  int const native_us[3] = { OutputPulseDurationUs[OUT1], OutputPulseDurationUs[OUT2], OutputPulseDurationUs[OUT3] };
+
+  ControlOmnidrive3WheelsDsl::mixingFunc();
+  int const dsl_us[3] = { OutputPulseDurationUs[OUT1], OutputPulseDurationUs[OUT2], OutputPulseDurationUs[OUT3] };
+
+  bool const do_move = abs(fwd_bwd_us - 1500) > DEADZONE_US || abs(left_right_us - 1500) > DEADZONE_US;
+
+  NumCases++;
+
+  for (int i = 0; i < 3; i++)
+  {
+    int const deviation = abs(native_us[i] - dsl_us[i]);
+
+    if (!do_move && deviation != 0)
+    {
+      fail("rotate / stop", i + 1, native_us[i], dsl_us[i]);
+    }
+    else if (deviation > MAX_DEVIATION_US)
+    {
+      fail("move", i + 1, native_us[i], dsl_us[i]);
+    }
+
+    if (deviation > MaxDeviationUs)
+    {
+      MaxDeviationUs = deviation;
+    }
+  }
+}
+
+int main()
+{
+  for (int fwd_bwd_us = MIN_INPUT_US; fwd_bwd_us <= MAX_INPUT_US; fwd_bwd_us++)
+  {
+    for (int left_right_us = MIN_INPUT_US; left_right_us <= MAX_INPUT_US; left_right_us++)
+    {
+      check(fwd_bwd_us, left_right_us, 1500);
+      check(fwd_bwd_us, left_right_us, 1900);
+    }
+  }
+
+  for (int fwd_bwd_us = 1500 - 2 * DEADZONE_US; fwd_bwd_us <= 1500 + 2 * DEADZONE_US; fwd_bwd_us++)
+  {
+    for (int left_right_us = 1500 - 2 * DEADZONE_US; left_right_us <= 1500 + 2 * DEADZONE_US; left_right_us++)
+    {
+      for (int rotate_us = MIN_INPUT_US; rotate_us <= MAX_INPUT_US; rotate_us++)
+      {
+        check(fwd_bwd_us, left_right_us, rotate_us);
+      }
+    }
+  }
+
+  printf("%lu cases, %lu failures, max deviation %d us\n", NumCases, NumFailures, MaxDeviationUs);
+
+  return (NumFailures == 0) ? 0 : 1;
+}